@@ -386,7 +386,7 @@ void *CommUnit_routine()
                     if(uptime - current_node->uptime_at_receive > 
                        common_config.min_age_out_of_date_packet_in_sec){
 
-                       mp_free(&node_mempool, current_node);
+                       release_buffer_node(current_node);
                        continue;
                     } 
                     /* Have a worker thread execute the function specified by the 
@@ -624,6 +624,18 @@ int get_clock_time()
 #endif
 }
 
+unsigned int get_clock_time_in_ms()
+{
+#ifdef _WIN32
+    return GetTickCount();
+#elif __unix__
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (unsigned int)current_time.tv_sec * 1000 + 
+           current_time.tv_nsec / 1000000;
+#endif
+}
+
 
 char *strtok_save(char *str, char *delim, char **saveptr)
 {
@@ -681,4 +693,203 @@ void sleep_t(int wait_time)
 #endif
 }
 
+void log_mempool_statistics(Memory_Pool *mp)
+{
+    MemoryPoolStatistics stats;
+
+    mp_get_statistics(mp, &stats);
+
+    zlog_info(category_debug, 
+              "[Mempool] %s: used_slots=[%d], peak_used_slots=[%d], " \
+              "total_slots=[%d], expand_times=[%d], failed_allocs=[%d], " \
+              "allocs_per_sec=[%.1f], frees_per_sec=[%.1f]",
+              mp->name,
+              stats.used_slots,
+              stats.peak_used_slots,
+              stats.total_slots,
+              stats.expand_times,
+              stats.failed_allocs,
+              stats.allocs_per_sec,
+              stats.frees_per_sec);
+}
+
+static int get_buffer_node_payload_size(int content_class)
+{
+    switch(content_class){
+        case 0:
+            return SIZE_OF_SMALL_BUFFER_NODE_PAYLOAD;
+        case 1:
+            return SIZE_OF_MEDIUM_BUFFER_NODE_PAYLOAD;
+        default:
+            return SIZE_OF_LARGE_BUFFER_NODE_PAYLOAD;
+    }
+}
+
+static int get_buffer_node_payload_class(int content_size)
+{
+    int content_class;
+
+    /* Reserve one byte for the terminating null character, since the 
+       content is handled as a string by the packet handlers */
+    for(content_class = 0; 
+        content_class < NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES; 
+        content_class++){
+
+        if(content_size < get_buffer_node_payload_size(content_class))
+            return content_class;
+    }
+
+    return -1;
+}
+
+ErrorCode init_buffer_node_mempools(int slots)
+{
+    int content_class;
+    int slots_in_class;
+    char name[LENGTH_OF_MEMORY_POOL_NAME];
+
+    if(MEMORY_POOL_SUCCESS != mp_init(&node_mempool, 
+                                      sizeof(BufferNode), 
+                                      slots))
+    {
+        return E_MALLOC;
+    }
+    mp_set_name(&node_mempool, "node_mempool");
+
+    /* Most packets are small, so the larger classes start with fewer slots 
+       and rely on the memory pool to expand under load */
+    slots_in_class = slots;
+
+    for(content_class = 0; 
+        content_class < NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES; 
+        content_class++){
+
+        if(MEMORY_POOL_SUCCESS != 
+           mp_init(&node_payload_mempool[content_class],
+                   get_buffer_node_payload_size(content_class),
+                   slots_in_class))
+        {
+            return E_MALLOC;
+        }
+
+        sprintf(name, "node_payload_mempool_%d", 
+                get_buffer_node_payload_size(content_class));
+        mp_set_name(&node_payload_mempool[content_class], name);
+
+        slots_in_class = slots_in_class / 4;
+        if(slots_in_class < 1)
+            slots_in_class = 1;
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+void destroy_buffer_node_mempools()
+{
+    int content_class;
+
+    for(content_class = 0; 
+        content_class < NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES; 
+        content_class++){
+
+        mp_destroy(&node_payload_mempool[content_class]);
+    }
 
+    mp_destroy(&node_mempool);
+}
+
+BufferNode *allocate_buffer_node(int content_size)
+{
+    BufferNode *node = NULL;
+    int content_class;
+
+    content_class = get_buffer_node_payload_class(content_size);
+    if(content_class < 0)
+        return NULL;
+
+    node = mp_alloc(&node_mempool);
+    if(node == NULL)
+        return NULL;
+
+    memset(node, 0, sizeof(BufferNode));
+
+    node->content = mp_alloc(&node_payload_mempool[content_class]);
+    if(node->content == NULL){
+        mp_free(&node_mempool, node);
+        return NULL;
+    }
+
+    node->content_class = content_class;
+    node->content_capacity = get_buffer_node_payload_size(content_class);
+    memset(node->content, 0, node->content_capacity);
+
+    /* Initialize the entry of the buffer node */
+    init_entry(&node->buffer_entry);
+
+    return node;
+}
+
+ErrorCode set_buffer_node_content(BufferNode *node, 
+                                  char *content, 
+                                  int content_size)
+{
+    int content_class;
+    char *new_content = NULL;
+
+    if(content_size >= node->content_capacity){
+
+        content_class = get_buffer_node_payload_class(content_size);
+        if(content_class < 0)
+            return E_MALLOC;
+
+        new_content = mp_alloc(&node_payload_mempool[content_class]);
+        if(new_content == NULL)
+            return E_MALLOC;
+
+        /* The input content may be the current payload storage, so copy it 
+           before the current payload is returned to its pool */
+        memcpy(new_content, content, content_size);
+
+        if(node->content != NULL){
+            mp_free(&node_payload_mempool[node->content_class], 
+                    node->content);
+        }
+
+        node->content = new_content;
+        node->content_class = content_class;
+        node->content_capacity = get_buffer_node_payload_size(content_class);
+    }else{
+
+        /* The input content may overlap the current payload storage */
+        memmove(node->content, content, content_size);
+    }
+
+    node->content[content_size] = '\0';
+    node->content_size = content_size;
+
+    return WORK_SUCCESSFULLY;
+}
+
+void release_buffer_node(BufferNode *node)
+{
+    if(node->content != NULL){
+        mp_free(&node_payload_mempool[node->content_class], node->content);
+        node->content = NULL;
+    }
+
+    mp_free(&node_mempool, node);
+}
+
+void report_buffer_node_mempool_statistics()
+{
+    int content_class;
+
+    log_mempool_statistics(&node_mempool);
+
+    for(content_class = 0; 
+        content_class < NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES; 
+        content_class++){
+
+        log_mempool_statistics(&node_payload_mempool[content_class]);
+    }
+}
@@ -90,6 +90,26 @@
 #include "thpool.h"
 #include "zlog.h"
 
+/* Atomic operations used by the data structures read without locks. The 
+   increment and decrement operations return the new value, the or and 
+   exchange operations return the old value, and all of them are full memory
+   barriers. */
+#ifdef _WIN32
+   #define atomic_increment(ptr) InterlockedIncrement((volatile LONG *)(ptr))
+   #define atomic_decrement(ptr) InterlockedDecrement((volatile LONG *)(ptr))
+   #define atomic_or(ptr, value) InterlockedOr((volatile LONG *)(ptr), (value))
+   #define atomic_exchange(ptr, value) \
+       InterlockedExchange((volatile LONG *)(ptr), (value))
+   #define memory_barrier() MemoryBarrier()
+#else
+   #define atomic_increment(ptr) __sync_add_and_fetch((ptr), 1)
+   #define atomic_decrement(ptr) __sync_sub_and_fetch((ptr), 1)
+   #define atomic_or(ptr, value) __sync_fetch_and_or((ptr), (value))
+   #define atomic_exchange(ptr, value) \
+       __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+   #define memory_barrier() __sync_synchronize()
+#endif
+
 
 /* Gateway API protocol version for communicate between gateway and Lbeacon. */
 
@@ -193,6 +213,15 @@
 /* Number of charactures in the time format of %Y-%m-%d %H:%M:%S */
 #define LENGTH_OF_TIME_FORMAT 80
 
+/* Number of size classes of the payload storage of buffer nodes */
+#define NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES 3
+
+/* Number of bytes in the payload storage of each size class. The largest
+class must be able to hold a whole Wi-Fi message. */
+#define SIZE_OF_SMALL_BUFFER_NODE_PAYLOAD 256
+#define SIZE_OF_MEDIUM_BUFFER_NODE_PAYLOAD 1024
+#define SIZE_OF_LARGE_BUFFER_NODE_PAYLOAD WIFI_MESSAGE_LENGTH
+
 typedef enum _ErrorCode{
 
     WORK_SUCCESSFULLY = 0,
@@ -311,12 +340,20 @@ typedef struct {
     /* The port from which the packet was received or to be sent */
     unsigned int port;
 
-    /* The pointer points to the content. */
-    char content[WIFI_MESSAGE_LENGTH];
+    /* The pointer points to the content. The storage is taken from the 
+       payload memory pool of the size class given by content_class. */
+    char *content;
 
     /* The size of the content */
     int content_size;
 
+    /* The number of bytes the content storage can hold, including the 
+       terminating null character */
+    int content_capacity;
+
+    /* The index of the payload memory pool the content is taken from */
+    int content_class;
+
     /* The uptime at which this buffer is recevied */
     int uptime_at_receive;
 
@@ -401,13 +438,6 @@ typedef struct {
 
 } CommonConfig;
 
-typedef struct {
-
-    int start_area_index;
-    int number_areas;
-
-} AreaSet;
-
 
 /* Global variables */
 
@@ -420,6 +450,10 @@ sudp_config udp_config;
 /* The mempool for the buffer node structure to allocate memory */
 Memory_Pool node_mempool;
 
+/* The mempools for the payload storage of buffer nodes, one for each size 
+   class */
+Memory_Pool node_payload_mempool[NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES];
+
 /* The head of a list of buffers of data for tracked object data and 
    health report */
 BufferListHead data_receive_buffer_list_head;
@@ -826,6 +860,22 @@ int extern get_system_time();
 */
 int extern get_clock_time();
 
+/*
+  get_clock_time_in_ms:
+
+     This helper function gets the monotonic time in milliseconds. The value
+     wraps around every 49.7 days, so only differences of values are used.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     unsigned int - uptime of MONOTONIC time in milliseconds
+*/
+unsigned int extern get_clock_time_in_ms();
+
 /*
   display_time:
 
@@ -858,5 +908,124 @@ int display_time(void);
 */
 void sleep_t(int wait_time);
 
+/*
+  log_mempool_statistics:
+
+     This function takes a snapshot of the usage statistics of the input memory
+     pool and writes it to the debug log.
+
+  Parameters:
+
+     mp - the pointer to the specific memory pool
+
+  Return value:
+
+     None
+*/
+void log_mempool_statistics(Memory_Pool *mp);
+
+/*
+  init_buffer_node_mempools:
+
+     This function initializes the memory pool of buffer nodes and the memory
+     pools of the payload storage of every size class.
+
+  Parameters:
+
+     slots - the number of slots in each memory pool
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY or E_MALLOC
+*/
+ErrorCode init_buffer_node_mempools(int slots);
+
+/*
+  destroy_buffer_node_mempools:
+
+     This function releases the memory pool of buffer nodes and the memory 
+     pools of the payload storage.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     None
+*/
+void destroy_buffer_node_mempools();
+
+/*
+  allocate_buffer_node:
+
+     This function allocates a buffer node and payload storage from the 
+     smallest size class able to hold content_size bytes of content. The 
+     buffer node is zeroed and its list entry is initialized.
+
+  Parameters:
+
+     content_size - the number of bytes of content the node is going to hold
+
+  Return value:
+
+     BufferNode * - the pointer to the buffer node, or NULL if the memory 
+                    cannot be allocated
+*/
+BufferNode *allocate_buffer_node(int content_size);
+
+/*
+  set_buffer_node_content:
+
+     This function copies the input content to the buffer node and updates 
+     content_size. If the current payload storage is too small, the payload 
+     is moved to storage of a larger size class.
+
+  Parameters:
+
+     node - the pointer to the buffer node
+     content - the content to be copied
+     content_size - the number of bytes in the content
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY or E_MALLOC
+*/
+ErrorCode set_buffer_node_content(BufferNode *node, 
+                                  char *content, 
+                                  int content_size);
+
+/*
+  release_buffer_node:
+
+     This function returns the payload storage and the buffer node to their
+     memory pools.
+
+  Parameters:
+
+     node - the pointer to the buffer node
+
+  Return value:
+
+     None
+*/
+void release_buffer_node(BufferNode *node);
+
+/*
+  report_buffer_node_mempool_statistics:
+
+     This function writes the usage statistics of the buffer node memory pool
+     and the payload memory pools to the debug log.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     None
+*/
+void report_buffer_node_mempool_statistics();
+
 
 #endif
\ No newline at end of file
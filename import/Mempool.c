@@ -46,6 +46,122 @@
 
 #include "Mempool.h"
 
+#ifdef MEMPOOL_DEBUG
+
+/* The offset in bytes from the start of a slot to the object in debug mode */
+#define MEMPOOL_DEBUG_OBJECT_OFFSET \
+    (((sizeof(Memory_Pool_Debug_Header) + MEMORY_ARENA_ALIGNMENT - 1) & \
+      ~(MEMORY_ARENA_ALIGNMENT - 1)) + MEMPOOL_DEBUG_REDZONE_SIZE)
+
+static void mp_report_violation(Memory_Pool *mp, 
+                                Memory_Pool_Debug_Header *header,
+                                const char *violation,
+                                const char *file,
+                                int line){
+
+    fprintf(stderr, 
+            "[Mempool] %s in pool [%s] at %s:%d, slot [%p] last used at " \
+            "%s:%d\n",
+            violation, 
+            mp->name,
+            file, 
+            line,
+            (void *)header,
+            header->file != NULL ? header->file : "(none)",
+            header->line);
+    fflush(stderr);
+
+    abort();
+}
+
+static int mp_check_pattern(unsigned char *mem, size_t size, int pattern){
+
+    size_t i;
+
+    for(i = 0; i < size; i++){
+        if(mem[i] != pattern)
+            return 0;
+    }
+
+    return 1;
+}
+
+static void mp_check_redzones(Memory_Pool *mp, 
+                              Memory_Pool_Debug_Header *header,
+                              const char *file,
+                              int line){
+
+    unsigned char *object = (unsigned char *)header + 
+                            MEMPOOL_DEBUG_OBJECT_OFFSET;
+    unsigned char *back_redzone = object + mp->object_size;
+    size_t back_redzone_size = (unsigned char *)header + mp->size - 
+                               back_redzone;
+
+    if(!mp_check_pattern(object - MEMPOOL_DEBUG_REDZONE_SIZE, 
+                         MEMPOOL_DEBUG_REDZONE_SIZE, 
+                         MEMPOOL_DEBUG_REDZONE_PATTERN))
+        mp_report_violation(mp, header, "buffer underflow", file, line);
+
+    if(!mp_check_pattern(back_redzone, 
+                         back_redzone_size, 
+                         MEMPOOL_DEBUG_REDZONE_PATTERN))
+        mp_report_violation(mp, header, "buffer overflow", file, line);
+}
+
+static void mp_poison_slot(Memory_Pool *mp, 
+                           Memory_Pool_Debug_Header *header,
+                           MemoryPoolSlotState state){
+
+    unsigned char *object = (unsigned char *)header + 
+                            MEMPOOL_DEBUG_OBJECT_OFFSET;
+
+    header->state = state;
+    header->object_size = mp->object_size;
+
+    memset(object - MEMPOOL_DEBUG_REDZONE_SIZE, 
+           MEMPOOL_DEBUG_REDZONE_PATTERN, 
+           MEMPOOL_DEBUG_REDZONE_SIZE);
+    memset(object, MEMPOOL_DEBUG_FREED_PATTERN, mp->object_size);
+    memset(object + mp->object_size, 
+           MEMPOOL_DEBUG_REDZONE_PATTERN,
+           (unsigned char *)header + mp->size - (object + mp->object_size));
+}
+
+/*
+Moves the oldest slot in quarantine to the free list after checking that it
+was not written after it was freed.
+*/
+
+static void mp_release_quarantined_slot(Memory_Pool *mp, 
+                                        const char *file, 
+                                        int line){
+
+    Memory_Pool_Debug_Header *released;
+    unsigned char *object;
+
+    released = (Memory_Pool_Debug_Header *)
+               mp->quarantine[mp->quarantine_head];
+
+    mp->quarantine_head = 
+        (mp->quarantine_head + 1) % MEMPOOL_DEBUG_QUARANTINE_SLOTS;
+    mp->quarantine_count --;
+
+    object = (unsigned char *)released + MEMPOOL_DEBUG_OBJECT_OFFSET;
+
+    if(!mp_check_pattern(object, 
+                         mp->object_size, 
+                         MEMPOOL_DEBUG_FREED_PATTERN))
+        mp_report_violation(mp, released, "write after free", file, line);
+
+    released->state = SLOT_STATE_FREE;
+    released->next_free = mp->head;
+    mp->head = (void **)released;
+
+    mp->blocks ++;
+}
+
+#endif
+
 
 size_t get_current_size_mempool(Memory_Pool *mp){
 
@@ -53,7 +169,7 @@ size_t get_current_size_mempool(Memory_Pool *mp){
 
     pthread_mutex_lock(&mp->mem_lock);
 
-    mem_size = mp->alloc_time * mp->size * mp->slots;
+    mem_size = (size_t)mp->total_slots * mp->size;
 
     pthread_mutex_unlock(&mp->mem_lock);
 
@@ -63,18 +179,50 @@ size_t get_current_size_mempool(Memory_Pool *mp){
 
 int mp_init(Memory_Pool *mp, size_t size, size_t slots){
 
-    char *end;
-    char *ite;
-    void *temp;
+    return mp_init_in_arena(mp, size, slots, NULL);
+}
+
+
+int mp_init_in_arena(Memory_Pool *mp, 
+                     size_t size, 
+                     size_t slots, 
+                     Memory_Arena *arena){
+
     int return_value;
 
+#ifdef MEMPOOL_DEBUG
+    /* Each slot holds the header, the object and the redzones, and is 
+       rounded up so that every object stays aligned */
+    mp->object_size = size;
+    mp->quarantine_head = 0;
+    mp->quarantine_count = 0;
+
+    size = MEMPOOL_DEBUG_OBJECT_OFFSET + size + MEMPOOL_DEBUG_REDZONE_SIZE;
+    size = (size + MEMORY_ARENA_ALIGNMENT - 1) & 
+           ~(MEMORY_ARENA_ALIGNMENT - 1);
+#endif
+
     /* initialize and set parameters */
     mp->head = NULL;
+    mp->arena = arena;
     mp->size = size;
     mp->slots = slots;
+    mp->total_slots = 0;
     mp->used_slots = 0;
     mp->alloc_time = 0;
     mp->blocks = 0;
+    memset(mp->memory, 0, sizeof(mp->memory));
+    memset(mp->memory_slots, 0, sizeof(mp->memory_slots));
+
+    memset(mp->name, 0, sizeof(mp->name));
+    mp->peak_used_slots = 0;
+    mp->expand_times = 0;
+    mp->failed_allocs = 0;
+    mp->total_allocs = 0;
+    mp->total_frees = 0;
+    mp->last_sampled_allocs = 0;
+    mp->last_sampled_frees = 0;
+    mp->last_sampled_time = time(NULL);
 
     pthread_mutex_init( &mp->mem_lock, 0);
 
@@ -102,13 +250,19 @@ int mp_expand(Memory_Pool *mp){
     if(alloc_count == MAX_EXP_TIME)
         return MEMORY_POOL_ERROR;
 
-    mp->memory[alloc_count] = malloc(mp->size * mp->slots);
+    if(mp->arena != NULL)
+        mp->memory[alloc_count] = ma_alloc(mp->arena, mp->size * mp->slots);
+    else
+        mp->memory[alloc_count] = malloc(mp->size * mp->slots);
     
     if(mp->memory[alloc_count] == NULL )
         return MEMORY_POOL_ERROR;
 
     memset(mp->memory[alloc_count], 0, mp->size * mp->slots);
 
+    mp->memory_slots[alloc_count] = mp->slots;
+    mp->total_slots += mp->slots;
+
     /* add every slot to the free list */
     end = (char *)mp->memory[alloc_count] + mp->size * mp->slots;
 
@@ -123,12 +277,28 @@ int mp_expand(Memory_Pool *mp){
         /* link to the list from new node */
         *mp->head = temp;
 
+#ifdef MEMPOOL_DEBUG
+        mp_poison_slot(mp, (Memory_Pool_Debug_Header *)ite, SLOT_STATE_FREE);
+#endif
+
         mp->blocks ++;
 
     }
 
+    /* the first block is allocated by mp_init and is not an expansion */
+    if(alloc_count > 0)
+        mp->expand_times ++;
+
     mp->alloc_time ++;
 
+    /* the memory of an arena is released only with the arena, so the pool 
+       grows in larger steps instead of expanding more times */
+    if(mp->arena != NULL && mp->slots < MAX_SLOTS_IN_ONE_ARENA_EXPANSION){
+        mp->slots = mp->slots * 2;
+        if(mp->slots > MAX_SLOTS_IN_ONE_ARENA_EXPANSION)
+            mp->slots = MAX_SLOTS_IN_ONE_ARENA_EXPANSION;
+    }
+
 #ifdef debugging
     zlog_info(category_debug, 
               "[Mempool] Current MemPool [%d]\n[Mempool] Remain blocks [%d]", 
@@ -145,15 +315,20 @@ void mp_destroy(Memory_Pool *mp){
 
     pthread_mutex_lock( &mp->mem_lock);
 
-    for(i = 0; i < MAX_EXP_TIME; i++){
+    for(i = 0; i < mp->alloc_time; i++){
+
+        /* the memory taken from an arena is released with the arena */
+        if(mp->arena == NULL)
+            free(mp->memory[i]);
 
         mp->memory[i] = NULL;
-        free(mp->memory[i]);
+        mp->memory_slots[i] = 0;
     }
 
     mp->head = NULL;
     mp->size = 0;
     mp->slots = 0;
+    mp->total_slots = 0;
     mp->alloc_time = 0;
     mp->blocks = 0;
 
@@ -170,6 +345,8 @@ void mp_destroy(Memory_Pool *mp){
 }
 
 
+#ifndef MEMPOOL_DEBUG
+
 void *mp_alloc(Memory_Pool *mp){
 
     void *temp;
@@ -186,6 +363,8 @@ void *mp_alloc(Memory_Pool *mp){
            expand the memory pool. */
         if(mp_expand(mp) == MEMORY_POOL_ERROR){
 
+            mp->failed_allocs ++;
+
             pthread_mutex_unlock(&mp->mem_lock);
             return NULL;
         }
@@ -200,6 +379,11 @@ void *mp_alloc(Memory_Pool *mp){
     // count the slots usage
     mp->used_slots = mp->used_slots + 1;
 
+    if(mp->used_slots > mp->peak_used_slots)
+        mp->peak_used_slots = mp->used_slots;
+
+    mp->total_allocs ++;
+
     mp->blocks --;
 
 #ifdef debugging
@@ -222,24 +406,28 @@ int mp_free(Memory_Pool *mp, void *mem){
 
     int closest = -1;
     int i;
-    int differenceinbyte;
+    size_t block_size;
     void *temp;
 
     pthread_mutex_lock(&mp->mem_lock);
 
-    /* Check all the expanded memory space, to find the closest and
-    most relevant mem_head for the current freeing memory. */
+    /* Check all the expanded memory space, to find the block containing the 
+    current freeing memory and the offset of the memory in the block. The 
+    offset is computed on char pointers so that it is not truncated on 
+    64-bit platforms. */
     for(i = 0; i < mp->alloc_time; i++){
 
-        /* Calculate the offset from mem to mp->memory */
-        differenceinbyte = (int)mem - (int)mp->memory[i];
-        /* Only consider the positive offset */
-        if((differenceinbyte > 0) && ((differenceinbyte < closest) ||
-           (closest == -1)))
-            closest = differenceinbyte;
+        block_size = (size_t)mp->size * mp->memory_slots[i];
+
+        if((char *)mem >= (char *)mp->memory[i] && 
+           (char *)mem < (char *)mp->memory[i] + block_size){
+
+            closest = (int)((char *)mem - (char *)mp->memory[i]);
+            break;
+        }
     }
     /* check if mem is correct, i.e. is pointing to the struct of a slot */
-    if((closest % mp->size) != 0){
+    if(closest < 0 || (closest % mp->size) != 0){
         pthread_mutex_unlock(&mp->mem_lock);
         return MEMORY_POOL_ERROR;
     }
@@ -262,17 +450,314 @@ int mp_free(Memory_Pool *mp, void *mem){
 #endif
     // count the slots usage
     mp->used_slots = mp->used_slots - 1;
+
+    mp->total_frees ++;
     
     pthread_mutex_unlock(&mp->mem_lock);
 
     return MEMORY_POOL_SUCCESS;
 }
 
+#else
+
+void *mp_alloc_debug(Memory_Pool *mp, const char *file, int line){
+
+    Memory_Pool_Debug_Header *header;
+    unsigned char *object;
+
+    pthread_mutex_lock(&mp->mem_lock);
+
+    /* The slots in quarantine are reused early rather than failing the
+       allocation when the pool cannot expand any more */
+    if(mp->head == NULL && mp_expand(mp) == MEMORY_POOL_ERROR){
+
+        if(mp->quarantine_count == 0){
+
+            mp->failed_allocs ++;
+
+            pthread_mutex_unlock(&mp->mem_lock);
+            return NULL;
+        }
+
+        mp_release_quarantined_slot(mp, file, line);
+    }
+
+    header = (Memory_Pool_Debug_Header *)mp->head;
+    mp->head = *mp->head;
+
+    object = (unsigned char *)header + MEMPOOL_DEBUG_OBJECT_OFFSET;
+
+    if(header->state != SLOT_STATE_FREE)
+        mp_report_violation(mp, header, "corrupted free list", file, line);
+
+    /* A write after free changes the poison pattern of the object */
+    if(!mp_check_pattern(object, mp->object_size, MEMPOOL_DEBUG_FREED_PATTERN))
+        mp_report_violation(mp, header, "write after free", file, line);
+
+    mp_check_redzones(mp, header, file, line);
+
+    header->next_free = NULL;
+    header->state = SLOT_STATE_ALLOCATED;
+    header->file = file;
+    header->line = line;
+
+    mp->used_slots = mp->used_slots + 1;
+
+    if(mp->used_slots > mp->peak_used_slots)
+        mp->peak_used_slots = mp->used_slots;
+
+    mp->total_allocs ++;
+
+    mp->blocks --;
+
+    memset(object, 0, mp->object_size);
+
+    pthread_mutex_unlock( &mp->mem_lock);
+
+    return object;
+}
+
+int mp_free_debug(Memory_Pool *mp, void *mem, const char *file, int line){
+
+    int closest = -1;
+    int i;
+    size_t block_size;
+    Memory_Pool_Debug_Header *header;
+
+    pthread_mutex_lock(&mp->mem_lock);
+
+    header = (Memory_Pool_Debug_Header *)
+             ((unsigned char *)mem - MEMPOOL_DEBUG_OBJECT_OFFSET);
+
+    for(i = 0; i < mp->alloc_time; i++){
+
+        block_size = (size_t)mp->size * mp->memory_slots[i];
+
+        if((char *)header >= (char *)mp->memory[i] && 
+           (char *)header < (char *)mp->memory[i] + block_size){
+
+            closest = (int)((char *)header - (char *)mp->memory[i]);
+            break;
+        }
+    }
+
+    if(closest < 0 || (closest % mp->size) != 0){
+        fprintf(stderr, 
+                "[Mempool] free of pointer [%p] not owned by pool [%s] at " \
+                "%s:%d\n", mem, mp->name, file, line);
+        fflush(stderr);
+
+        abort();
+    }
+
+    if(header->state == SLOT_STATE_QUARANTINED || 
+       header->state == SLOT_STATE_FREE)
+        mp_report_violation(mp, header, "double free", file, line);
+
+    mp_check_redzones(mp, header, file, line);
+
+    mp_poison_slot(mp, header, SLOT_STATE_QUARANTINED);
+    header->file = file;
+    header->line = line;
+
+    mp->used_slots = mp->used_slots - 1;
+
+    mp->total_frees ++;
+
+    /* Release the oldest slot in quarantine to the free list when the 
+       quarantine is full */
+    if(mp->quarantine_count == MEMPOOL_DEBUG_QUARANTINE_SLOTS)
+        mp_release_quarantined_slot(mp, file, line);
+
+    mp->quarantine[(mp->quarantine_head + mp->quarantine_count) % 
+                   MEMPOOL_DEBUG_QUARANTINE_SLOTS] = header;
+    mp->quarantine_count ++;
+
+    pthread_mutex_unlock(&mp->mem_lock);
+
+    return MEMORY_POOL_SUCCESS;
+}
+
+#endif
+
 float mp_slots_usage_percentage(Memory_Pool *mp){
     float usage_percentage = 0;
     
-    usage_percentage = (mp->used_slots*1.0) / (mp->alloc_time * mp->slots);
+    usage_percentage = (mp->used_slots*1.0) / mp->total_slots;
 
     return usage_percentage;
 }
 
+void mp_set_name(Memory_Pool *mp, const char *name){
+
+    pthread_mutex_lock(&mp->mem_lock);
+
+    memset(mp->name, 0, sizeof(mp->name));
+    strncpy(mp->name, name, sizeof(mp->name) - 1);
+
+    pthread_mutex_unlock(&mp->mem_lock);
+}
+
+void mp_get_statistics(Memory_Pool *mp, MemoryPoolStatistics *stats){
+
+    time_t now = time(NULL);
+    int elapsed_time;
+
+    pthread_mutex_lock(&mp->mem_lock);
+
+    stats->used_slots = mp->used_slots;
+    stats->peak_used_slots = mp->peak_used_slots;
+    stats->total_slots = mp->total_slots;
+    stats->expand_times = mp->expand_times;
+    stats->failed_allocs = mp->failed_allocs;
+
+    elapsed_time = (int)(now - mp->last_sampled_time);
+
+    if(elapsed_time > 0){
+        stats->allocs_per_sec = 
+            (mp->total_allocs - mp->last_sampled_allocs) / (float)elapsed_time;
+        stats->frees_per_sec = 
+            (mp->total_frees - mp->last_sampled_frees) / (float)elapsed_time;
+    }else{
+        stats->allocs_per_sec = 0;
+        stats->frees_per_sec = 0;
+    }
+
+    mp->last_sampled_allocs = mp->total_allocs;
+    mp->last_sampled_frees = mp->total_frees;
+    mp->last_sampled_time = now;
+
+    pthread_mutex_unlock(&mp->mem_lock);
+}
+
+int ma_init(Memory_Arena *arena, size_t chunk_size){
+
+    arena->chunks = NULL;
+    arena->chunk_size = chunk_size;
+    arena->total_size = 0;
+
+    pthread_mutex_init( &arena->arena_lock, 0);
+
+    return MEMORY_POOL_SUCCESS;
+}
+
+void *ma_alloc(Memory_Arena *arena, size_t size){
+
+    Memory_Arena_Chunk *chunk;
+    size_t header_size;
+    size_t chunk_size;
+    char *mem;
+
+    /* keep the memory handed out aligned */
+    size = (size + MEMORY_ARENA_ALIGNMENT - 1) & 
+           ~((size_t)MEMORY_ARENA_ALIGNMENT - 1);
+    header_size = (sizeof(Memory_Arena_Chunk) + MEMORY_ARENA_ALIGNMENT - 1) &
+                  ~((size_t)MEMORY_ARENA_ALIGNMENT - 1);
+
+    pthread_mutex_lock( &arena->arena_lock);
+
+    chunk = arena->chunks;
+
+    if(chunk == NULL || chunk->size - chunk->used < size){
+
+        chunk_size = arena->chunk_size;
+        if(size > chunk_size)
+            chunk_size = size;
+
+        chunk = malloc(header_size + chunk_size);
+        if(chunk == NULL){
+            pthread_mutex_unlock( &arena->arena_lock);
+            return NULL;
+        }
+
+        /* touch the memory here to place it near the requesting thread */
+        memset(chunk, 0, header_size + chunk_size);
+        chunk->size = chunk_size;
+        chunk->used = 0;
+
+        /* a dedicated chunk for a large request does not replace the current
+           chunk which may still have space */
+        if(arena->chunks != NULL && chunk_size > arena->chunk_size){
+            chunk->next = arena->chunks->next;
+            arena->chunks->next = chunk;
+        }else{
+            chunk->next = arena->chunks;
+            arena->chunks = chunk;
+        }
+
+        arena->total_size += chunk_size;
+    }
+
+    mem = (char *)chunk + header_size + chunk->used;
+    chunk->used += size;
+
+    pthread_mutex_unlock( &arena->arena_lock);
+
+    return mem;
+}
+
+void ma_reset(Memory_Arena *arena){
+
+    Memory_Arena_Chunk *chunk;
+    Memory_Arena_Chunk *next_chunk;
+    size_t header_size;
+
+    header_size = (sizeof(Memory_Arena_Chunk) + MEMORY_ARENA_ALIGNMENT - 1) &
+                  ~((size_t)MEMORY_ARENA_ALIGNMENT - 1);
+
+    pthread_mutex_lock( &arena->arena_lock);
+
+    if(arena->chunks != NULL){
+
+        chunk = arena->chunks->next;
+        while(chunk != NULL){
+            next_chunk = chunk->next;
+            free(chunk);
+            chunk = next_chunk;
+        }
+
+        chunk = arena->chunks;
+        chunk->next = NULL;
+        chunk->used = 0;
+        memset((char *)chunk + header_size, 0, chunk->size);
+
+        arena->total_size = chunk->size;
+    }
+
+    pthread_mutex_unlock( &arena->arena_lock);
+}
+
+void ma_destroy(Memory_Arena *arena){
+
+    Memory_Arena_Chunk *chunk;
+    Memory_Arena_Chunk *next_chunk;
+
+    pthread_mutex_lock( &arena->arena_lock);
+
+    chunk = arena->chunks;
+    while(chunk != NULL){
+        next_chunk = chunk->next;
+        free(chunk);
+        chunk = next_chunk;
+    }
+
+    arena->chunks = NULL;
+    arena->total_size = 0;
+
+    pthread_mutex_unlock( &arena->arena_lock);
+
+    pthread_mutex_destroy( &arena->arena_lock);
+}
+
+size_t ma_get_current_size(Memory_Arena *arena){
+
+    size_t arena_size;
+
+    pthread_mutex_lock( &arena->arena_lock);
+
+    arena_size = arena->total_size;
+
+    pthread_mutex_unlock( &arena->arena_lock);
+
+    return arena_size;
+}
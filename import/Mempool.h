@@ -47,9 +47,11 @@
 #ifndef MEMPOOL_H
 #define MEMPOOL_H
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <string.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -58,10 +60,110 @@
 /* When debugging is needed */
 //#define debugging
 
+/* When memory corruption of pooled objects needs to be diagnosed. In this 
+   mode each slot is surrounded by redzones, freed slots are filled with a 
+   poison pattern and kept in quarantine before being reused, and every 
+   violation is reported with the pool name and the call sites of mp_alloc 
+   and mp_free. The memory pool uses more memory and runs slower in this 
+   mode, so it should not be enabled in release builds. */
+//#define MEMPOOL_DEBUG
+
 #define MEMORY_POOL_SUCCESS 1
 #define MEMORY_POOL_ERROR 0
 #define MEMORY_POOL_MINIMUM_SIZE sizeof(void *)
-#define MAX_EXP_TIME 10
+#define MAX_EXP_TIME 64
+
+/* The largest number of slots made by one expansion of a memory pool taken
+   from a memory arena. The expansions of such a pool double in size up to 
+   this number. */
+#define MAX_SLOTS_IN_ONE_ARENA_EXPANSION 65536
+
+/* Maximum length in number of bytes of the name of a memory pool */
+#define LENGTH_OF_MEMORY_POOL_NAME 64
+
+/* The alignment in bytes of the memory returned by the memory arena */
+#define MEMORY_ARENA_ALIGNMENT 16
+
+#ifdef MEMPOOL_DEBUG
+
+/* The number of bytes of each redzone before and after the object */
+#define MEMPOOL_DEBUG_REDZONE_SIZE 16
+
+/* The byte pattern written into redzones */
+#define MEMPOOL_DEBUG_REDZONE_PATTERN 0xFB
+
+/* The byte pattern written into the objects of freed slots */
+#define MEMPOOL_DEBUG_FREED_PATTERN 0xDD
+
+/* The number of freed slots held in quarantine by each memory pool before
+   they can be reused. A pool which cannot expand any more reuses the oldest
+   slots in quarantine early. */
+#define MEMPOOL_DEBUG_QUARANTINE_SLOTS 256
+
+/* The states of a slot in debug mode */
+typedef enum _MemoryPoolSlotState {
+
+    SLOT_STATE_FREE = 0x46524545,
+    SLOT_STATE_ALLOCATED = 0x414C4C43,
+    SLOT_STATE_QUARANTINED = 0x51524E54
+
+} MemoryPoolSlotState;
+
+/* The header in front of each slot in debug mode. The slot layout is header,
+   redzone, object and redzone. The first member overlaps the link of the 
+   free list. */
+typedef struct {
+
+    void *next_free;
+
+    /* The call site of the last mp_alloc or mp_free of the slot */
+    const char *file;
+    int line;
+
+    MemoryPoolSlotState state;
+
+    /* The size in bytes of the object requested by the user */
+    size_t object_size;
+
+} Memory_Pool_Debug_Header;
+
+#endif
+
+/* The structure of a chunk of memory owned by the memory arena. The memory 
+   handed out by the arena follows the header of the chunk. */
+typedef struct Memory_Arena_Chunk_ {
+
+    /* The next chunk in the list of chunks owned by the arena */
+    struct Memory_Arena_Chunk_ *next;
+
+    /* The size in bytes of the memory following the header */
+    size_t size;
+
+    /* The number of bytes already handed out from this chunk */
+    size_t used;
+
+} Memory_Arena_Chunk;
+
+/* The structure of the memory arena. The memory arena hands out memory by 
+   bumping a pointer in its current chunk and releases all the memory in one 
+   call. Chunks are allocated and zeroed lazily by the thread requesting 
+   memory, so the pages are placed near the threads which use them under the 
+   first-touch policy of the operating system. */
+typedef struct {
+
+    /* The list of chunks, the current chunk is at the head of the list */
+    Memory_Arena_Chunk *chunks;
+
+    /* The size in bytes of each chunk */
+    size_t chunk_size;
+
+    /* The total size in bytes of all chunks */
+    size_t total_size;
+
+    /* A per arena lock */
+    pthread_mutex_t arena_lock;
+
+} Memory_Arena;
 
 /* The structure of the memory pool */
 typedef struct {
@@ -71,6 +173,13 @@ typedef struct {
     /* An array stores the head of each malloced memory */
     void *memory[MAX_EXP_TIME];
 
+    /* The number of slots in each malloced memory */
+    int memory_slots[MAX_EXP_TIME];
+
+    /* The memory arena from which the memory of the pool is taken. It is NULL
+       when the memory is malloced. */
+    Memory_Arena *arena;
+
     /* Counting current malloc times */
     int alloc_time;
 
@@ -80,16 +189,74 @@ typedef struct {
     /* The size of each slots in byte */
     int size;
 
-    /* The number of slots is made each time the mempool expand */
+    /* The number of slots is made the next time the mempool expand */
     int slots;
 
+    /* The number of slots made by all expansions */
+    int total_slots;
+
     int blocks;
     
     /* counter for calculating the slots usage */
     int used_slots;
 
+    /* The name of the memory pool shown in the usage statistics */
+    char name[LENGTH_OF_MEMORY_POOL_NAME];
+
+    /* The largest number of slots in use at the same time */
+    int peak_used_slots;
+
+    /* The number of times the memory pool expanded after initialization */
+    int expand_times;
+
+    /* The number of allocations failed because the pool cannot expand */
+    int failed_allocs;
+
+    /* The accumulated number of successful allocations and frees */
+    unsigned int total_allocs;
+    unsigned int total_frees;
+
+    /* The counters and time at which mp_get_statistics was last called. They
+       are used to calculate the allocation and free rates per second. */
+    unsigned int last_sampled_allocs;
+    unsigned int last_sampled_frees;
+    time_t last_sampled_time;
+
+#ifdef MEMPOOL_DEBUG
+    /* The size in bytes of the object in each slot. The size member above 
+       is the size of the whole slot including the header and redzones. */
+    int object_size;
+
+    /* The ring of freed slots waiting to be reused */
+    void *quarantine[MEMPOOL_DEBUG_QUARANTINE_SLOTS];
+    int quarantine_head;
+    int quarantine_count;
+#endif
+
 } Memory_Pool;
 
+/* The snapshot of the usage statistics of a memory pool */
+typedef struct {
+
+    /* The number of slots in use and the peak number of slots in use */
+    int used_slots;
+    int peak_used_slots;
+
+    /* The number of slots currently allocated by the memory pool */
+    int total_slots;
+
+    /* The number of times the memory pool expanded after initialization */
+    int expand_times;
+
+    /* The number of allocations failed because the pool cannot expand */
+    int failed_allocs;
+
+    /* The allocation and free rates per second since the last snapshot */
+    float allocs_per_sec;
+    float frees_per_sec;
+
+} MemoryPoolStatistics;
+
 
 /*
   get_current_size_mempool:
@@ -126,6 +293,34 @@ size_t get_current_size_mempool(Memory_Pool *mp);
 int mp_init(Memory_Pool *mp, size_t size, size_t slots);
 
 
+/*
+  mp_init_in_arena:
+
+     This function initializes the memory pool like mp_init, but takes the 
+     memory of the pool from the input memory arena. The memory is released 
+     when the arena is destroyed. Each expansion of the pool makes twice the
+     slots of the previous one, up to MAX_SLOTS_IN_ONE_ARENA_EXPANSION, so 
+     the pool can grow with its users far beyond MAX_EXP_TIME times the 
+     initial slots.
+
+  Parameters:
+
+     mp - pointer to a specific memory pool
+     size - the size of slots in the pool
+     slots - the number of slots in the memory pool, and of its first 
+             expansion
+     arena - pointer to the memory arena providing the memory
+
+  Return value:
+
+     Status - the error code or the successful message
+ */
+int mp_init_in_arena(Memory_Pool *mp, 
+                     size_t size, 
+                     size_t slots, 
+                     Memory_Arena *arena);
+
+
 /*
   mp_expand:
 
@@ -194,6 +389,53 @@ void *mp_alloc(Memory_Pool *mp);
  */
 int mp_free(Memory_Pool *mp, void *mem);
 
+#ifdef MEMPOOL_DEBUG
+
+/*
+  mp_alloc_debug:
+
+     This function is mp_alloc in debug mode. It checks the redzones and the 
+     poison pattern of the slot before handing it out, and records the call 
+     site in the slot header.
+
+  Parameters:
+
+     mp - pointer to the specific memory pool to be used
+     file - the source file of the caller
+     line - the source line of the caller
+
+  Return value:
+
+     void - the pointer to the object of a free slot or NULL
+ */
+void *mp_alloc_debug(Memory_Pool *mp, const char *file, int line);
+
+
+/*
+  mp_free_debug:
+
+     This function is mp_free in debug mode. It reports double frees, frees 
+     of foreign pointers and overflows into the redzones, poisons the object
+     and puts the slot in quarantine.
+
+  Parameters:
+
+     mp - the pointer to the specific memory pool
+     mem - the pointer to the object to be freed
+     file - the source file of the caller
+     line - the source line of the caller
+
+  Return value:
+
+     Errorcode - error code or sucessful message
+ */
+int mp_free_debug(Memory_Pool *mp, void *mem, const char *file, int line);
+
+#define mp_alloc(mp) mp_alloc_debug((mp), __FILE__, __LINE__)
+#define mp_free(mp, mem) mp_free_debug((mp), (mem), __FILE__, __LINE__)
+
+#endif
+
 /*
   mp_slots_usage_percentage:
 
@@ -209,4 +451,123 @@ int mp_free(Memory_Pool *mp, void *mem);
 */
 float mp_slots_usage_percentage(Memory_Pool *mp);
 
+/*
+  mp_set_name:
+
+     This function sets the name used to identify the memory pool in the 
+     usage statistics.
+
+  Parameters:
+
+     mp - the pointer to the specific memory pool
+     name - the name of the memory pool
+
+  Return value:
+
+     None
+*/
+void mp_set_name(Memory_Pool *mp, const char *name);
+
+/*
+  mp_get_statistics:
+
+     This function takes a snapshot of the usage counters of the memory pool.
+     The allocation and free rates are calculated against the previous 
+     snapshot, so the function is expected to be called periodically by a 
+     single monitoring thread.
+
+  Parameters:
+
+     mp - the pointer to the specific memory pool
+     stats - the pointer to the structure to store the snapshot
+
+  Return value:
+
+     None
+*/
+void mp_get_statistics(Memory_Pool *mp, MemoryPoolStatistics *stats);
+
+/*
+  ma_init:
+
+     This function initializes the memory arena. No memory is allocated until
+     the first call to ma_alloc.
+
+  Parameters:
+
+     arena - pointer to a specific memory arena
+     chunk_size - the size in bytes of each chunk of the arena
+
+  Return value:
+
+     Status - the error code or the successful message
+*/
+int ma_init(Memory_Arena *arena, size_t chunk_size);
+
+/*
+  ma_alloc:
+
+     This function hands out zeroed memory from the memory arena. A new chunk 
+     is allocated when the current chunk does not have enough space. Requests
+     larger than the chunk size get a dedicated chunk.
+
+  Parameters:
+
+     arena - pointer to a specific memory arena
+     size - the size in bytes of the requested memory
+
+  Return value:
+
+     void - the pointer to the memory or NULL
+*/
+void *ma_alloc(Memory_Arena *arena, size_t size);
+
+/*
+  ma_reset:
+
+     This function makes all the memory of the memory arena available again. 
+     The first chunk is kept for reuse and the other chunks are released. All 
+     the pointers handed out by the arena become invalid.
+
+  Parameters:
+
+     arena - pointer to a specific memory arena
+
+  Return value:
+
+     None
+*/
+void ma_reset(Memory_Arena *arena);
+
+/*
+  ma_destroy:
+
+     This function releases all the memory of the memory arena in one call.
+
+  Parameters:
+
+     arena - pointer to the specific memory arena to be destroyed
+
+  Return value:
+
+     None
+*/
+void ma_destroy(Memory_Arena *arena);
+
+/*
+  ma_get_current_size:
+
+     This function returns the total size in bytes of the chunks owned by the
+     memory arena.
+
+  Parameters:
+
+     arena - pointer to a specific memory arena
+
+  Return value:
+
+     size_t - the total size of the memory arena
+*/
+size_t ma_get_current_size(Memory_Arena *arena);
+
 #endif
\ No newline at end of file
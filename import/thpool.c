@@ -194,7 +194,6 @@ void thpool_destroy(thpool_ *thpool_p){
 
     mp_destroy(&thpool_p->mempool);
 
-    free(thpool_p -> threads);
     free(thpool_p);
 
     thpool_p = NULL;
@@ -0,0 +1,1419 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     benchmarkHashTable.c
+
+  File Description:
+
+     This file contains the implementation of the benchmark tool of the area
+     hashtables of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The benchmark tool runs the following benchmarks, selected by the -b
+     option, or all of them:
+
+     lookup - lookups of objects by binary and by text MAC addresses
+     reclaim - evictions of objects with and without readers of the rows
+     summary - summary passes with different percentages of objects scanned
+               in each second
+     upload - summary and upload passes of one area by one and by several 
+              threads
+     latency - the time from tracking data to the upload of moved objects 
+               in an ordinary and a time critical area
+     eviction - summary passes evicting different percentages of objects 
+                against the passes evicting none
+     gap - puts of rssi signals after gaps of different lengths
+
+     Each result is written as one CSV line:
+
+     benchmark,variant,objects,threads,operations,elapsed_ms,value,unit
+*/
+
+#include "benchmarkHashTable.h"
+
+/* The settings and state of each thread of the lookup benchmark */
+typedef struct {
+
+    HashTable *h_table;
+
+    BenchmarkSettings *settings;
+
+    /* The text forms of the MAC addresses of all objects, or NULL to look
+       up the binary MAC addresses */
+    char (*mac_addresses)[LENGTH_OF_MAC_ADDRESS];
+
+    unsigned int seed;
+
+    /* The number of lookups which found the object */
+    long long found;
+
+} LookupArgument;
+
+/* The settings and state of each reader thread of the reclaim benchmark */
+typedef struct {
+
+    HashTable *h_table;
+
+    volatile bool *is_stopped;
+
+    /* The number of rows and overflow records read, and the number of rows
+       found reused for another object while they were read */
+    long long read_rows;
+    long long read_records;
+    long long reused_rows;
+
+} ReclaimArgument;
+
+/* The settings of the summary and urgent threads of the latency benchmark */
+typedef struct {
+
+    AreaWorkQueue *work_queue;
+
+    volatile bool *is_stopped;
+
+} LatencyArgument;
+
+/* The moves of the latency benchmark, shared with the upload handler */
+static LatencyState latency_state;
+
+
+double get_time_in_ms(){
+
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (double)tv.tv_sec * 1000.0 + (double)tv.tv_usec / 1000.0;
+#endif
+}
+
+/*
+Returns the next number of a linear congruential generator, so that every
+run replays the same tracking data.
+*/
+
+static unsigned int benchmark_random(unsigned int *seed){
+
+    *seed = *seed * 1103515245 + 12345;
+
+    return (*seed >> 8) & 0xFFFFFF;
+}
+
+uint64_t get_benchmark_key(int object){
+
+    /* Multiplying by an odd number is a bijection of the 48-bit values */
+    return ((uint64_t)(object + 1) * 0x9E3779B97F4A7C15ULL) &
+           BENCHMARK_MAC_ADDRESS_MASK;
+}
+
+void put_benchmark_tracking_data(HashTable *h_table,
+                                 uint64_t key,
+                                 int lbeacon_id,
+                                 int rssi,
+                                 int timestamp){
+
+    DataForHashtable data_row;
+
+    memset(&data_row, 0, sizeof(DataForHashtable));
+
+    data_row.lbeacon_id = lbeacon_id;
+    data_row.initial_timestamp_GMT = timestamp;
+    data_row.final_timestamp_GMT = timestamp;
+    data_row.rssi = rssi;
+    strcpy(data_row.battery_voltage, "12");
+    strcpy(data_row.panic_button, "0");
+
+    hashtable_put_new_tracking_data(
+        h_table,
+        key,
+        &data_row,
+        BENCHMARK_NUMBER_OF_LBEACONS_UNDER_TRACKED,
+        BENCHMARK_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+        BENCHMARK_RSSI_THRESHOLD,
+        BENCHMARK_UNREASONABLE_RSSI_CHANGE);
+}
+
+/*
+Interns the lbeacons of the benchmarks, placed on a grid in the benchmarked
+area, in the lbeacon registry.
+*/
+
+static ErrorCode init_benchmark_lbeacons(BenchmarkSettings *settings){
+
+    char uuid[LENGTH_OF_UUID];
+    int i;
+
+    for(i = 0; i < BENCHMARK_LBEACONS; i++){
+
+        sprintf(uuid, "%04d00000000%08d0000%08d",
+                BENCHMARK_AREA_ID,
+                (i % BENCHMARK_LBEACONS_IN_ONE_ROW) *
+                BENCHMARK_LBEACON_SPACING_IN_MM,
+                (i / BENCHMARK_LBEACONS_IN_ONE_ROW) *
+                BENCHMARK_LBEACON_SPACING_IN_MM);
+
+        settings->lbeacon_ids[i] = lbeacon_registry_intern(uuid);
+        if(settings->lbeacon_ids[i] == LBEACON_ID_UNKNOWN)
+            return E_MALLOC;
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+/*
+Puts one second of tracking data of every object into the hashtable. Each
+object is scanned by the lbeacons next to the lbeacon of its index.
+*/
+
+static void put_benchmark_objects(BenchmarkSettings *settings,
+                                  HashTable *h_table,
+                                  int timestamp){
+
+    int object;
+    int k;
+
+    for(object = 0; object < settings->number_objects; object++){
+
+        for(k = 0; k < BENCHMARK_LBEACONS_PER_OBJECT; k++){
+
+            put_benchmark_tracking_data(
+                h_table,
+                get_benchmark_key(object),
+                settings->lbeacon_ids[(object + k) % BENCHMARK_LBEACONS],
+                -50 - k * 5,
+                timestamp);
+        }
+    }
+}
+
+static void init_result(BenchmarkResult *result,
+                        const char *benchmark,
+                        const char *variant,
+                        BenchmarkSettings *settings,
+                        int threads,
+                        long long operations,
+                        const char *unit){
+
+    memset(result, 0, sizeof(BenchmarkResult));
+
+    result->benchmark = benchmark;
+    result->variant = variant;
+    result->objects = settings->number_objects;
+    result->threads = threads;
+    result->operations = operations;
+    result->unit = unit;
+}
+
+static void *run_lookups(void *_argument){
+
+    LookupArgument *argument = (LookupArgument *)_argument;
+    HashShard *shard;
+    uint64_t key;
+    int object;
+    int i;
+
+    for(i = 0; i < argument->settings->operations; i++){
+
+        object = benchmark_random(&argument->seed) %
+                 argument->settings->number_objects;
+
+        if(argument->mac_addresses != NULL){
+            if(!parse_mac_address(argument->mac_addresses[object], &key))
+                continue;
+        }else{
+            key = get_benchmark_key(object);
+        }
+
+        shard = hashtable_get_shard(argument->h_table, key);
+
+        pthread_rwlock_rdlock(&shard->shard_lock);
+
+        if(hashtable_find_row(argument->h_table, key) != NULL)
+            argument->found++;
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+    }
+
+    return (void *)NULL;
+}
+
+void benchmark_lookup(BenchmarkSettings *settings,
+                      bool text_key,
+                      int number_threads,
+                      BenchmarkResult *result){
+
+    HashTable *h_table;
+    char (*mac_addresses)[LENGTH_OF_MAC_ADDRESS] = NULL;
+    LookupArgument arguments[MAX_BENCHMARK_THREADS];
+    pthread_t threads[MAX_BENCHMARK_THREADS];
+    long long found = 0;
+    double start_time;
+    char *digit;
+    int i;
+
+    init_result(result,
+                "lookup",
+                text_key ? "text_key" : "binary_key",
+                settings,
+                number_threads,
+                (long long)settings->operations * number_threads,
+                "lookups_per_sec");
+
+    h_table = hashtable_new_default(destroy_value_part);
+    if(h_table == NULL)
+        return;
+
+    put_benchmark_objects(settings, h_table, BENCHMARK_START_TIME);
+
+    if(text_key){
+
+        mac_addresses = malloc(LENGTH_OF_MAC_ADDRESS *
+                               settings->number_objects);
+        if(mac_addresses == NULL){
+            hashtable_destroy(h_table);
+            return;
+        }
+
+        /* Gateways report MAC addresses in both cases, so every other
+           object is reported in upper case */
+        for(i = 0; i < settings->number_objects; i++){
+
+            format_mac_address(get_benchmark_key(i), mac_addresses[i]);
+
+            if(i % 2 == 1){
+                for(digit = mac_addresses[i]; *digit != '\0'; digit++)
+                    *digit = toupper((unsigned char)*digit);
+            }
+        }
+    }
+
+    for(i = 0; i < number_threads; i++){
+        memset(&arguments[i], 0, sizeof(LookupArgument));
+        arguments[i].h_table = h_table;
+        arguments[i].settings = settings;
+        arguments[i].mac_addresses = mac_addresses;
+        arguments[i].seed = i + 1;
+    }
+
+    start_time = get_time_in_ms();
+
+    for(i = 0; i < number_threads; i++){
+        pthread_create(&threads[i], NULL, run_lookups, &arguments[i]);
+    }
+
+    for(i = 0; i < number_threads; i++){
+        pthread_join(threads[i], NULL);
+        found += arguments[i].found;
+    }
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+
+    if(result->elapsed_ms > 0)
+        result->value = result->operations * 1000.0 / result->elapsed_ms;
+
+    /* Every lookup is for an object in the hashtable */
+    if(found != result->operations){
+        printf("lookup: %lld of %lld lookups found the object\n",
+               found, result->operations);
+        result->value = 0;
+    }
+
+    free(mac_addresses);
+    hashtable_destroy(h_table);
+}
+
+/*
+Walks the rows in use and their records registered as a reader of the rows,
+until the benchmark is stopped. A row seen in use must keep its key until 
+the reader has finished, since the row is not reused before. Rows free when
+they are first seen may be taken by new objects meanwhile, so the key and 
+the flag are copied together by hashtable_get_row_summary.
+*/
+
+static void *run_row_reads(void *_argument){
+
+    ReclaimArgument *argument = (ReclaimArgument *)_argument;
+    HashTable *h_table = argument->h_table;
+    hash_table_row *table_row;
+    hash_table_row row_summary;
+    uuid_record_table_row *overflow_records;
+    uint64_t key;
+    long epoch;
+    int row_count;
+    int number_records;
+    int i;
+    int m;
+
+    while(!*argument->is_stopped){
+
+        epoch = hashtable_enter_row_read(h_table);
+
+        row_count = h_table->row_count;
+
+        for(i = 0; i < row_count; i++){
+
+            table_row = hashtable_get_row(h_table, i);
+
+            if(!hashtable_get_row_summary(table_row, &row_summary))
+                continue;
+
+            key = row_summary.mac_address;
+
+            number_records = table_row->number_uuid_records;
+            overflow_records = table_row->overflow_uuid_record_table_array;
+
+            // the overflow block of a row seen in use is released only 
+            // after the reader has finished
+            if(overflow_records != NULL){
+                for(m = NUMBER_OF_INLINE_UUID_RECORDS; m < number_records &&
+                    m < MAX_NUMBER_OF_LBEACON_UNDER_TRACKING; m++){
+
+                    if(overflow_records[m - NUMBER_OF_INLINE_UUID_RECORDS].
+                       is_in_use)
+                        argument->read_records++;
+                }
+            }
+
+            // the object may have been evicted meanwhile, but the row must
+            // not be in use by another object
+            if(hashtable_get_row_summary(table_row, &row_summary) &&
+               row_summary.mac_address != key)
+                argument->reused_rows++;
+
+            argument->read_rows++;
+        }
+
+        hashtable_exit_row_read(h_table, epoch);
+    }
+
+    return (void *)NULL;
+}
+
+void benchmark_reclaim(BenchmarkSettings *settings,
+                       int number_readers,
+                       BenchmarkResult *result){
+
+    HashTable *h_table;
+    HashShard *shard;
+    hash_table_row *table_row;
+    ReclaimArgument arguments[MAX_BENCHMARK_THREADS];
+    pthread_t threads[MAX_BENCHMARK_THREADS];
+    volatile bool is_stopped = false;
+    long long read_rows = 0;
+    long long reused_rows = 0;
+    double start_time;
+    uint64_t key;
+    int timestamp = BENCHMARK_START_TIME;
+    int first_object;
+    int object;
+    int i;
+    int k;
+
+    init_result(result,
+                "reclaim",
+                number_readers == 0 ? "no_readers" : "readers",
+                settings,
+                number_readers,
+                (long long)settings->number_objects,
+                "evictions_per_sec");
+
+    h_table = hashtable_new_default(destroy_value_part);
+    if(h_table == NULL)
+        return;
+
+    for(i = 0; i < number_readers; i++){
+        memset(&arguments[i], 0, sizeof(ReclaimArgument));
+        arguments[i].h_table = h_table;
+        arguments[i].is_stopped = &is_stopped;
+
+        pthread_create(&threads[i], NULL, run_row_reads, &arguments[i]);
+    }
+
+    start_time = get_time_in_ms();
+
+    for(first_object = 0; first_object < settings->number_objects; 
+        first_object += BENCHMARK_RECLAIM_BATCH){
+
+        for(object = first_object; 
+            object < first_object + BENCHMARK_RECLAIM_BATCH &&
+            object < settings->number_objects; object++){
+
+            for(k = 0; k < BENCHMARK_RECLAIM_LBEACONS_PER_OBJECT; k++){
+
+                put_benchmark_tracking_data(
+                    h_table,
+                    get_benchmark_key(object),
+                    settings->lbeacon_ids[(object + k) % BENCHMARK_LBEACONS],
+                    -50 - k * 5,
+                    timestamp);
+            }
+        }
+
+        // the objects are evicted as the summary pass evicts them, with 
+        // shard_lock in exclusive mode and node_lock of the row
+        for(object = first_object; 
+            object < first_object + BENCHMARK_RECLAIM_BATCH &&
+            object < settings->number_objects; object++){
+
+            key = get_benchmark_key(object);
+            shard = hashtable_get_shard(h_table, key);
+
+            pthread_rwlock_wrlock(&shard->shard_lock);
+
+            table_row = hashtable_find_row(h_table, key);
+            if(table_row != NULL){
+                pthread_mutex_lock(&table_row->node_lock);
+                hashtable_remove_row(h_table, key);
+            }
+
+            pthread_rwlock_unlock(&shard->shard_lock);
+        }
+    }
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+
+    is_stopped = true;
+
+    for(i = 0; i < number_readers; i++){
+        pthread_join(threads[i], NULL);
+        read_rows += arguments[i].read_rows;
+        reused_rows += arguments[i].reused_rows;
+    }
+
+    if(result->elapsed_ms > 0)
+        result->value = result->operations * 1000.0 / result->elapsed_ms;
+
+    if(reused_rows != 0){
+        printf("reclaim: %lld of %lld rows were reused while read\n",
+               reused_rows, read_rows);
+        result->value = 0;
+    }
+
+    hashtable_destroy(h_table);
+}
+
+/*
+Summarizes the hashtable once with the benchmark settings, as the summary 
+thread does every second.
+*/
+
+static void summarize_benchmark_area(HashTable *h_table){
+
+    hashtable_summarize_location_information(
+        h_table,
+        BENCHMARK_RSSI_THRESHOLD,
+        BENCHMARK_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+        BENCHMARK_UNREASONABLE_RSSI_CHANGE,
+        BENCHMARK_RSSI_WEIGHT_MULTIPLIER,
+        BENCHMARK_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE,
+        BENCHMARK_BASE_LOCATION_TOLERANCE_IN_MILLIMETER);
+}
+
+void benchmark_summary(BenchmarkSettings *settings,
+                       int update_rate,
+                       BenchmarkResult *result){
+
+    HashTable *h_table;
+    unsigned int seed = 1;
+    double start_time;
+    int timestamp;
+    int second;
+    int object;
+    int k;
+
+    init_result(result,
+                "summary",
+                BenchmarkSummaryUpdate_String[update_rate],
+                settings,
+                1,
+                BENCHMARK_SUMMARY_SECONDS,
+                "ms_per_pass");
+
+    h_table = hashtable_new_default(destroy_value_part);
+    if(h_table == NULL)
+        return;
+
+    set_replay_time(BENCHMARK_START_TIME);
+
+    for(second = 0; 
+        second < BENCHMARK_SUMMARY_WARMUP_SECONDS + BENCHMARK_SUMMARY_SECONDS;
+        second++){
+
+        timestamp = advance_replay_time(1);
+
+        for(object = 0; object < settings->number_objects; object++){
+
+            if(second >= BENCHMARK_SUMMARY_WARMUP_SECONDS &&
+               benchmark_random(&seed) % 100 >= 
+               BenchmarkSummaryUpdatePercent[update_rate])
+                continue;
+
+            for(k = 0; k < BENCHMARK_LBEACONS_PER_OBJECT; k++){
+
+                put_benchmark_tracking_data(
+                    h_table,
+                    get_benchmark_key(object),
+                    settings->lbeacon_ids[(object + k) % BENCHMARK_LBEACONS],
+                    -50 - (int)(benchmark_random(&seed) % 30),
+                    timestamp);
+            }
+        }
+
+        start_time = get_time_in_ms();
+
+        summarize_benchmark_area(h_table);
+
+        if(second >= BENCHMARK_SUMMARY_WARMUP_SECONDS)
+            result->elapsed_ms += get_time_in_ms() - start_time;
+    }
+
+    result->value = result->elapsed_ms / BENCHMARK_SUMMARY_SECONDS;
+
+    hashtable_destroy(h_table);
+}
+
+/*
+Evicts all objects of the hashtable by a summary pass after the time the 
+objects are kept without being scanned.
+*/
+
+static void evict_benchmark_objects(HashTable *h_table){
+
+    advance_replay_time(h_table->tolerant_not_scanning_time_in_sec + 1);
+
+    summarize_benchmark_area(h_table);
+}
+
+static void *run_upload_pass(void *_argument){
+
+    hashtable_traverse_areas_to_upload_latest_location(
+        NULL,
+        BENCHMARK_SERVER_INSTALLATION_PATH,
+        (AreaWorkQueue *)_argument,
+        BENCHMARK_RSSI_THRESHOLD,
+        BENCHMARK_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+        BENCHMARK_UNREASONABLE_RSSI_CHANGE,
+        BENCHMARK_RSSI_WEIGHT_MULTIPLIER,
+        BENCHMARK_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE,
+        BENCHMARK_BASE_LOCATION_TOLERANCE_IN_MILLIMETER);
+
+    return (void *)NULL;
+}
+
+void benchmark_upload(BenchmarkSettings *settings,
+                      int number_threads,
+                      BenchmarkResult *result){
+
+    HashTable *h_table;
+    AreaWorkQueue work_queue;
+    pthread_t threads[MAX_BENCHMARK_THREADS];
+    long uploaded_rows;
+    long missing_rows = 0;
+    double start_time;
+    int pass;
+    int i;
+
+    init_result(result,
+                "upload",
+                number_threads == 1 ? "one_thread" : "threads",
+                settings,
+                number_threads,
+                BENCHMARK_UPLOAD_PASSES,
+                "ms_per_pass");
+
+    h_table = hash_table_of_specific_area_id(BENCHMARK_AREA_ID);
+    if(h_table == NULL)
+        return;
+
+    initialize_area_work_queue(
+        &work_queue, 
+        "upload", 
+        BENCHMARK_PERIOD_BETWEEN_CHECK_OBJECT_LOCATION_IN_MS);
+
+    for(pass = 0; 
+        pass < BENCHMARK_UPLOAD_WARMUP_PASSES + BENCHMARK_UPLOAD_PASSES;
+        pass++){
+
+        put_benchmark_objects(settings, h_table, advance_replay_time(1));
+
+        uploaded_rows = get_replay_uploaded_rows(false);
+
+        // the pass is due at once, without waiting for the period in real
+        // time
+        work_queue.pass_start_time = 
+            get_clock_time_in_ms() - work_queue.period_in_ms;
+
+        start_time = get_time_in_ms();
+
+        for(i = 0; i < number_threads; i++){
+            pthread_create(&threads[i], NULL, run_upload_pass, &work_queue);
+        }
+
+        for(i = 0; i < number_threads; i++){
+            pthread_join(threads[i], NULL);
+        }
+
+        if(pass >= BENCHMARK_UPLOAD_WARMUP_PASSES){
+            result->elapsed_ms += get_time_in_ms() - start_time;
+
+            missing_rows += settings->number_objects - 
+                (get_replay_uploaded_rows(false) - uploaded_rows);
+        }
+    }
+
+    result->value = result->elapsed_ms / BENCHMARK_UPLOAD_PASSES;
+
+    if(missing_rows != 0){
+        printf("upload: %ld objects were not uploaded\n", missing_rows);
+        result->value = 0;
+    }
+
+    // the next run starts from an empty area
+    evict_benchmark_objects(h_table);
+
+    destroy_area_work_queue(&work_queue);
+}
+
+static void *run_summary_passes(void *_argument){
+
+    LatencyArgument *argument = (LatencyArgument *)_argument;
+
+    while(!*argument->is_stopped){
+
+        run_upload_pass(argument->work_queue);
+
+        sleep_t(AREA_WORK_QUEUE_POLLING_TIME_IN_MS);
+    }
+
+    return (void *)NULL;
+}
+
+static void *run_urgent_summaries(void *_argument){
+
+    LatencyArgument *argument = (LatencyArgument *)_argument;
+
+    while(!*argument->is_stopped){
+
+        hashtable_traverse_areas_to_upload_urgent_location(
+            NULL,
+            BENCHMARK_SERVER_INSTALLATION_PATH,
+            BENCHMARK_RSSI_THRESHOLD,
+            BENCHMARK_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+            BENCHMARK_UNREASONABLE_RSSI_CHANGE,
+            BENCHMARK_RSSI_WEIGHT_MULTIPLIER,
+            BENCHMARK_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE,
+            BENCHMARK_BASE_LOCATION_TOLERANCE_IN_MILLIMETER);
+
+        sleep_t(URGENT_SUMMARY_POLLING_TIME_IN_MS);
+    }
+
+    return (void *)NULL;
+}
+
+/*
+Finds the move of the object of an uploaded line of object_summary_table, 
+and measures its latency if the line has the lbeacon the object moved to. 
+The line ends with the MAC address and the area id of the object, and starts
+with the uuid of its lbeacon.
+*/
+
+static void handle_latency_upload(char *line, bool is_history){
+
+    char *area_id_str;
+    char *mac_address;
+    char *uuid_end;
+    uint64_t key;
+    double latency;
+    int i;
+
+    if(is_history)
+        return;
+
+    area_id_str = strrchr(line, ',');
+    if(area_id_str == NULL || atoi(area_id_str + 1) != latency_state.area_id)
+        return;
+
+    *area_id_str = '\0';
+
+    mac_address = strrchr(line, ',');
+    uuid_end = strchr(line, ',');
+    if(mac_address == NULL || uuid_end == NULL ||
+       !parse_mac_address(mac_address + 1, &key))
+        return;
+
+    *uuid_end = '\0';
+
+    pthread_mutex_lock(&latency_state.lock);
+
+    for(i = 0; i < latency_state.number_moves; i++){
+
+        if(latency_state.moves[i].key != key)
+            continue;
+
+        if(strcmp(lbeacon_registry_get_uuid(latency_state.moves[i].lbeacon_id),
+                  line) == 0){
+
+            latency = get_time_in_ms() - latency_state.moves[i].move_time;
+
+            latency_state.seen_moves++;
+            latency_state.sum_latency_ms += latency;
+            if(latency > latency_state.max_latency_ms)
+                latency_state.max_latency_ms = latency;
+
+            latency_state.number_moves--;
+            latency_state.moves[i] = 
+                latency_state.moves[latency_state.number_moves];
+        }
+
+        break;
+    }
+
+    pthread_mutex_unlock(&latency_state.lock);
+}
+
+/*
+Moves an object to another lbeacon, by tracking data of the lbeacon stronger
+than the lbeacon the object is at, and records the time of the move.
+*/
+
+static void move_latency_object(HashTable *h_table,
+                                BenchmarkSettings *settings,
+                                int *object_lbeacons,
+                                int object,
+                                unsigned int *seed){
+
+    int i;
+
+    object_lbeacons[object] = 
+        (object_lbeacons[object] + 1 + 
+         benchmark_random(seed) % (BENCHMARK_LBEACONS - 1)) % 
+        BENCHMARK_LBEACONS;
+
+    pthread_mutex_lock(&latency_state.lock);
+
+    // the earlier move of the object is replaced by this move
+    for(i = 0; i < latency_state.number_moves; i++){
+        if(latency_state.moves[i].key == get_benchmark_key(object))
+            break;
+    }
+
+    if(i < BENCHMARK_LATENCY_MAX_PENDING_MOVES){
+
+        if(i == latency_state.number_moves)
+            latency_state.number_moves++;
+
+        latency_state.moves[i].key = get_benchmark_key(object);
+        latency_state.moves[i].lbeacon_id = 
+            settings->lbeacon_ids[object_lbeacons[object]];
+        latency_state.moves[i].move_time = get_time_in_ms();
+    }
+
+    pthread_mutex_unlock(&latency_state.lock);
+
+    put_benchmark_tracking_data(
+        h_table,
+        get_benchmark_key(object),
+        settings->lbeacon_ids[object_lbeacons[object]],
+        -30,
+        get_system_time());
+}
+
+void benchmark_latency(BenchmarkSettings *settings,
+                       bool is_time_critical,
+                       BenchmarkResult *average_result,
+                       BenchmarkResult *max_result){
+
+    HashTable *h_table;
+    AreaWorkQueue work_queue;
+    LatencyArgument argument;
+    pthread_t summary_thread;
+    pthread_t urgent_thread;
+    volatile bool is_stopped = false;
+    char area_id_list[CONFIG_BUFFER_SIZE];
+    int *object_lbeacons;
+    unsigned int seed = 1;
+    int tick;
+    int object;
+    int i;
+
+    init_result(average_result,
+                "latency",
+                is_time_critical ? "time_critical" : "periodic",
+                settings,
+                2,
+                0,
+                "avg_latency_ms");
+
+    init_result(max_result,
+                "latency",
+                is_time_critical ? "time_critical" : "periodic",
+                settings,
+                2,
+                0,
+                "max_latency_ms");
+
+    memset(&latency_state, 0, sizeof(LatencyState));
+    pthread_mutex_init(&latency_state.lock, NULL);
+
+    if(is_time_critical){
+
+        latency_state.area_id = BENCHMARK_TIME_CRITICAL_AREA_ID;
+
+        sprintf(area_id_list, "%d;", BENCHMARK_TIME_CRITICAL_AREA_ID);
+
+        if(WORK_SUCCESSFULLY != set_time_critical_areas(
+               area_id_list,
+               BENCHMARK_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE))
+            return;
+    }else{
+
+        latency_state.area_id = BENCHMARK_PERIODIC_AREA_ID;
+    }
+
+    h_table = hash_table_of_specific_area_id(latency_state.area_id);
+    if(h_table == NULL)
+        return;
+
+    object_lbeacons = malloc(sizeof(int) * settings->number_objects);
+    if(object_lbeacons == NULL)
+        return;
+
+    for(object = 0; object < settings->number_objects; object++)
+        object_lbeacons[object] = object % BENCHMARK_LBEACONS;
+
+    initialize_area_work_queue(
+        &work_queue, 
+        "latency", 
+        BENCHMARK_PERIOD_BETWEEN_CHECK_OBJECT_LOCATION_IN_MS);
+
+    set_replay_upload_handler(handle_latency_upload);
+
+    argument.work_queue = &work_queue;
+    argument.is_stopped = &is_stopped;
+
+    pthread_create(&summary_thread, NULL, run_summary_passes, &argument);
+    pthread_create(&urgent_thread, NULL, run_urgent_summaries, &argument);
+
+    for(tick = 0; tick < (BENCHMARK_LATENCY_WARMUP_SECONDS + 
+                          BENCHMARK_LATENCY_SECONDS) * 
+                         BENCHMARK_LATENCY_TICKS_PER_SECOND; tick++){
+
+        // the replayed time follows the real time of the ticks
+        if(tick % BENCHMARK_LATENCY_TICKS_PER_SECOND == 0)
+            advance_replay_time(1);
+
+        if(tick >= BENCHMARK_LATENCY_WARMUP_SECONDS * 
+                   BENCHMARK_LATENCY_TICKS_PER_SECOND){
+
+            for(i = 0; i < BENCHMARK_LATENCY_MOVES_PER_TICK; i++){
+
+                move_latency_object(h_table,
+                                    settings,
+                                    object_lbeacons,
+                                    benchmark_random(&seed) % 
+                                    settings->number_objects,
+                                    &seed);
+
+                average_result->operations++;
+            }
+        }
+
+        // each object is scanned by its lbeacon, and weakly by an lbeacon
+        // far away, in one tick of every second
+        for(object = tick % BENCHMARK_LATENCY_TICKS_PER_SECOND; 
+            object < settings->number_objects; 
+            object += BENCHMARK_LATENCY_TICKS_PER_SECOND){
+
+            put_benchmark_tracking_data(
+                h_table,
+                get_benchmark_key(object),
+                settings->lbeacon_ids[object_lbeacons[object]],
+                -45,
+                get_system_time());
+
+            put_benchmark_tracking_data(
+                h_table,
+                get_benchmark_key(object),
+                settings->lbeacon_ids[(object_lbeacons[object] + 
+                                       BENCHMARK_LBEACONS / 2) % 
+                                      BENCHMARK_LBEACONS],
+                -85,
+                get_system_time());
+        }
+
+        sleep_t(BENCHMARK_LATENCY_TICK_IN_MS);
+    }
+
+    is_stopped = true;
+
+    pthread_join(summary_thread, NULL);
+    pthread_join(urgent_thread, NULL);
+
+    set_replay_upload_handler(NULL);
+
+    average_result->elapsed_ms = BENCHMARK_LATENCY_SECONDS * 1000.0;
+    max_result->elapsed_ms = average_result->elapsed_ms;
+
+    // the moves whose new location has not been uploaded are not counted
+    average_result->operations = latency_state.seen_moves;
+    max_result->operations = latency_state.seen_moves;
+
+    if(latency_state.seen_moves > 0){
+        average_result->value = 
+            latency_state.sum_latency_ms / latency_state.seen_moves;
+        max_result->value = latency_state.max_latency_ms;
+    }
+
+    // the next run starts from an empty area
+    evict_benchmark_objects(h_table);
+
+    destroy_area_work_queue(&work_queue);
+    pthread_mutex_destroy(&latency_state.lock);
+    free(object_lbeacons);
+}
+
+/*
+Returns the number of objects in the hashtable. No other thread may use the 
+hashtable.
+*/
+
+static int count_benchmark_objects(HashTable *h_table){
+
+    int number_objects = 0;
+    int i;
+
+    for(i = 0; i < NUMBER_OF_HASH_TABLE_SHARDS; i++)
+        number_objects += h_table->shards[i].count;
+
+    return number_objects;
+}
+
+void benchmark_eviction(BenchmarkSettings *settings,
+                        int eviction_rate,
+                        BenchmarkResult *idle_result,
+                        BenchmarkResult *expiry_result){
+
+    HashTable *h_table;
+    char area_time_list[CONFIG_BUFFER_SIZE];
+    double start_time;
+    double elapsed_ms;
+    int inactive_objects = 0;
+    int evicted_objects;
+    int number_objects;
+    int timestamp;
+    int second;
+    int object;
+    int k;
+
+    init_result(idle_result,
+                "eviction",
+                BenchmarkEviction_String[eviction_rate],
+                settings,
+                1,
+                0,
+                "idle_ms_per_pass");
+
+    init_result(expiry_result,
+                "eviction",
+                BenchmarkEviction_String[eviction_rate],
+                settings,
+                1,
+                0,
+                "expiry_ms_per_pass");
+
+    sprintf(area_time_list, "%d:%d;", 
+            BENCHMARK_EVICTION_AREA_ID, BENCHMARK_EVICTION_TIMEOUT_IN_SEC);
+
+    if(WORK_SUCCESSFULLY != 
+       set_area_tolerant_not_scanning_time(area_time_list))
+        return;
+
+    h_table = hash_table_of_specific_area_id(BENCHMARK_EVICTION_AREA_ID);
+    if(h_table == NULL)
+        return;
+
+    // the objects are located until their rssi signals become stale, and
+    // expire after the timeout of the area
+    for(second = 0; second <= BENCHMARK_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED +
+                              BENCHMARK_EVICTION_TIMEOUT_IN_SEC + 
+                              BENCHMARK_EVICTION_EXTRA_SECONDS; second++){
+
+        timestamp = advance_replay_time(1);
+
+        for(object = 0; object < settings->number_objects; object++){
+
+            // the inactive objects are scanned in the first second only
+            if(object % 100 < BenchmarkEvictionPercent[eviction_rate]){
+                if(second > 0)
+                    continue;
+                inactive_objects++;
+            }
+
+            for(k = 0; k < BENCHMARK_LBEACONS_PER_OBJECT; k++){
+
+                put_benchmark_tracking_data(
+                    h_table,
+                    get_benchmark_key(object),
+                    settings->lbeacon_ids[(object + k) % BENCHMARK_LBEACONS],
+                    -50 - k * 5,
+                    timestamp);
+            }
+        }
+
+        number_objects = count_benchmark_objects(h_table);
+
+        start_time = get_time_in_ms();
+
+        summarize_benchmark_area(h_table);
+
+        elapsed_ms = get_time_in_ms() - start_time;
+
+        evicted_objects = number_objects - count_benchmark_objects(h_table);
+
+        if(evicted_objects == 0){
+
+            idle_result->operations++;
+            idle_result->elapsed_ms += elapsed_ms;
+
+        }else{
+
+            // the inactive objects expire in the same second
+            if(expiry_result->operations > 0 || 
+               second <= BENCHMARK_EVICTION_TIMEOUT_IN_SEC){
+                printf("eviction: %d objects evicted after %d seconds\n",
+                       evicted_objects, second);
+                return;
+            }
+
+            expiry_result->operations += evicted_objects;
+            expiry_result->elapsed_ms += elapsed_ms;
+        }
+    }
+
+    if(idle_result->operations > 0)
+        idle_result->value = idle_result->elapsed_ms / idle_result->operations;
+
+    if(expiry_result->operations == inactive_objects){
+        expiry_result->value = expiry_result->elapsed_ms;
+    }else{
+        printf("eviction: %lld of %d inactive objects evicted\n",
+               expiry_result->operations, inactive_objects);
+    }
+
+    // the next run starts from an empty area
+    evict_benchmark_objects(h_table);
+}
+
+void benchmark_gap(BenchmarkSettings *settings,
+                   int gap,
+                   BenchmarkResult *result){
+
+    HashTable *h_table;
+    double start_time;
+    int timestamp = BENCHMARK_START_TIME;
+    long long i;
+
+    init_result(result,
+                "gap",
+                BenchmarkGap_String[gap],
+                settings,
+                1,
+                settings->operations / BENCHMARK_GAP_PUTS_DIVISOR,
+                "ns_per_put");
+
+    if(result->operations > 
+       (INT_MAX - BENCHMARK_START_TIME) / BenchmarkGapInSec[gap])
+        result->operations = 
+            (INT_MAX - BENCHMARK_START_TIME) / BenchmarkGapInSec[gap];
+
+    h_table = hashtable_new_default(destroy_value_part);
+    if(h_table == NULL)
+        return;
+
+    start_time = get_time_in_ms();
+
+    for(i = 0; i < result->operations; i++){
+
+        // the server sees the tracking data as they arrive
+        set_replay_time(timestamp);
+
+        put_benchmark_tracking_data(h_table,
+                                    get_benchmark_key(0),
+                                    settings->lbeacon_ids[0],
+                                    -50 - (int)(i % 20),
+                                    timestamp);
+
+        timestamp += BenchmarkGapInSec[gap];
+    }
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+
+    if(result->operations > 0)
+        result->value = result->elapsed_ms * 1000000.0 / result->operations;
+
+    hashtable_destroy(h_table);
+
+    set_replay_time(BENCHMARK_START_TIME);
+}
+
+void print_result(FILE *output, BenchmarkResult *result){
+
+    fprintf(output, "%s,%s,%d,%d,%lld,%.3f,%.1f,%s\n",
+            result->benchmark,
+            result->variant,
+            result->objects,
+            result->threads,
+            result->operations,
+            result->elapsed_ms,
+            result->value,
+            result->unit);
+}
+
+/*
+Opens the log of the server, which the hashtables write their errors to.
+*/
+
+static ErrorCode init_benchmark_log(){
+
+    if(zlog_init(BENCHMARK_ZLOG_CONFIG_FILE_NAME) != 0)
+        return E_OPEN_FILE;
+
+    category_health_report = zlog_get_category(LOG_CATEGORY_HEALTH_REPORT);
+    category_debug = zlog_get_category(LOG_CATEGORY_DEBUG);
+    category_dump = zlog_get_category(LOG_CATEGORY_DUMP_TRACKING);
+
+    if(category_health_report == NULL || category_debug == NULL ||
+       category_dump == NULL){
+
+        zlog_fini();
+        return E_OPEN_FILE;
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+void display_usage(){
+    printf("\n");
+    printf("benchmarkHashTable [-b benchmark] [-n objects] " \
+           "[-l operations] [-t threads] [-o output_file]\n");
+    printf("\n");
+    printf("-b: specify the benchmark to run, i.e., lookup, reclaim, " \
+           "summary, upload, latency, eviction or gap. All benchmarks are " \
+           "run if not specified\n");
+    printf("-n: specify the number of objects in the benchmarked area. " \
+           "The default value is %d\n", DEFAULT_BENCHMARK_OBJECTS);
+    printf("-l: specify the number of lookups of each thread. " \
+           "The default value is %d\n", DEFAULT_BENCHMARK_LOOKUPS);
+    printf("-t: specify the number of threads in the multi-thread " \
+           "benchmarks. The default value is %d\n",
+           DEFAULT_BENCHMARK_THREADS);
+    printf("-o: specify the CSV file to which results are appended. " \
+           "Results are written to the standard output if not specified\n");
+    printf("\n");
+    printf("The tool reads %s, and is run from the installation " \
+           "directory of BOT server\n", BENCHMARK_ZLOG_CONFIG_FILE_NAME);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int ch;
+    char *benchmark_name = NULL;
+    char *output_file = NULL;
+    FILE *output = stdout;
+    BenchmarkSettings settings;
+    BenchmarkResult result;
+    BenchmarkResult max_result;
+    int benchmark;
+    int i;
+
+    memset(&settings, 0, sizeof(BenchmarkSettings));
+    settings.number_objects = DEFAULT_BENCHMARK_OBJECTS;
+    settings.number_threads = DEFAULT_BENCHMARK_THREADS;
+    settings.operations = DEFAULT_BENCHMARK_LOOKUPS;
+
+    while((ch = getopt(argc, argv, "b:n:l:t:o:h")) != -1){
+        switch(ch){
+            case 'b':
+                benchmark_name = optarg;
+                break;
+            case 'n':
+                settings.number_objects = atoi(optarg);
+                break;
+            case 'l':
+                settings.operations = atoi(optarg);
+                break;
+            case 't':
+                settings.number_threads = atoi(optarg);
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'h':
+                display_usage();
+                return 1;
+            case '?':
+                return -1;
+            default:
+                return -1;
+        }
+    }
+
+    if(settings.number_objects <= 0 || settings.operations <= 0 ||
+       settings.number_threads <= 0 ||
+       settings.number_threads > MAX_BENCHMARK_THREADS){
+        display_usage();
+        return -1;
+    }
+
+    for(benchmark = 0; benchmark < BENCHMARK_MAX; benchmark++){
+        if(benchmark_name == NULL ||
+           strcmp(benchmark_name, HashTableBenchmark_String[benchmark]) == 0)
+            break;
+    }
+
+    if(benchmark == BENCHMARK_MAX){
+        display_usage();
+        return -1;
+    }
+
+    if(WORK_SUCCESSFULLY != init_benchmark_log()){
+        printf("Cannot open the log with %s\n",
+               BENCHMARK_ZLOG_CONFIG_FILE_NAME);
+        return -1;
+    }
+
+    if(WORK_SUCCESSFULLY != initialize_lbeacon_registry() ||
+       WORK_SUCCESSFULLY != init_benchmark_lbeacons(&settings) ||
+       WORK_SUCCESSFULLY !=
+       update_rssi_weight_table(BENCHMARK_RSSI_WEIGHT_MULTIPLIER)){
+
+        printf("Cannot initialize the lbeacons\n");
+        zlog_fini();
+        return -1;
+    }
+
+    if(WORK_SUCCESSFULLY != initialize_area_table()){
+        printf("Cannot initialize the area table\n");
+        zlog_fini();
+        return -1;
+    }
+
+    if(output_file != NULL){
+        output = fopen(output_file, "a+");
+        if(output == NULL){
+            printf("Cannot open the output file %s\n", output_file);
+            zlog_fini();
+            return -1;
+        }
+    }else{
+        fprintf(output, "benchmark,variant,objects,threads,operations," \
+                "elapsed_ms,value,unit\n");
+    }
+
+    set_replay_time(BENCHMARK_START_TIME);
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_LOOKUP){
+
+        benchmark_lookup(&settings, false, 1, &result);
+        print_result(output, &result);
+
+        benchmark_lookup(&settings, false, settings.number_threads, &result);
+        print_result(output, &result);
+
+        benchmark_lookup(&settings, true, 1, &result);
+        print_result(output, &result);
+
+        benchmark_lookup(&settings, true, settings.number_threads, &result);
+        print_result(output, &result);
+    }
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_RECLAIM){
+
+        benchmark_reclaim(&settings, 0, &result);
+        print_result(output, &result);
+
+        benchmark_reclaim(&settings, settings.number_threads, &result);
+        print_result(output, &result);
+    }
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_SUMMARY){
+
+        for(i = 0; i < BENCHMARK_SUMMARY_UPDATE_RATES; i++){
+            benchmark_summary(&settings, i, &result);
+            print_result(output, &result);
+        }
+    }
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_UPLOAD){
+
+        benchmark_upload(&settings, 1, &result);
+        print_result(output, &result);
+
+        benchmark_upload(&settings, settings.number_threads, &result);
+        print_result(output, &result);
+    }
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_LATENCY){
+
+        benchmark_latency(&settings, false, &result, &max_result);
+        print_result(output, &result);
+        print_result(output, &max_result);
+
+        benchmark_latency(&settings, true, &result, &max_result);
+        print_result(output, &result);
+        print_result(output, &max_result);
+    }
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_EVICTION){
+
+        for(i = 0; i < BENCHMARK_EVICTION_RATES; i++){
+            benchmark_eviction(&settings, i, &result, &max_result);
+            print_result(output, &result);
+            print_result(output, &max_result);
+        }
+    }
+
+    if(benchmark_name == NULL || benchmark == BENCHMARK_GAP){
+
+        for(i = 0; i < BENCHMARK_GAPS; i++){
+            benchmark_gap(&settings, i, &result);
+            print_result(output, &result);
+        }
+    }
+
+    if(output != stdout)
+        fclose(output);
+
+    destroy_area_table();
+    destroy_rssi_weight_table();
+    destroy_lbeacon_registry();
+    zlog_fini();
+
+    return 0;
+}
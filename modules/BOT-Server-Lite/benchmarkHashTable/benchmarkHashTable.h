@@ -0,0 +1,554 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     benchmarkHashTable.h
+
+  File Description:
+
+     This file contains the definitions and declarations of constants,
+     structures, and functions used in the benchmark tool of the area
+     hashtables of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The benchmark tool feeds synthetic tracking data of objects scanned by
+     lbeacons into the area hashtables of BOT server, and measures the
+     tracking, summary and upload paths of the server with it. The database
+     is replaced by functions which read back the files the server would
+     upload, and the time of the server is replayed, so the benchmarks run
+     without a database and faster than real time. The results are written
+     in CSV format so that they can be tracked across releases.
+*/
+
+#ifndef BENCHMARK_HASHTABLE_H
+#define BENCHMARK_HASHTABLE_H
+
+#include "getopt.h"
+
+#include "HashTable.h"
+#include "LBeaconRegistry.h"
+#include "replayClock.h"
+#include "replayDatabase.h"
+
+/* The configuration file of zlog, the same as BOT server */
+#define BENCHMARK_ZLOG_CONFIG_FILE_NAME "./config/zlog.conf"
+
+/* The number of objects in the benchmarked area */
+#define DEFAULT_BENCHMARK_OBJECTS 50000
+
+/* The number of lookups made by each thread in the lookup benchmark */
+#define DEFAULT_BENCHMARK_LOOKUPS 2000000
+
+/* The number of worker threads in the multi-thread benchmarks */
+#define DEFAULT_BENCHMARK_THREADS 4
+
+/* The maximum number of worker threads */
+#define MAX_BENCHMARK_THREADS 64
+
+/* The area id of the benchmarked area */
+#define BENCHMARK_AREA_ID 1
+
+/* The lbeacons are placed on a grid of BENCHMARK_LBEACONS_IN_ONE_ROW columns
+   spaced BENCHMARK_LBEACON_SPACING_IN_MM apart */
+#define BENCHMARK_LBEACONS 100
+#define BENCHMARK_LBEACONS_IN_ONE_ROW 10
+#define BENCHMARK_LBEACON_SPACING_IN_MM 5000
+
+/* The number of lbeacons scanning each object every second */
+#define BENCHMARK_LBEACONS_PER_OBJECT 3
+
+/* The settings of the server used by the benchmarks. They are the values
+   shipped in server.conf. */
+#define BENCHMARK_NUMBER_OF_LBEACONS_UNDER_TRACKED 16
+#define BENCHMARK_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED 10
+#define BENCHMARK_RSSI_THRESHOLD -70
+#define BENCHMARK_UNREASONABLE_RSSI_CHANGE 15
+#define BENCHMARK_RSSI_WEIGHT_MULTIPLIER 3
+#define BENCHMARK_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE 5
+#define BENCHMARK_BASE_LOCATION_TOLERANCE_IN_MILLIMETER 500
+
+/* The epoch time at which the replayed tracking data starts */
+#define BENCHMARK_START_TIME 1600000000
+
+/* The mask of the 48 bits of a MAC address */
+#define BENCHMARK_MAC_ADDRESS_MASK 0xFFFFFFFFFFFFULL
+
+/* The number of objects put and then evicted together by the reclaim
+   benchmark, and the number of lbeacons scanning each of them. The objects
+   are scanned by more lbeacons than the records kept in a row, so evicted
+   rows retire their overflow blocks as well. */
+#define BENCHMARK_RECLAIM_BATCH 1000
+#define BENCHMARK_RECLAIM_LBEACONS_PER_OBJECT 8
+
+/* The number of seconds the summary benchmark puts tracking data of every 
+   object before it measures, and the number of seconds it measures */
+#define BENCHMARK_SUMMARY_WARMUP_SECONDS 10
+#define BENCHMARK_SUMMARY_SECONDS 20
+
+/* The installation path of the files uploaded to the replay database. It is
+   empty, as in server.conf, so the files are written under ./temp. */
+#define BENCHMARK_SERVER_INSTALLATION_PATH ""
+
+/* The period of the summary passes of the server in milliseconds */
+#define BENCHMARK_PERIOD_BETWEEN_CHECK_OBJECT_LOCATION_IN_MS 1000
+
+/* The number of passes the upload benchmark runs before it measures, and 
+   the number of passes it measures */
+#define BENCHMARK_UPLOAD_WARMUP_PASSES 2
+#define BENCHMARK_UPLOAD_PASSES 5
+
+/* The area ids of the latency benchmark. The objects of the time critical
+   area are summarized as soon as they move. */
+#define BENCHMARK_PERIODIC_AREA_ID 1
+#define BENCHMARK_TIME_CRITICAL_AREA_ID 2
+
+/* The latency benchmark runs in real time in ticks of 
+   BENCHMARK_LATENCY_TICK_IN_MS, and each object is scanned in one tick of 
+   every second. Objects move to other lbeacons after the warm-up. */
+#define BENCHMARK_LATENCY_TICK_IN_MS 100
+#define BENCHMARK_LATENCY_TICKS_PER_SECOND 10
+#define BENCHMARK_LATENCY_WARMUP_SECONDS 3
+#define BENCHMARK_LATENCY_SECONDS 10
+#define BENCHMARK_LATENCY_MOVES_PER_TICK 2
+
+/* The maximum number of moved objects whose location has not been uploaded
+   yet. Moves beyond it are not measured. */
+#define BENCHMARK_LATENCY_MAX_PENDING_MOVES 256
+
+/* The area id of the eviction benchmark, and the length of time in seconds
+   after which its objects not located are evicted. The benchmark runs the
+   passes until BENCHMARK_EVICTION_EXTRA_SECONDS after the inactive objects
+   expire. */
+#define BENCHMARK_EVICTION_AREA_ID 3
+#define BENCHMARK_EVICTION_TIMEOUT_IN_SEC 60
+#define BENCHMARK_EVICTION_EXTRA_SECONDS 5
+
+/* The number of puts in the gap benchmark is the number of lookups divided
+   by this value, and fewer if the time of the last put would be beyond the
+   range of epoch seconds */
+#define BENCHMARK_GAP_PUTS_DIVISOR 10
+
+/* The benchmarks which can be selected by the -b option */
+typedef enum _HashTableBenchmark {
+
+    BENCHMARK_LOOKUP = 0,
+    BENCHMARK_RECLAIM = 1,
+    BENCHMARK_SUMMARY = 2,
+    BENCHMARK_UPLOAD = 3,
+    BENCHMARK_LATENCY = 4,
+    BENCHMARK_EVICTION = 5,
+    BENCHMARK_GAP = 6,
+    BENCHMARK_MAX
+
+} HashTableBenchmark;
+
+/* Readable names of the benchmarks used in the option and the output */
+const char * const HashTableBenchmark_String[] = {
+
+    "lookup",
+    "reclaim",
+    "summary",
+    "upload",
+    "latency",
+    "eviction",
+    "gap"
+};
+
+/* The percentages of objects scanned in each second of the summary 
+   benchmark, and their names used in the output */
+#define BENCHMARK_SUMMARY_UPDATE_RATES 4
+
+const int BenchmarkSummaryUpdatePercent[] = {
+
+    1,
+    10,
+    50,
+    100
+};
+
+const char * const BenchmarkSummaryUpdate_String[] = {
+
+    "updated_1pct",
+    "updated_10pct",
+    "updated_50pct",
+    "updated_100pct"
+};
+
+/* The percentages of objects which stop being scanned in the eviction 
+   benchmark, and their names used in the output */
+#define BENCHMARK_EVICTION_RATES 3
+
+const int BenchmarkEvictionPercent[] = {
+
+    10,
+    50,
+    90
+};
+
+const char * const BenchmarkEviction_String[] = {
+
+    "inactive_10pct",
+    "inactive_50pct",
+    "inactive_90pct"
+};
+
+/* The numbers of seconds between the rssi signals of the gap benchmark, and
+   their names used in the output */
+#define BENCHMARK_GAPS 4
+
+const int BenchmarkGapInSec[] = {
+
+    1,
+    10,
+    300,
+    3600
+};
+
+const char * const BenchmarkGap_String[] = {
+
+    "gap_1s",
+    "gap_10s",
+    "gap_300s",
+    "gap_3600s"
+};
+
+/* The settings shared by all benchmarks */
+typedef struct {
+
+    /* The number of objects in the benchmarked area */
+    int number_objects;
+
+    /* The number of worker threads in the multi-thread benchmarks */
+    int number_threads;
+
+    /* The number of operations of each thread in the benchmarks counting
+       operations */
+    int operations;
+
+    /* The ids of the lbeacons in the lbeacon registry */
+    int lbeacon_ids[BENCHMARK_LBEACONS];
+
+} BenchmarkSettings;
+
+/* The result of a single benchmark */
+typedef struct {
+
+    const char *benchmark;
+
+    const char *variant;
+
+    int objects;
+
+    int threads;
+
+    long long operations;
+
+    double elapsed_ms;
+
+    /* The value measured by the benchmark, in the unit below */
+    double value;
+
+    const char *unit;
+
+} BenchmarkResult;
+
+
+/* An object moved to another lbeacon in the latency benchmark, whose new 
+   location has not been uploaded yet */
+typedef struct {
+
+    uint64_t key;
+
+    int lbeacon_id;
+
+    /* The time in milliseconds at which the tracking data of the move were
+       put */
+    double move_time;
+
+} LatencyMove;
+
+/* The moves of the latency benchmark and the latency of the moves seen in 
+   the uploaded files */
+typedef struct {
+
+    pthread_mutex_t lock;
+
+    int area_id;
+
+    LatencyMove moves[BENCHMARK_LATENCY_MAX_PENDING_MOVES];
+    int number_moves;
+
+    long long seen_moves;
+    double sum_latency_ms;
+    double max_latency_ms;
+
+} LatencyState;
+
+
+/*
+  get_time_in_ms:
+
+     This function returns a monotonic timestamp in milliseconds with
+     sub-millisecond resolution.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     double - the timestamp in milliseconds
+*/
+double get_time_in_ms();
+
+/*
+  get_benchmark_key:
+
+     This function returns the binary MAC address of an object. The MAC
+     addresses of different objects are different and scattered over the
+     48 bits.
+
+  Parameters:
+
+     object - the index of the object
+
+  Return value:
+
+     uint64_t - the binary MAC address
+*/
+uint64_t get_benchmark_key(int object);
+
+/*
+  put_benchmark_tracking_data:
+
+     This function puts one rssi signal of an object scanned by an lbeacon
+     into the hashtable with the benchmark settings.
+
+  Parameters:
+
+     h_table - the hashtable of the benchmarked area
+     key - the binary MAC address of the object
+     lbeacon_id - the id of the lbeacon in the lbeacon registry
+     rssi - the rssi signal
+     timestamp - the time in epoch seconds at which the lbeacon scanned the
+                 object
+
+  Return value:
+
+     None
+*/
+void put_benchmark_tracking_data(HashTable *h_table,
+                                 uint64_t key,
+                                 int lbeacon_id,
+                                 int rssi,
+                                 int timestamp);
+
+/*
+  benchmark_lookup:
+
+     This function measures the lookups of objects by their binary MAC
+     addresses in the hashtable of an area holding all objects, as the
+     worker threads do for each tracking data. The "binary_key" variant
+     looks the key up, and the "text_key" variant parses the text form of
+     the MAC address first, as it arrives in tracking data.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     text_key - a flag indicating whether to parse the text form first
+     number_threads - the number of threads looking objects up
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_lookup(BenchmarkSettings *settings,
+                      bool text_key,
+                      int number_threads,
+                      BenchmarkResult *result);
+
+/*
+  benchmark_reclaim:
+
+     This function measures the eviction of objects while reader threads 
+     walk the rows and their records without locks, registered by 
+     hashtable_enter_row_read as the uploads are. Batches of objects are put
+     and evicted until the number of objects of the settings is evicted, and
+     the rows of evicted objects are reused by later batches once the 
+     readers have finished. A reader finding a row reused for another object
+     while it reads the row fails the benchmark.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     number_readers - the number of reader threads, or 0
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_reclaim(BenchmarkSettings *settings,
+                       int number_readers,
+                       BenchmarkResult *result);
+
+/*
+  benchmark_summary:
+
+     This function measures the summary pass of the hashtable of an area 
+     when only some of the objects are scanned in each second, and the 
+     others are stationary or not heard. Every object is scanned in every 
+     second of the warm-up, and then each object is scanned in a second 
+     with the percentage of the update rate. The time of the passes follows
+     the number of objects scanned rather than the number of objects.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     update_rate - the index of the update rate in 
+                   BenchmarkSummaryUpdatePercent
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_summary(BenchmarkSettings *settings,
+                       int update_rate,
+                       BenchmarkResult *result);
+
+/*
+  benchmark_upload:
+
+     This function measures the passes of the summary threads over an area 
+     holding all objects, each scanned in every second. The threads share 
+     the summary chunks of the area through an area work queue, and the last
+     thread uploads the lines of all chunks in one batch, as the summary 
+     threads of the server do. The pass must upload every object within the
+     period of the passes.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     number_threads - the number of summary threads
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_upload(BenchmarkSettings *settings,
+                      int number_threads,
+                      BenchmarkResult *result);
+
+/*
+  benchmark_latency:
+
+     This function measures the time from the tracking data which move an 
+     object to another lbeacon to the upload of the new location of the 
+     object to object_summary_table. The benchmark runs in real time with a
+     summary thread taking passes once a period and an urgent thread, as 
+     the server does, while objects of an area move in every tick. The area
+     is either an ordinary area summarized by the passes, or a time critical
+     area whose moved objects are summarized at once.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     is_time_critical - a flag indicating whether the area is time critical
+     average_result - the pointer to the result of the average latency
+     max_result - the pointer to the result of the maximum latency
+
+  Return value:
+
+     None
+*/
+void benchmark_latency(BenchmarkSettings *settings,
+                       bool is_time_critical,
+                       BenchmarkResult *average_result,
+                       BenchmarkResult *max_result);
+
+/*
+  benchmark_eviction:
+
+     This function measures the summary passes of an area with its own 
+     length of time after which objects not located are evicted, while a 
+     percentage of the objects stops being scanned after the first second.
+     The inactive objects expire together, and the benchmark compares the 
+     pass evicting them with the other passes. The run fails unless every 
+     inactive object is evicted by the pass at the timeout of the area.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     eviction_rate - the index of the percentage in BenchmarkEvictionPercent
+     idle_result - the pointer to the result of the passes evicting no 
+                   object
+     expiry_result - the pointer to the result of the pass evicting the 
+                     inactive objects
+
+  Return value:
+
+     None
+*/
+void benchmark_eviction(BenchmarkSettings *settings,
+                        int eviction_rate,
+                        BenchmarkResult *idle_result,
+                        BenchmarkResult *expiry_result);
+
+/*
+  benchmark_gap:
+
+     This function measures the puts of rssi signals of an object scanned by
+     an lbeacon after gaps of the same length, during which the lbeacon did 
+     not scan the object. The put fills the seconds of the gap in the ring 
+     of rssi signals of the record, so its time must not grow with the 
+     length of the gap.
+
+  Parameters:
+
+     settings - the settings of the benchmarks
+     gap - the index of the gap in BenchmarkGapInSec
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_gap(BenchmarkSettings *settings,
+                   int gap,
+                   BenchmarkResult *result);
+
+/*
+  print_result:
+
+     This function writes a benchmark result as a CSV line.
+
+  Parameters:
+
+     output - the file to be written
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void print_result(FILE *output, BenchmarkResult *result);
+
+#endif
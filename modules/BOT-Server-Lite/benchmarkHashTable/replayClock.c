@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     replayClock.c
+
+  File Description:
+
+     This file contains the implementation of the replay clock used by the
+     tools which replay tracking data into the area hashtables of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The functions below replace the functions of BeDIS.c with the same
+     names, so a tool links either this file or BeDIS.c.
+*/
+
+#include "replayClock.h"
+
+/* The epoch time returned by get_system_time, or 0 for the real time */
+static volatile int replay_time = 0;
+
+
+void set_replay_time(int time_in_sec){
+
+    replay_time = time_in_sec;
+}
+
+int advance_replay_time(int seconds){
+
+    replay_time = replay_time + seconds;
+
+    return replay_time;
+}
+
+int get_system_time(){
+
+    if(replay_time != 0)
+        return replay_time;
+
+    return (int)time(NULL);
+}
+
+unsigned int get_clock_time_in_ms(){
+
+#ifdef _WIN32
+    return GetTickCount();
+#elif __unix__
+    struct timespec current_time;
+    clock_gettime(CLOCK_MONOTONIC, &current_time);
+    return (unsigned int)current_time.tv_sec * 1000 +
+           current_time.tv_nsec / 1000000;
+#endif
+}
+
+void sleep_t(int wait_time){
+
+#ifdef _WIN32
+    Sleep(wait_time);
+#elif __unix__
+    usleep(wait_time * 1000);
+#endif
+}
+
+char *strtok_save(char *str, char *delim, char **saveptr){
+
+    char *tmp;
+
+    if(str == NULL)
+        tmp = *saveptr;
+    else
+        tmp = str;
+
+    if(strncmp(tmp, delim, strlen(delim)) == 0){
+        *saveptr += strlen(delim) * sizeof(char);
+        return NULL;
+    }
+
+#ifdef _WIN32
+    return strtok_s(str, delim, saveptr);
+#elif __unix__
+    return strtok_r(str, delim, saveptr);
+#endif
+}
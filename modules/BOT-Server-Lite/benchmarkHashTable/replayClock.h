@@ -0,0 +1,71 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     replayClock.h
+
+  File Description:
+
+     This file contains the declarations of the replay clock used by the
+     tools which replay tracking data into the area hashtables of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The tools replaying tracking data link the replay clock in place of
+     BeDIS.c. It provides the time functions of BeDIS.c used by the area
+     hashtables, and lets the tools set the epoch time seen by the server,
+     so that hours of tracking data are replayed in seconds. The monotonic
+     clock and sleep_t stay real, as the tools measure with them.
+*/
+
+#ifndef REPLAY_CLOCK_H
+#define REPLAY_CLOCK_H
+
+#include "BeDIS.h"
+
+/*
+  set_replay_time:
+
+     This function sets the epoch time returned by get_system_time. Until it
+     is called, get_system_time returns the real time.
+
+  Parameters:
+
+     time_in_sec - the time in epoch seconds
+
+  Return value:
+
+     None
+*/
+void set_replay_time(int time_in_sec);
+
+/*
+  advance_replay_time:
+
+     This function advances the epoch time returned by get_system_time.
+
+  Parameters:
+
+     seconds - the number of seconds to advance
+
+  Return value:
+
+     int - the new time in epoch seconds
+*/
+int advance_replay_time(int seconds);
+
+#endif
@@ -0,0 +1,122 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     replayDatabase.c
+
+  File Description:
+
+     This file contains the implementation of the replay database used by
+     the tools which replay tracking data into the area hashtables of BOT
+     server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The functions below replace the functions of SqlWrapper.c with the same
+     names, so a tool links either this file or SqlWrapper.c.
+*/
+
+#include "replayDatabase.h"
+
+/* The function receiving each uploaded line, or NULL */
+static ReplayUploadHandler upload_handler = NULL;
+
+/* The number of rows uploaded to object_summary_table and to
+   location_history_table, protected by upload_lock */
+static long uploaded_summary_rows = 0;
+static long uploaded_history_rows = 0;
+static pthread_mutex_t upload_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*
+Reads the uploaded file back and passes each line to the handler.
+*/
+
+static ErrorCode replay_upload_file(char *filename, bool is_history){
+
+    FILE *file;
+    char line[LENGTH_OF_REPLAY_UPLOAD_LINE];
+    long number_rows = 0;
+
+    file = fopen(filename, "r");
+    if(file == NULL)
+        return E_OPEN_FILE;
+
+    while(fgets(line, sizeof(line), file) != NULL){
+
+        number_rows++;
+
+        if(upload_handler != NULL)
+            upload_handler(line, is_history);
+    }
+
+    fclose(file);
+
+    pthread_mutex_lock(&upload_lock);
+
+    if(is_history)
+        uploaded_history_rows += number_rows;
+    else
+        uploaded_summary_rows += number_rows;
+
+    pthread_mutex_unlock(&upload_lock);
+
+    return WORK_SUCCESSFULLY;
+}
+
+void set_replay_upload_handler(ReplayUploadHandler handler){
+
+    upload_handler = handler;
+}
+
+long get_replay_uploaded_rows(bool is_history){
+
+    long number_rows;
+
+    pthread_mutex_lock(&upload_lock);
+
+    if(is_history)
+        number_rows = uploaded_history_rows;
+    else
+        number_rows = uploaded_summary_rows;
+
+    pthread_mutex_unlock(&upload_lock);
+
+    return number_rows;
+}
+
+ErrorCode SQL_upload_hashtable_summarize(
+    DBConnectionListHead *db_connection_list_head,
+    char* filename,
+    int number_of_rssi_signals_under_tracked){
+
+    return replay_upload_file(filename, false);
+}
+
+ErrorCode SQL_upload_location_history(
+    DBConnectionListHead *db_connection_list_head,
+    char* filename){
+
+    return replay_upload_file(filename, true);
+}
+
+ErrorCode SQL_identify_panic_status(
+    DBConnectionListHead *db_connection_list_head,
+    char* object_mac_address){
+
+    return WORK_SUCCESSFULLY;
+}
@@ -0,0 +1,81 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     replayDatabase.h
+
+  File Description:
+
+     This file contains the declarations of the replay database used by the
+     tools which replay tracking data into the area hashtables of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The tools replaying tracking data link the replay database in place of
+     SqlWrapper.c. It provides the functions of SqlWrapper.c called by the
+     area hashtables. Instead of uploading the files written by the server,
+     it reads them back line by line, counts the uploaded rows, and passes
+     each line to a function set by the tool.
+*/
+
+#ifndef REPLAY_DATABASE_H
+#define REPLAY_DATABASE_H
+
+#include "SqlWrapper.h"
+
+/* Maximum number of characters of one line of an uploaded file */
+#define LENGTH_OF_REPLAY_UPLOAD_LINE 1024
+
+/* The function receiving each line of the uploaded files. The flag tells
+whether the line is uploaded to location_history_table or to
+object_summary_table. */
+typedef void (*ReplayUploadHandler)(char *line, bool is_history);
+
+/*
+  set_replay_upload_handler:
+
+     This function sets the function receiving each line of the uploaded
+     files. It may be called from several uploading threads at the same
+     time.
+
+  Parameters:
+
+     handler - the function, or NULL to only count the lines
+
+  Return value:
+
+     None
+*/
+void set_replay_upload_handler(ReplayUploadHandler handler);
+
+/*
+  get_replay_uploaded_rows:
+
+     This function returns the number of rows uploaded so far.
+
+  Parameters:
+
+     is_history - true for the rows of location_history_table, false for the
+                  rows of object_summary_table
+
+  Return value:
+
+     long - the number of rows
+*/
+long get_replay_uploaded_rows(bool is_history);
+
+#endif
@@ -0,0 +1,572 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     benchmarkMempool.c
+
+  File Description:
+
+     This file contains the implementation of the benchmark tool of memory 
+     pool.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The benchmark tool runs the following benchmarks against both the memory
+     pool and the allocator of the C runtime library:
+
+     single_thread     - alloc/free pairs in one thread
+     multi_thread      - alloc/free pairs in N threads sharing one allocator
+     producer_consumer - one thread allocates and N threads free, as the 
+                         receive thread and worker threads of BOT server do
+     expansion         - allocations from a small memory pool which has to 
+                         expand under pressure
+
+     Each result is written as one CSV line:
+
+     benchmark,allocator,threads,operations,elapsed_ms,ops_per_sec,
+     failed_allocs,peak_used_slots,expand_times
+*/
+
+#include "benchmarkMempool.h"
+
+/* The settings and state shared by the producer and consumer threads */
+typedef struct {
+
+    BenchmarkContext *context;
+
+    BenchmarkQueue *queue;
+
+} ProducerConsumerArgument;
+
+
+double get_time_in_ms(){
+
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (double)tv.tv_sec * 1000.0 + (double)tv.tv_usec / 1000.0;
+#endif
+}
+
+static void *benchmark_alloc(BenchmarkContext *context){
+
+    void *mem;
+
+    if(context->allocator == ALLOCATOR_MEMPOOL)
+        mem = mp_alloc(context->mp);
+    else
+        mem = malloc(context->allocation_size);
+
+    if(mem == NULL){
+        context->failed_allocs++;
+        return NULL;
+    }
+
+    /* Touch the memory as the callers in BOT server do */
+    *(char *)mem = 0;
+
+    return mem;
+}
+
+static void benchmark_free(BenchmarkContext *context, void *mem){
+
+    if(context->allocator == ALLOCATOR_MEMPOOL)
+        mp_free(context->mp, mem);
+    else
+        free(mem);
+}
+
+static void init_result(BenchmarkResult *result,
+                        const char *benchmark,
+                        BenchmarkAllocator allocator,
+                        int threads,
+                        long long operations){
+
+    memset(result, 0, sizeof(BenchmarkResult));
+
+    result->benchmark = benchmark;
+    result->allocator = BenchmarkAllocator_String[allocator];
+    result->threads = threads;
+    result->operations = operations;
+}
+
+static void collect_mempool_statistics(BenchmarkAllocator allocator,
+                                       Memory_Pool *mp,
+                                       BenchmarkResult *result){
+
+    MemoryPoolStatistics stats;
+
+    if(allocator != ALLOCATOR_MEMPOOL)
+        return;
+
+    mp_get_statistics(mp, &stats);
+
+    result->peak_used_slots = stats.peak_used_slots;
+    result->expand_times = stats.expand_times;
+}
+
+static void *run_alloc_free_pairs(void *_context){
+
+    BenchmarkContext *context = (BenchmarkContext *)_context;
+    void *batch[BENCHMARK_BATCH_SIZE];
+    int done = 0;
+    int batch_size;
+    int i;
+
+    /* Hold a small batch of allocations before freeing them, so that the 
+       allocator cannot simply hand back the block which was just freed */
+    while(done < context->operations){
+
+        batch_size = context->operations - done;
+        if(batch_size > BENCHMARK_BATCH_SIZE)
+            batch_size = BENCHMARK_BATCH_SIZE;
+
+        for(i = 0; i < batch_size; i++)
+            batch[i] = benchmark_alloc(context);
+
+        for(i = 0; i < batch_size; i++){
+            if(batch[i] != NULL)
+                benchmark_free(context, batch[i]);
+        }
+
+        done += batch_size;
+    }
+
+    return (void *)NULL;
+}
+
+void benchmark_single_thread(BenchmarkAllocator allocator,
+                             size_t allocation_size,
+                             int operations,
+                             BenchmarkResult *result){
+
+    Memory_Pool mp;
+    BenchmarkContext context;
+    double start_time;
+
+    init_result(result, "single_thread", allocator, 1, operations);
+
+    if(allocator == ALLOCATOR_MEMPOOL && 
+       MEMORY_POOL_SUCCESS != mp_init(&mp, 
+                                      allocation_size, 
+                                      SLOTS_IN_BENCHMARK_MEM_POOL)){
+        result->failed_allocs = operations;
+        return;
+    }
+
+    memset(&context, 0, sizeof(BenchmarkContext));
+    context.allocator = allocator;
+    context.mp = &mp;
+    context.allocation_size = allocation_size;
+    context.operations = operations;
+
+    start_time = get_time_in_ms();
+
+    run_alloc_free_pairs(&context);
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+    result->failed_allocs = context.failed_allocs;
+
+    collect_mempool_statistics(allocator, &mp, result);
+
+    if(allocator == ALLOCATOR_MEMPOOL)
+        mp_destroy(&mp);
+}
+
+void benchmark_multi_thread(BenchmarkAllocator allocator,
+                            size_t allocation_size,
+                            int operations,
+                            int number_threads,
+                            BenchmarkResult *result){
+
+    Memory_Pool mp;
+    BenchmarkContext contexts[MAX_BENCHMARK_THREADS];
+    pthread_t threads[MAX_BENCHMARK_THREADS];
+    double start_time;
+    int i;
+
+    init_result(result, "multi_thread", allocator, number_threads, 
+                (long long)operations * number_threads);
+
+    if(allocator == ALLOCATOR_MEMPOOL && 
+       MEMORY_POOL_SUCCESS != mp_init(&mp, 
+                                      allocation_size, 
+                                      SLOTS_IN_BENCHMARK_MEM_POOL)){
+        result->failed_allocs = operations;
+        return;
+    }
+
+    for(i = 0; i < number_threads; i++){
+        memset(&contexts[i], 0, sizeof(BenchmarkContext));
+        contexts[i].allocator = allocator;
+        contexts[i].mp = &mp;
+        contexts[i].allocation_size = allocation_size;
+        contexts[i].operations = operations;
+    }
+
+    start_time = get_time_in_ms();
+
+    for(i = 0; i < number_threads; i++){
+        pthread_create(&threads[i], NULL, run_alloc_free_pairs, &contexts[i]);
+    }
+
+    for(i = 0; i < number_threads; i++){
+        pthread_join(threads[i], NULL);
+        result->failed_allocs += contexts[i].failed_allocs;
+    }
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+
+    collect_mempool_statistics(allocator, &mp, result);
+
+    if(allocator == ALLOCATOR_MEMPOOL)
+        mp_destroy(&mp);
+}
+
+static void *run_producer(void *_argument){
+
+    ProducerConsumerArgument *argument = 
+        (ProducerConsumerArgument *)_argument;
+    BenchmarkQueue *queue = argument->queue;
+    void *mem;
+    int i;
+
+    for(i = 0; i < argument->context->operations; i++){
+
+        mem = benchmark_alloc(argument->context);
+        if(mem == NULL)
+            continue;
+
+        pthread_mutex_lock(&queue->lock);
+
+        while(queue->count == BENCHMARK_QUEUE_SIZE)
+            pthread_cond_wait(&queue->not_full, &queue->lock);
+
+        queue->items[(queue->head + queue->count) % BENCHMARK_QUEUE_SIZE] = 
+            mem;
+        queue->count++;
+
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    queue->is_closed = 1;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+
+    return (void *)NULL;
+}
+
+static void *run_consumer(void *_argument){
+
+    ProducerConsumerArgument *argument = 
+        (ProducerConsumerArgument *)_argument;
+    BenchmarkQueue *queue = argument->queue;
+    void *mem;
+
+    while(1){
+
+        pthread_mutex_lock(&queue->lock);
+
+        while(queue->count == 0 && queue->is_closed == 0)
+            pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+        if(queue->count == 0){
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+
+        mem = queue->items[queue->head];
+        queue->head = (queue->head + 1) % BENCHMARK_QUEUE_SIZE;
+        queue->count--;
+
+        pthread_cond_signal(&queue->not_full);
+        pthread_mutex_unlock(&queue->lock);
+
+        benchmark_free(argument->context, mem);
+    }
+
+    return (void *)NULL;
+}
+
+void benchmark_producer_consumer(BenchmarkAllocator allocator,
+                                 size_t allocation_size,
+                                 int operations,
+                                 int number_threads,
+                                 BenchmarkResult *result){
+
+    Memory_Pool mp;
+    BenchmarkContext context;
+    BenchmarkQueue *queue;
+    ProducerConsumerArgument argument;
+    pthread_t producer;
+    pthread_t consumers[MAX_BENCHMARK_THREADS];
+    double start_time;
+    int i;
+
+    init_result(result, "producer_consumer", allocator, number_threads + 1, 
+                operations);
+
+    queue = calloc(1, sizeof(BenchmarkQueue));
+    if(queue == NULL){
+        result->failed_allocs = operations;
+        return;
+    }
+
+    if(allocator == ALLOCATOR_MEMPOOL && 
+       MEMORY_POOL_SUCCESS != mp_init(&mp, 
+                                      allocation_size, 
+                                      SLOTS_IN_BENCHMARK_MEM_POOL)){
+        free(queue);
+        result->failed_allocs = operations;
+        return;
+    }
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+
+    memset(&context, 0, sizeof(BenchmarkContext));
+    context.allocator = allocator;
+    context.mp = &mp;
+    context.allocation_size = allocation_size;
+    context.operations = operations;
+
+    argument.context = &context;
+    argument.queue = queue;
+
+    start_time = get_time_in_ms();
+
+    for(i = 0; i < number_threads; i++){
+        pthread_create(&consumers[i], NULL, run_consumer, &argument);
+    }
+    pthread_create(&producer, NULL, run_producer, &argument);
+
+    pthread_join(producer, NULL);
+    for(i = 0; i < number_threads; i++){
+        pthread_join(consumers[i], NULL);
+    }
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+    result->failed_allocs = context.failed_allocs;
+
+    collect_mempool_statistics(allocator, &mp, result);
+
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue);
+
+    if(allocator == ALLOCATOR_MEMPOOL)
+        mp_destroy(&mp);
+}
+
+void benchmark_expansion(BenchmarkAllocator allocator,
+                         size_t allocation_size,
+                         BenchmarkResult *result){
+
+    Memory_Pool mp;
+    BenchmarkContext context;
+    void **held;
+    int operations;
+    int count = 0;
+    double start_time;
+    int i;
+
+    /* The number of slots the memory pool holds after it expands 
+       MAX_EXP_TIME times, each time by the initial number of slots */
+    operations = SLOTS_IN_EXPANSION_BENCHMARK_MEM_POOL * MAX_EXP_TIME;
+
+    init_result(result, "expansion", allocator, 1, operations);
+
+    held = malloc(sizeof(void *) * operations);
+    if(held == NULL){
+        result->failed_allocs = operations;
+        return;
+    }
+
+    if(allocator == ALLOCATOR_MEMPOOL && 
+       MEMORY_POOL_SUCCESS != mp_init(&mp, 
+                                      allocation_size, 
+                                      SLOTS_IN_EXPANSION_BENCHMARK_MEM_POOL)){
+        free(held);
+        result->failed_allocs = operations;
+        return;
+    }
+
+    memset(&context, 0, sizeof(BenchmarkContext));
+    context.allocator = allocator;
+    context.mp = &mp;
+    context.allocation_size = allocation_size;
+    context.operations = operations;
+
+    start_time = get_time_in_ms();
+
+    for(i = 0; i < operations; i++){
+        held[count] = benchmark_alloc(&context);
+        if(held[count] != NULL)
+            count++;
+    }
+
+    for(i = 0; i < count; i++){
+        benchmark_free(&context, held[i]);
+    }
+
+    result->elapsed_ms = get_time_in_ms() - start_time;
+    result->failed_allocs = context.failed_allocs;
+
+    collect_mempool_statistics(allocator, &mp, result);
+
+    free(held);
+
+    if(allocator == ALLOCATOR_MEMPOOL)
+        mp_destroy(&mp);
+}
+
+void print_result(FILE *output, BenchmarkResult *result){
+
+    double ops_per_sec = 0;
+
+    if(result->elapsed_ms > 0)
+        ops_per_sec = result->operations * 1000.0 / result->elapsed_ms;
+
+    fprintf(output, "%s,%s,%d,%lld,%.3f,%.0f,%d,%d,%d\n",
+            result->benchmark,
+            result->allocator,
+            result->threads,
+            result->operations,
+            result->elapsed_ms,
+            ops_per_sec,
+            result->failed_allocs,
+            result->peak_used_slots,
+            result->expand_times);
+}
+
+void display_usage(){
+    printf("\n");
+    printf("benchmarkMempool [-s allocation_size] [-n operations] " \
+           "[-t threads] [-o output_file]\n");
+    printf("\n");
+    printf("-s: specify the size in bytes of each allocation. " \
+           "The default value is %d\n", DEFAULT_BENCHMARK_ALLOCATION_SIZE);
+    printf("-n: specify the number of operations of each thread. " \
+           "The default value is %d\n", DEFAULT_BENCHMARK_OPERATIONS);
+    printf("-t: specify the number of threads in the multi-thread " \
+           "benchmarks. The default value is %d\n", 
+           DEFAULT_BENCHMARK_THREADS);
+    printf("-o: specify the CSV file to which results are appended. " \
+           "Results are written to the standard output if not specified\n");
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int ch;
+    size_t allocation_size = DEFAULT_BENCHMARK_ALLOCATION_SIZE;
+    int operations = DEFAULT_BENCHMARK_OPERATIONS;
+    int number_threads = DEFAULT_BENCHMARK_THREADS;
+    char *output_file = NULL;
+    FILE *output = stdout;
+    BenchmarkResult result;
+    int allocator;
+
+    while((ch = getopt(argc, argv, "s:n:t:o:h")) != -1){
+        switch(ch){
+            case 's':
+                allocation_size = atoi(optarg);
+                break;
+            case 'n':
+                operations = atoi(optarg);
+                break;
+            case 't':
+                number_threads = atoi(optarg);
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'h':
+                display_usage();
+                return 1;
+            case '?':
+                return -1;
+            default:
+                return -1;
+        }
+    }
+
+    if(allocation_size < MEMORY_POOL_MINIMUM_SIZE || operations <= 0 ||
+       number_threads <= 0 || number_threads > MAX_BENCHMARK_THREADS){
+        display_usage();
+        return -1;
+    }
+
+    if(output_file != NULL){
+        output = fopen(output_file, "a+");
+        if(output == NULL){
+            printf("Cannot open the output file %s\n", output_file);
+            return -1;
+        }
+    }else{
+        fprintf(output, "benchmark,allocator,threads,operations," \
+                "elapsed_ms,ops_per_sec,failed_allocs,peak_used_slots," \
+                "expand_times\n");
+    }
+
+    for(allocator = 0; allocator < ALLOCATOR_MAX; allocator++){
+
+        benchmark_single_thread((BenchmarkAllocator)allocator, 
+                                allocation_size, 
+                                operations, 
+                                &result);
+        print_result(output, &result);
+
+        benchmark_multi_thread((BenchmarkAllocator)allocator, 
+                               allocation_size, 
+                               operations, 
+                               number_threads, 
+                               &result);
+        print_result(output, &result);
+
+        benchmark_producer_consumer((BenchmarkAllocator)allocator, 
+                                    allocation_size, 
+                                    operations, 
+                                    number_threads, 
+                                    &result);
+        print_result(output, &result);
+
+        benchmark_expansion((BenchmarkAllocator)allocator, 
+                            allocation_size, 
+                            &result);
+        print_result(output, &result);
+    }
+
+    if(output != stdout)
+        fclose(output);
+
+    return 0;
+}
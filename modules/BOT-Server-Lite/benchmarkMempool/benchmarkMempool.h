@@ -0,0 +1,278 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     benchmarkMempool.h
+
+  File Description:
+
+     This file contains the definitions and declarations of constants,
+     structures, and functions used in the benchmark tool of memory pool.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The benchmark tool measures the throughput of the memory pool used by 
+     BOT server under the allocation patterns of the server, and compares the 
+     results against the allocator of the C runtime library. The results are 
+     written in CSV format so that they can be tracked across releases.
+*/
+
+#ifndef BENCHMARK_MEMPOOL_H
+#define BENCHMARK_MEMPOOL_H
+
+#include "getopt.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "Mempool.h"
+
+/* The size in bytes of each allocation. It is the size of a buffer node 
+   header of BOT server on 64-bit platforms. */
+#define DEFAULT_BENCHMARK_ALLOCATION_SIZE 128
+
+/* The number of alloc/free pairs executed by each thread */
+#define DEFAULT_BENCHMARK_OPERATIONS 1000000
+
+/* The number of worker threads in the multi-thread benchmarks */
+#define DEFAULT_BENCHMARK_THREADS 4
+
+/* The number of slots in the memory pool for the benchmarks which do not 
+   measure expansion */
+#define SLOTS_IN_BENCHMARK_MEM_POOL 2048
+
+/* The number of slots in the memory pool for the expansion benchmark. It is
+   kept small so that the memory pool expands up to MAX_EXP_TIME times. */
+#define SLOTS_IN_EXPANSION_BENCHMARK_MEM_POOL 64
+
+/* The number of allocations each thread holds before freeing them in the 
+   alloc/free pair benchmarks */
+#define BENCHMARK_BATCH_SIZE 64
+
+/* The maximum number of worker threads */
+#define MAX_BENCHMARK_THREADS 64
+
+/* The capacity of the queue between the producer and the consumers */
+#define BENCHMARK_QUEUE_SIZE 4096
+
+/* The allocators to be measured */
+typedef enum _BenchmarkAllocator {
+
+    ALLOCATOR_MEMPOOL = 0,
+    ALLOCATOR_MALLOC = 1,
+    ALLOCATOR_MAX
+
+} BenchmarkAllocator;
+
+/* Readable names of the allocators used in the benchmark output */
+const char * const BenchmarkAllocator_String[] = {
+
+    "mempool",
+
+    "malloc"
+};
+
+/* The settings shared by all benchmarks */
+typedef struct {
+
+    BenchmarkAllocator allocator;
+
+    Memory_Pool *mp;
+
+    size_t allocation_size;
+
+    int operations;
+
+    /* The number of allocations failed during the benchmark */
+    int failed_allocs;
+
+} BenchmarkContext;
+
+/* A bounded queue used to pass allocations from the producer thread to the
+   consumer threads, in the same way as the receive thread of BOT server 
+   passes buffer nodes to the worker threads */
+typedef struct {
+
+    pthread_mutex_t lock;
+
+    pthread_cond_t not_empty;
+
+    pthread_cond_t not_full;
+
+    void *items[BENCHMARK_QUEUE_SIZE];
+
+    int head;
+
+    int count;
+
+    /* A flag indicating that the producer will not push any more items */
+    int is_closed;
+
+} BenchmarkQueue;
+
+/* The result of a single benchmark */
+typedef struct {
+
+    const char *benchmark;
+
+    const char *allocator;
+
+    int threads;
+
+    long long operations;
+
+    double elapsed_ms;
+
+    int failed_allocs;
+
+    int peak_used_slots;
+
+    int expand_times;
+
+} BenchmarkResult;
+
+
+/*
+  get_time_in_ms:
+
+     This function returns a monotonic timestamp in milliseconds with 
+     sub-millisecond resolution.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     double - the timestamp in milliseconds
+*/
+double get_time_in_ms();
+
+/*
+  benchmark_single_thread:
+
+     This function measures alloc/free pairs executed by the calling thread.
+
+  Parameters:
+
+     allocator - the allocator to be measured
+     allocation_size - the size in bytes of each allocation
+     operations - the number of alloc/free pairs
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_single_thread(BenchmarkAllocator allocator,
+                             size_t allocation_size,
+                             int operations,
+                             BenchmarkResult *result);
+
+/*
+  benchmark_multi_thread:
+
+     This function measures alloc/free pairs executed concurrently by 
+     several threads sharing the same allocator.
+
+  Parameters:
+
+     allocator - the allocator to be measured
+     allocation_size - the size in bytes of each allocation
+     operations - the number of alloc/free pairs of each thread
+     number_threads - the number of threads
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_multi_thread(BenchmarkAllocator allocator,
+                            size_t allocation_size,
+                            int operations,
+                            int number_threads,
+                            BenchmarkResult *result);
+
+/*
+  benchmark_producer_consumer:
+
+     This function measures allocations made by a producer thread and freed 
+     by consumer threads.
+
+  Parameters:
+
+     allocator - the allocator to be measured
+     allocation_size - the size in bytes of each allocation
+     operations - the number of allocations made by the producer
+     number_threads - the number of consumer threads
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_producer_consumer(BenchmarkAllocator allocator,
+                                 size_t allocation_size,
+                                 int operations,
+                                 int number_threads,
+                                 BenchmarkResult *result);
+
+/*
+  benchmark_expansion:
+
+     This function measures allocations from a memory pool which has to 
+     expand repeatedly, holding every allocation until the pool is exhausted.
+
+  Parameters:
+
+     allocator - the allocator to be measured
+     allocation_size - the size in bytes of each allocation
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void benchmark_expansion(BenchmarkAllocator allocator,
+                         size_t allocation_size,
+                         BenchmarkResult *result);
+
+/*
+  print_result:
+
+     This function writes a benchmark result as a CSV line.
+
+  Parameters:
+
+     output - the file to be written
+     result - the pointer to the result of the benchmark
+
+  Return value:
+
+     None
+*/
+void print_result(FILE *output, BenchmarkResult *result);
+
+#endif
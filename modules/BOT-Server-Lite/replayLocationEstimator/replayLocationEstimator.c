@@ -0,0 +1,703 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     replayLocationEstimator.c
+
+  File Description:
+
+     This file contains the implementation of the replay tool of the location
+     estimators of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The replay tool replays a recording of rssi signals with each location
+     estimator, selected by the -e option, or all of them. The recording is
+     given by the -f option, or written by the tool before the replays.
+
+     Each result is written as one CSV line:
+
+     estimator,kernel,objects,seconds,located,mean_error_mm,rmse_mm,
+     ns_per_object
+
+     where kernel is the summary kernel the tool is built with.
+*/
+
+#include "replayLocationEstimator.h"
+
+/* The key of an object, used to find the object of a row of the hashtable */
+typedef struct {
+
+    uint64_t key;
+
+    int object;
+
+} ReplayObjectKey;
+
+/* The state of an object while a recording is written */
+typedef struct {
+
+    double x;
+    double y;
+
+    /* The distance the object walks in one second along each axis */
+    double step_x;
+    double step_y;
+
+} ReplayWalker;
+
+
+double get_time_in_ms(){
+
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (double)tv.tv_sec * 1000.0 + (double)tv.tv_usec / 1000.0;
+#endif
+}
+
+/*
+Returns the next number of a linear congruential generator, so that every
+run writes the same recording.
+*/
+
+static unsigned int replay_random(unsigned int *seed){
+
+    *seed = *seed * 1103515245 + 12345;
+
+    return (*seed >> 8) & 0xFFFFFF;
+}
+
+/*
+Returns a uniform random number in (0, 1).
+*/
+
+static double replay_uniform(unsigned int *seed){
+
+    return ((double)replay_random(seed) + 0.5) / (double)0x1000000;
+}
+
+/*
+Returns a normal random number with mean 0 and standard deviation 1 by the
+Box-Muller transform.
+*/
+
+static double replay_gaussian(unsigned int *seed){
+
+    double u1 = replay_uniform(seed);
+    double u2 = replay_uniform(seed);
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * 3.14159265358979 * u2);
+}
+
+uint64_t get_replay_key(int object){
+
+    /* Multiplying by an odd number is a bijection of the 48-bit values */
+    return ((uint64_t)(object + 1) * 0x9E3779B97F4A7C15ULL) &
+           REPLAY_MAC_ADDRESS_MASK;
+}
+
+/*
+Turns a walking object to a random direction.
+*/
+
+static void turn_walker(ReplayWalker *walker, unsigned int *seed){
+
+    double angle = 2.0 * 3.14159265358979 * replay_uniform(seed);
+
+    walker->step_x = REPLAY_WALKING_SPEED_IN_MM_PER_SEC * cos(angle);
+    walker->step_y = REPLAY_WALKING_SPEED_IN_MM_PER_SEC * sin(angle);
+}
+
+/*
+Walks an object for one second. The object turns back at the edges of the
+grid of lbeacons.
+*/
+
+static void walk_walker(ReplayWalker *walker){
+
+    double max_x = (REPLAY_LBEACONS_IN_ONE_ROW - 1) *
+                   REPLAY_LBEACON_SPACING_IN_MM;
+    double max_y = (REPLAY_LBEACONS / REPLAY_LBEACONS_IN_ONE_ROW - 1) *
+                   REPLAY_LBEACON_SPACING_IN_MM;
+
+    walker->x += walker->step_x;
+    walker->y += walker->step_y;
+
+    if(walker->x < 0 || walker->x > max_x){
+        walker->step_x = -walker->step_x;
+        walker->x += 2 * walker->step_x;
+    }
+
+    if(walker->y < 0 || walker->y > max_y){
+        walker->step_y = -walker->step_y;
+        walker->y += 2 * walker->step_y;
+    }
+}
+
+ErrorCode write_recording(ReplaySettings *settings){
+
+    FILE *file;
+    ReplayWalker *walkers;
+    unsigned int seed = 1;
+    double max_x = (REPLAY_LBEACONS_IN_ONE_ROW - 1) *
+                   REPLAY_LBEACON_SPACING_IN_MM;
+    double max_y = (REPLAY_LBEACONS / REPLAY_LBEACONS_IN_ONE_ROW - 1) *
+                   REPLAY_LBEACON_SPACING_IN_MM;
+    double lbeacon_x;
+    double lbeacon_y;
+    double distance;
+    int timestamp;
+    int second;
+    int object;
+    int rssi;
+    int i;
+
+    walkers = (ReplayWalker *)malloc(sizeof(ReplayWalker) *
+                                     settings->number_objects);
+    if(walkers == NULL)
+        return E_MALLOC;
+
+    file = fopen(settings->recording_file, "w");
+    if(file == NULL){
+        free(walkers);
+        return E_OPEN_FILE;
+    }
+
+    for(object = 0; object < settings->number_objects; object++){
+
+        walkers[object].x = max_x * replay_uniform(&seed);
+        walkers[object].y = max_y * replay_uniform(&seed);
+        walkers[object].step_x = 0;
+        walkers[object].step_y = 0;
+    }
+
+    fprintf(file, "timestamp,object,lbeacon_uuid,rssi,x_in_mm,y_in_mm\n");
+
+    for(second = 0; second < settings->number_seconds; second++){
+
+        timestamp = REPLAY_START_TIME + second;
+
+        for(object = 0; object < settings->number_objects; object++){
+
+            if(object % 2 == 0){
+
+                if(second % REPLAY_WALKING_TURN_IN_SEC == 0)
+                    turn_walker(&walkers[object], &seed);
+
+                walk_walker(&walkers[object]);
+            }
+
+            for(i = 0; i < REPLAY_LBEACONS; i++){
+
+                lbeacon_x = (i % REPLAY_LBEACONS_IN_ONE_ROW) *
+                            REPLAY_LBEACON_SPACING_IN_MM;
+                lbeacon_y = (i / REPLAY_LBEACONS_IN_ONE_ROW) *
+                            REPLAY_LBEACON_SPACING_IN_MM;
+
+                distance = sqrt((walkers[object].x - lbeacon_x) *
+                                (walkers[object].x - lbeacon_x) +
+                                (walkers[object].y - lbeacon_y) *
+                                (walkers[object].y - lbeacon_y));
+
+                if(distance > REPLAY_MAX_SCANNING_DISTANCE_IN_MM)
+                    continue;
+
+                // objects closer than 10 cm are as strong as at 10 cm
+                if(distance < 100)
+                    distance = 100;
+
+                rssi = (int)floor(REPLAY_RSSI_AT_ONE_METER -
+                                  10.0 * REPLAY_PATH_LOSS_EXPONENT *
+                                  log10(distance / 1000.0) +
+                                  REPLAY_RSSI_NOISE *
+                                  replay_gaussian(&seed) + 0.5);
+
+                if(rssi < REPLAY_MIN_RSSI)
+                    continue;
+
+                fprintf(file, "%d,%d,%04d00000000%08d0000%08d,%d,%d,%d\n",
+                        timestamp,
+                        object,
+                        REPLAY_AREA_ID,
+                        (int)lbeacon_x,
+                        (int)lbeacon_y,
+                        rssi,
+                        (int)floor(walkers[object].x + 0.5),
+                        (int)floor(walkers[object].y + 0.5));
+            }
+        }
+    }
+
+    fclose(file);
+    free(walkers);
+
+    return WORK_SUCCESSFULLY;
+}
+
+static int compare_object_keys(const void *a, const void *b){
+
+    const ReplayObjectKey *key_a = (const ReplayObjectKey *)a;
+    const ReplayObjectKey *key_b = (const ReplayObjectKey *)b;
+
+    if(key_a->key < key_b->key)
+        return -1;
+    if(key_a->key > key_b->key)
+        return 1;
+    return 0;
+}
+
+/*
+Summarizes the hashtable once with the replay settings, as the summary
+thread does every second.
+*/
+
+static void summarize_replay_area(HashTable *h_table){
+
+    hashtable_summarize_location_information(
+        h_table,
+        REPLAY_RSSI_THRESHOLD,
+        REPLAY_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+        REPLAY_UNREASONABLE_RSSI_CHANGE,
+        REPLAY_RSSI_WEIGHT_MULTIPLIER,
+        REPLAY_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE,
+        REPLAY_BASE_LOCATION_TOLERANCE_IN_MILLIMETER);
+}
+
+/*
+Summarizes the hashtable after one second of the recording. After the
+warm-up, the time of the summary pass is added to the result, and the
+locations of the objects scanned in the second are compared with their true
+locations.
+*/
+
+static void replay_second(HashTable *h_table,
+                          ReplayObjectKey *keys,
+                          int number_objects,
+                          int *scanned_timestamps,
+                          int *true_x,
+                          int *true_y,
+                          int timestamp,
+                          bool is_counted,
+                          ReplayResult *result){
+
+    hash_table_row row_summary;
+    ReplayObjectKey *found;
+    ReplayObjectKey search;
+    double start_time;
+    double elapsed_ms;
+    double error;
+    int summarized_objects = 0;
+    int object;
+    int i;
+
+    start_time = get_time_in_ms();
+
+    summarize_replay_area(h_table);
+
+    elapsed_ms = get_time_in_ms() - start_time;
+
+    if(!is_counted)
+        return;
+
+    for(i = 0; i < h_table->row_count; i++){
+
+        if(!hashtable_get_row_summary(hashtable_get_row(h_table, i),
+                                      &row_summary))
+            continue;
+
+        summarized_objects++;
+
+        if(row_summary.summary_lbeacon_id == LBEACON_ID_UNKNOWN)
+            continue;
+
+        search.key = row_summary.mac_address;
+        found = (ReplayObjectKey *)bsearch(&search,
+                                           keys,
+                                           number_objects,
+                                           sizeof(ReplayObjectKey),
+                                           compare_object_keys);
+        if(found == NULL)
+            continue;
+
+        object = found->object;
+        if(scanned_timestamps[object] != timestamp)
+            continue;
+
+        error = sqrt((row_summary.summary_coordinateX - true_x[object]) *
+                     (row_summary.summary_coordinateX - true_x[object]) +
+                     (row_summary.summary_coordinateY - true_y[object]) *
+                     (row_summary.summary_coordinateY - true_y[object]));
+
+        result->located++;
+        result->sum_error += error;
+        result->sum_square_error += error * error;
+    }
+
+    result->seconds++;
+    result->summarized_objects += summarized_objects;
+    result->summary_ms += elapsed_ms;
+}
+
+ErrorCode replay_recording(ReplaySettings *settings,
+                           const char *estimator,
+                           ReplayResult *result){
+
+    FILE *file;
+    HashTable *h_table;
+    ReplayObjectKey *keys;
+    int *scanned_timestamps;
+    int *true_x;
+    int *true_y;
+    char line[LENGTH_OF_REPLAY_RECORDING_LINE];
+    char uuid[LENGTH_OF_UUID];
+    DataForHashtable data_row;
+    int first_timestamp = 0;
+    int current_timestamp = 0;
+    int timestamp;
+    int object;
+    int rssi;
+    int x;
+    int y;
+    int lbeacon_id;
+
+    memset(result, 0, sizeof(ReplayResult));
+    result->estimator = estimator;
+    result->objects = settings->number_objects;
+
+    if(WORK_SUCCESSFULLY != select_location_estimator(estimator))
+        return E_INPUT_PARAMETER;
+
+    file = fopen(settings->recording_file, "r");
+    if(file == NULL)
+        return E_OPEN_FILE;
+
+    keys = (ReplayObjectKey *)malloc(sizeof(ReplayObjectKey) *
+                                     settings->number_objects);
+    scanned_timestamps = (int *)calloc(settings->number_objects, sizeof(int));
+    true_x = (int *)malloc(sizeof(int) * settings->number_objects);
+    true_y = (int *)malloc(sizeof(int) * settings->number_objects);
+    h_table = hashtable_new_default(destroy_value_part);
+
+    if(keys == NULL || scanned_timestamps == NULL || true_x == NULL ||
+       true_y == NULL || h_table == NULL){
+
+        free(keys);
+        free(scanned_timestamps);
+        free(true_x);
+        free(true_y);
+        if(h_table != NULL)
+            hashtable_destroy(h_table);
+        fclose(file);
+        return E_MALLOC;
+    }
+
+    for(object = 0; object < settings->number_objects; object++){
+        keys[object].key = get_replay_key(object);
+        keys[object].object = object;
+    }
+
+    qsort(keys, settings->number_objects, sizeof(ReplayObjectKey),
+          compare_object_keys);
+
+    memset(&data_row, 0, sizeof(DataForHashtable));
+    strcpy(data_row.battery_voltage, "12");
+    strcpy(data_row.panic_button, "0");
+
+    while(fgets(line, sizeof(line), file) != NULL){
+
+        if(sscanf(line, "%d,%d,%32[^,],%d,%d,%d",
+                  &timestamp, &object, uuid, &rssi, &x, &y) != 6)
+            continue;
+
+        if(object < 0 || object >= settings->number_objects)
+            continue;
+
+        if(timestamp != current_timestamp){
+
+            if(current_timestamp != 0){
+                replay_second(h_table,
+                              keys,
+                              settings->number_objects,
+                              scanned_timestamps,
+                              true_x,
+                              true_y,
+                              current_timestamp,
+                              current_timestamp - first_timestamp >=
+                              REPLAY_WARMUP_SECONDS,
+                              result);
+            }else{
+                first_timestamp = timestamp;
+            }
+
+            current_timestamp = timestamp;
+            set_replay_time(current_timestamp);
+        }
+
+        lbeacon_id = lbeacon_registry_intern(uuid);
+        if(lbeacon_id == LBEACON_ID_UNKNOWN)
+            continue;
+
+        data_row.lbeacon_id = lbeacon_id;
+        data_row.initial_timestamp_GMT = timestamp;
+        data_row.final_timestamp_GMT = timestamp;
+        data_row.rssi = rssi;
+
+        hashtable_put_new_tracking_data(
+            h_table,
+            get_replay_key(object),
+            &data_row,
+            REPLAY_NUMBER_OF_LBEACONS_UNDER_TRACKED,
+            REPLAY_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+            REPLAY_RSSI_THRESHOLD,
+            REPLAY_UNREASONABLE_RSSI_CHANGE);
+
+        scanned_timestamps[object] = timestamp;
+        true_x[object] = x;
+        true_y[object] = y;
+    }
+
+    if(current_timestamp != 0){
+        replay_second(h_table,
+                      keys,
+                      settings->number_objects,
+                      scanned_timestamps,
+                      true_x,
+                      true_y,
+                      current_timestamp,
+                      current_timestamp - first_timestamp >=
+                      REPLAY_WARMUP_SECONDS,
+                      result);
+    }
+
+    hashtable_destroy(h_table);
+    free(keys);
+    free(scanned_timestamps);
+    free(true_x);
+    free(true_y);
+    fclose(file);
+
+    return WORK_SUCCESSFULLY;
+}
+
+void print_result(FILE *output, ReplayResult *result){
+
+    double mean_error = 0;
+    double rmse = 0;
+    double ns_per_object = 0;
+
+    if(result->located > 0){
+        mean_error = result->sum_error / result->located;
+        rmse = sqrt(result->sum_square_error / result->located);
+    }
+
+    if(result->summarized_objects > 0)
+        ns_per_object = result->summary_ms * 1000000.0 /
+                        result->summarized_objects;
+
+    fprintf(output, "%s,%s,%d,%d,%lld,%.1f,%.1f,%.1f\n",
+            result->estimator,
+            SUMMARY_KERNEL_NAME,
+            result->objects,
+            result->seconds,
+            result->located,
+            mean_error,
+            rmse,
+            ns_per_object);
+}
+
+/*
+Opens the log of the server, which the hashtables write their errors to.
+*/
+
+static ErrorCode init_replay_log(){
+
+    if(zlog_init(REPLAY_ZLOG_CONFIG_FILE_NAME) != 0)
+        return E_OPEN_FILE;
+
+    category_health_report = zlog_get_category(LOG_CATEGORY_HEALTH_REPORT);
+    category_debug = zlog_get_category(LOG_CATEGORY_DEBUG);
+    category_dump = zlog_get_category(LOG_CATEGORY_DUMP_TRACKING);
+
+    if(category_health_report == NULL || category_debug == NULL ||
+       category_dump == NULL){
+
+        zlog_fini();
+        return E_OPEN_FILE;
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+void display_usage(){
+    printf("\n");
+    printf("replayLocationEstimator [-f recording_file] [-n objects] " \
+           "[-s seconds] [-e estimator] [-o output_file]\n");
+    printf("\n");
+    printf("-f: specify the recording to be replayed. A recording is " \
+           "written to %s if not specified\n", DEFAULT_REPLAY_RECORDING_FILE);
+    printf("-n: specify the number of objects of the recording. " \
+           "The default value is %d\n", DEFAULT_REPLAY_OBJECTS);
+    printf("-s: specify the number of seconds of the written recording. " \
+           "The default value is %d\n", DEFAULT_REPLAY_SECONDS);
+    printf("-e: specify the location estimator to replay, i.e., centroid " \
+           "or kalman. All estimators are replayed if not specified\n");
+    printf("-o: specify the CSV file to which results are appended. " \
+           "Results are written to the standard output if not specified\n");
+    printf("\n");
+    printf("The tool reads %s, and is run from the installation " \
+           "directory of BOT server\n", REPLAY_ZLOG_CONFIG_FILE_NAME);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int ch;
+    char *recording_file = NULL;
+    char *estimator = NULL;
+    char *output_file = NULL;
+    FILE *output = stdout;
+    ReplaySettings settings;
+    ReplayResult result;
+    ErrorCode return_value;
+    int i;
+
+    memset(&settings, 0, sizeof(ReplaySettings));
+    settings.number_objects = DEFAULT_REPLAY_OBJECTS;
+    settings.number_seconds = DEFAULT_REPLAY_SECONDS;
+
+    while((ch = getopt(argc, argv, "f:n:s:e:o:h")) != -1){
+        switch(ch){
+            case 'f':
+                recording_file = optarg;
+                break;
+            case 'n':
+                settings.number_objects = atoi(optarg);
+                break;
+            case 's':
+                settings.number_seconds = atoi(optarg);
+                break;
+            case 'e':
+                estimator = optarg;
+                break;
+            case 'o':
+                output_file = optarg;
+                break;
+            case 'h':
+                display_usage();
+                return 1;
+            case '?':
+                return -1;
+            default:
+                return -1;
+        }
+    }
+
+    if(settings.number_objects <= 0 || settings.number_seconds <= 0){
+        display_usage();
+        return -1;
+    }
+
+    if(recording_file == NULL)
+        strcpy(settings.recording_file, DEFAULT_REPLAY_RECORDING_FILE);
+    else
+        strncpy(settings.recording_file, recording_file, MAX_PATH - 1);
+
+    if(WORK_SUCCESSFULLY != init_replay_log()){
+        printf("Cannot open the log with %s\n", REPLAY_ZLOG_CONFIG_FILE_NAME);
+        return -1;
+    }
+
+    if(WORK_SUCCESSFULLY != initialize_lbeacon_registry() ||
+       WORK_SUCCESSFULLY !=
+       update_rssi_weight_table(REPLAY_RSSI_WEIGHT_MULTIPLIER)){
+
+        printf("Cannot initialize the lbeacons\n");
+        zlog_fini();
+        return -1;
+    }
+
+    if(recording_file == NULL &&
+       WORK_SUCCESSFULLY != write_recording(&settings)){
+
+        printf("Cannot write the recording %s\n", settings.recording_file);
+        destroy_rssi_weight_table();
+        destroy_lbeacon_registry();
+        zlog_fini();
+        return -1;
+    }
+
+    if(output_file != NULL){
+        output = fopen(output_file, "a+");
+        if(output == NULL){
+            printf("Cannot open the output file %s\n", output_file);
+            destroy_rssi_weight_table();
+            destroy_lbeacon_registry();
+            zlog_fini();
+            return -1;
+        }
+    }else{
+        fprintf(output, "estimator,kernel,objects,seconds,located," \
+                "mean_error_mm,rmse_mm,ns_per_object\n");
+    }
+
+    for(i = 0; i < REPLAY_ESTIMATORS; i++){
+
+        if(estimator == NULL){
+            return_value = replay_recording(&settings,
+                                            ReplayEstimator_String[i],
+                                            &result);
+        }else{
+            return_value = replay_recording(&settings, estimator, &result);
+        }
+
+        if(return_value == E_INPUT_PARAMETER){
+            display_usage();
+            break;
+        }
+
+        if(return_value != WORK_SUCCESSFULLY){
+            printf("Cannot replay the recording %s\n",
+                   settings.recording_file);
+            break;
+        }
+
+        print_result(output, &result);
+
+        if(estimator != NULL)
+            break;
+    }
+
+    if(output != stdout)
+        fclose(output);
+
+    destroy_rssi_weight_table();
+    destroy_lbeacon_registry();
+    zlog_fini();
+
+    return (return_value == WORK_SUCCESSFULLY) ? 0 : -1;
+}
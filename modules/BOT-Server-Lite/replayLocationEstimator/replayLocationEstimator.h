@@ -0,0 +1,260 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     replayLocationEstimator.h
+
+  File Description:
+
+     This file contains the definitions and declarations of constants,
+     structures, and functions used in the replay tool of the location
+     estimators of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The replay tool puts a recording of rssi signals, together with the
+     true locations of the objects, into the hashtable of an area second by
+     second, and summarizes the area after each second with every location
+     estimator in turn. It reports the error of the locations summarized by
+     each estimator and the time the summary passes took for each object.
+     Without a recording, the tool first records objects walking among
+     lbeacons on a grid, with rssi signals of a log-distance path loss
+     model. The database is replaced by the replay database, and the time
+     of the server by the replay clock.
+*/
+
+#ifndef REPLAY_LOCATION_ESTIMATOR_H
+#define REPLAY_LOCATION_ESTIMATOR_H
+
+#include <math.h>
+
+#include "getopt.h"
+
+#include "HashTable.h"
+#include "LBeaconRegistry.h"
+#include "LocationEstimator.h"
+#include "replayClock.h"
+#include "replayDatabase.h"
+
+/* The configuration file of zlog, the same as BOT server */
+#define REPLAY_ZLOG_CONFIG_FILE_NAME "./config/zlog.conf"
+
+/* The recording written when no recording is given */
+#define DEFAULT_REPLAY_RECORDING_FILE "./temp/rssi_recording.csv"
+
+/* The number of objects and the number of seconds of the recording written
+   when no recording is given. The objects of a given recording have
+   indexes below the number of objects. */
+#define DEFAULT_REPLAY_OBJECTS 1000
+#define DEFAULT_REPLAY_SECONDS 60
+
+/* The number of seconds at the start of the recording whose locations are
+   not counted, while the rings of rssi signals fill up */
+#define REPLAY_WARMUP_SECONDS 10
+
+/* Maximum number of characters of one line of a recording */
+#define LENGTH_OF_REPLAY_RECORDING_LINE 256
+
+/* The area id of the lbeacons of the written recording */
+#define REPLAY_AREA_ID 1
+
+/* The lbeacons of the written recording are placed on a grid of
+   REPLAY_LBEACONS_IN_ONE_ROW columns spaced REPLAY_LBEACON_SPACING_IN_MM
+   apart */
+#define REPLAY_LBEACONS 100
+#define REPLAY_LBEACONS_IN_ONE_ROW 10
+#define REPLAY_LBEACON_SPACING_IN_MM 5000
+
+/* The objects of the written recording with even indexes walk at
+   REPLAY_WALKING_SPEED_IN_MM_PER_SEC and change their direction every
+   REPLAY_WALKING_TURN_IN_SEC seconds. The others stand still. */
+#define REPLAY_WALKING_SPEED_IN_MM_PER_SEC 1000
+#define REPLAY_WALKING_TURN_IN_SEC 10
+
+/* The log-distance path loss model of the written recording, i.e., the rssi
+   at one meter, the path loss exponent and the standard deviation of the
+   noise in dBm. An lbeacon scans the objects within
+   REPLAY_MAX_SCANNING_DISTANCE_IN_MM whose rssi is not below
+   REPLAY_MIN_RSSI. */
+#define REPLAY_RSSI_AT_ONE_METER -55.0
+#define REPLAY_PATH_LOSS_EXPONENT 2.0
+#define REPLAY_RSSI_NOISE 4.0
+#define REPLAY_MAX_SCANNING_DISTANCE_IN_MM 8000.0
+#define REPLAY_MIN_RSSI -95
+
+/* The settings of the server used by the replay. They are the values
+   shipped in server.conf. */
+#define REPLAY_NUMBER_OF_LBEACONS_UNDER_TRACKED 16
+#define REPLAY_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED 10
+#define REPLAY_RSSI_THRESHOLD -70
+#define REPLAY_UNREASONABLE_RSSI_CHANGE 15
+#define REPLAY_RSSI_WEIGHT_MULTIPLIER 3
+#define REPLAY_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE 5
+#define REPLAY_BASE_LOCATION_TOLERANCE_IN_MILLIMETER 500
+
+/* The epoch time at which the written recording starts */
+#define REPLAY_START_TIME 1600000000
+
+/* The mask of the 48 bits of a MAC address */
+#define REPLAY_MAC_ADDRESS_MASK 0xFFFFFFFFFFFFULL
+
+/* The location estimators replayed when none is given by the -e option */
+#define REPLAY_ESTIMATORS 2
+
+const char * const ReplayEstimator_String[] = {
+
+    LOCATION_ESTIMATOR_CENTROID,
+    LOCATION_ESTIMATOR_KALMAN
+};
+
+/* The settings of the replay */
+typedef struct {
+
+    /* The number of objects, and the number of seconds written to a new
+       recording */
+    int number_objects;
+    int number_seconds;
+
+    /* The recording to be replayed */
+    char recording_file[MAX_PATH];
+
+} ReplaySettings;
+
+/* The result of the replay of one location estimator */
+typedef struct {
+
+    const char *estimator;
+
+    int objects;
+
+    /* The number of seconds replayed */
+    int seconds;
+
+    /* The number of locations compared with the true locations, and the sums
+       of their errors and of the squares of their errors in millimeters */
+    long long located;
+    double sum_error;
+    double sum_square_error;
+
+    /* The number of objects summarized by all passes, and the time of the
+       passes */
+    long long summarized_objects;
+    double summary_ms;
+
+} ReplayResult;
+
+
+/*
+  get_time_in_ms:
+
+     This function returns a monotonic timestamp in milliseconds with
+     sub-millisecond resolution.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     double - the timestamp in milliseconds
+*/
+double get_time_in_ms();
+
+/*
+  get_replay_key:
+
+     This function returns the binary MAC address of an object. The MAC
+     addresses of different objects are different and scattered over the
+     48 bits.
+
+  Parameters:
+
+     object - the index of the object
+
+  Return value:
+
+     uint64_t - the binary MAC address
+*/
+uint64_t get_replay_key(int object);
+
+/*
+  write_recording:
+
+     This function writes a recording of objects walking among the lbeacons
+     of a grid. Each line of the recording is one rssi signal of an object
+     scanned by an lbeacon:
+
+     timestamp,object,lbeacon_uuid,rssi,x_in_mm,y_in_mm
+
+     where x_in_mm and y_in_mm are the true location of the object at the
+     timestamp. The lines are in the order of their timestamps.
+
+  Parameters:
+
+     settings - the settings of the replay
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_OPEN_FILE: cannot write the recording
+                 E_MALLOC: cannot allocate the objects
+*/
+ErrorCode write_recording(ReplaySettings *settings);
+
+/*
+  replay_recording:
+
+     This function puts the rssi signals of the recording into a new
+     hashtable, and summarizes the hashtable with the location estimator
+     after each second of the recording. The locations of the objects
+     scanned in the second are then compared with their true locations.
+
+  Parameters:
+
+     settings - the settings of the replay
+     estimator - the name of the location estimator
+     result - the pointer to the result of the replay
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_INPUT_PARAMETER: the location estimator is not known
+                 E_OPEN_FILE: cannot read the recording
+                 E_MALLOC: cannot allocate the hashtable or the objects
+*/
+ErrorCode replay_recording(ReplaySettings *settings,
+                           const char *estimator,
+                           ReplayResult *result);
+
+/*
+  print_result:
+
+     This function writes the result of the replay of one location
+     estimator as a CSV line, together with the name of the summary kernel.
+
+  Parameters:
+
+     output - the file to be written
+     result - the pointer to the result of the replay
+
+  Return value:
+
+     None
+*/
+void print_result(FILE *output, ReplayResult *result);
+
+#endif
@@ -0,0 +1,1196 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     testHashTable.c
+
+  File Description:
+
+     This file contains the implementation of the test tool of the area
+     hashtables and the buffer nodes of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The test tool runs the following tests, selected by the -t option, or
+     all of them:
+
+     hashtable - puts, summaries, uploads and evictions of objects in the
+                 hashtable of an area, and the reuse of the released rows
+     dispatcher - buffer nodes of all payload sizes dispatched from the
+                  buffer lists to the worker threads
+     seqlock - copies of rows taken without locks while the rows are
+               updated
+     running_rssi - the running averages of rssi signals against the
+                    average computed from the whole ring
+
+     Each test prints one line, PASS or FAIL with the reason, and the tool
+     returns the number of failed tests.
+*/
+
+#include "testHashTable.h"
+
+/* The state of each thread of the seqlock test */
+typedef struct {
+
+    HashTable *h_table;
+
+    /* The first value written by a writer thread */
+    int first_value;
+
+    /* The number of updates or copies of rows made by the thread */
+    long long operations;
+
+    /* The number of torn copies found by a reader thread */
+    long long torn;
+
+} SeqlockArgument;
+
+/* The settings of the rssi filter used by the running rssi test */
+typedef struct {
+
+    int number_of_rssi_signals_under_tracked;
+
+    int rssi_threashold_for_summarize_location_pin;
+
+    int unreasonable_rssi_change;
+
+} RssiFilterSettings;
+
+/* The settings of the rssi filter the running rssi test goes through. The
+   first are the settings shipped in server.conf. */
+static const RssiFilterSettings running_rssi_settings[] = {
+
+    {10, -70, 15},
+    {10, -60, 15},
+    {10, -70, 5},
+    {5, -70, 15},
+    {20, -80, 30},
+    {1, -70, 15},
+    {MAX_NUMBER_OF_RSSI_SIGNAL_UNDER_TRACKING, -90, 10},
+    {10, -70, 15}
+};
+
+/* The number of buffer nodes processed and the number of buffer nodes found
+   corrupted by the handler of the dispatcher test */
+static volatile long processed_nodes = 0;
+static volatile long corrupted_nodes = 0;
+
+/* A flag telling the threads of the seqlock test to stop */
+static volatile bool seqlock_stopped = false;
+
+
+uint64_t get_test_key(int object){
+
+    /* Multiplying by an odd number is a bijection of the 48-bit values */
+    return ((uint64_t)(object + 1) * 0x9E3779B97F4A7C15ULL) &
+           TEST_MAC_ADDRESS_MASK;
+}
+
+/*
+Interns the lbeacons of the tests, placed on a grid in the tested area, in
+the lbeacon registry.
+*/
+
+static ErrorCode init_test_lbeacons(TestSettings *settings){
+
+    char uuid[LENGTH_OF_UUID];
+    int i;
+
+    for(i = 0; i < TEST_LBEACONS; i++){
+
+        sprintf(uuid, "%04d00000000%08d0000%08d",
+                TEST_AREA_ID,
+                (i % TEST_LBEACONS_IN_ONE_ROW) * TEST_LBEACON_SPACING_IN_MM,
+                (i / TEST_LBEACONS_IN_ONE_ROW) * TEST_LBEACON_SPACING_IN_MM);
+
+        settings->lbeacon_ids[i] = lbeacon_registry_intern(uuid);
+        if(settings->lbeacon_ids[i] == LBEACON_ID_UNKNOWN)
+            return E_MALLOC;
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+void put_test_objects(TestSettings *settings,
+                      HashTable *h_table,
+                      int first_object,
+                      int number_objects){
+
+    DataForHashtable data_row;
+    int current_time = get_system_time();
+    int object;
+    int k;
+
+    memset(&data_row, 0, sizeof(DataForHashtable));
+
+    data_row.initial_timestamp_GMT = current_time;
+    data_row.final_timestamp_GMT = current_time;
+    strcpy(data_row.battery_voltage, "12");
+    strcpy(data_row.panic_button, "0");
+
+    for(object = first_object;
+        object < first_object + number_objects;
+        object++){
+
+        for(k = 0; k < TEST_LBEACONS_PER_OBJECT; k++){
+
+            data_row.lbeacon_id =
+                settings->lbeacon_ids[(object + k) % TEST_LBEACONS];
+            data_row.rssi = -50 - k * 5;
+
+            hashtable_put_new_tracking_data(
+                h_table,
+                get_test_key(object),
+                &data_row,
+                TEST_NUMBER_OF_LBEACONS_UNDER_TRACKED,
+                TEST_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+                TEST_RSSI_THRESHOLD,
+                TEST_UNREASONABLE_RSSI_CHANGE);
+        }
+    }
+}
+
+/*
+Counts the objects found in the hashtable, and the objects among them which
+have been located by a summary pass.
+*/
+
+static int count_test_objects(HashTable *h_table,
+                              int first_object,
+                              int number_objects,
+                              int *located_objects){
+
+    HashShard *shard;
+    hash_table_row *table_row;
+    hash_table_row row_summary;
+    uint64_t key;
+    int found = 0;
+    int object;
+
+    *located_objects = 0;
+
+    for(object = first_object;
+        object < first_object + number_objects;
+        object++){
+
+        key = get_test_key(object);
+        shard = hashtable_get_shard(h_table, key);
+
+        pthread_rwlock_rdlock(&shard->shard_lock);
+
+        table_row = hashtable_find_row(h_table, key);
+
+        if(table_row != NULL){
+
+            found++;
+
+            if(hashtable_get_row_summary(table_row, &row_summary) &&
+               row_summary.summary_lbeacon_id != LBEACON_ID_UNKNOWN)
+                (*located_objects)++;
+        }
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+    }
+
+    return found;
+}
+
+static void summarize_test_area(HashTable *h_table){
+
+    hashtable_summarize_location_information(
+        h_table,
+        TEST_RSSI_THRESHOLD,
+        TEST_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED,
+        TEST_UNREASONABLE_RSSI_CHANGE,
+        TEST_RSSI_WEIGHT_MULTIPLIER,
+        TEST_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE,
+        TEST_BASE_LOCATION_TOLERANCE_IN_MILLIMETER);
+}
+
+/*
+Checks that every object keeps a record of each lbeacon scanning it, and 
+that no overflow block of records was refused by the overflow memory pool.
+*/
+
+static bool check_test_records(TestSettings *settings,
+                               HashTable *h_table,
+                               int first_object){
+
+    HashShard *shard;
+    hash_table_row *table_row;
+    hash_table_row row_summary;
+    MemoryPoolStatistics stats;
+    uint64_t key;
+    int number_records;
+    int object;
+
+    for(object = first_object; object < first_object + TEST_OBJECTS; 
+        object++){
+
+        key = get_test_key(object);
+        shard = hashtable_get_shard(h_table, key);
+
+        pthread_rwlock_rdlock(&shard->shard_lock);
+
+        number_records = -1;
+
+        table_row = hashtable_find_row(h_table, key);
+        if(table_row != NULL &&
+           hashtable_get_row_summary(table_row, &row_summary))
+            number_records = row_summary.number_uuid_records;
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+
+        if(number_records != TEST_LBEACONS_PER_OBJECT){
+            sprintf(settings->failure,
+                    "object %d has %d records of %d lbeacons",
+                    object, number_records, TEST_LBEACONS_PER_OBJECT);
+            return false;
+        }
+    }
+
+    mp_get_statistics(&h_table->overflow_mempool, &stats);
+
+    if(stats.failed_allocs != 0){
+        sprintf(settings->failure,
+                "%d overflow blocks are refused for %d objects",
+                stats.failed_allocs, TEST_OBJECTS);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+Puts the objects into the hashtable, summarizes and uploads them, and checks
+that every object keeps all its records, and is located and uploaded once 
+to each table.
+*/
+
+static bool put_and_summarize_test_objects(TestSettings *settings,
+                                           HashTable *h_table,
+                                           int first_object){
+
+    int found;
+    int located;
+    long summary_rows;
+    long history_rows;
+
+    put_test_objects(settings, h_table, first_object, TEST_OBJECTS);
+
+    if(!check_test_records(settings, h_table, first_object))
+        return false;
+
+    summarize_test_area(h_table);
+
+    found = count_test_objects(h_table, first_object, TEST_OBJECTS, &located);
+    if(found != TEST_OBJECTS || located != TEST_OBJECTS){
+        sprintf(settings->failure,
+                "%d of %d objects found and %d located after the summary",
+                found, TEST_OBJECTS, located);
+        return false;
+    }
+
+    summary_rows = get_replay_uploaded_rows(false);
+    history_rows = get_replay_uploaded_rows(true);
+
+    hashtable_upload_location_to_database(
+        h_table,
+        TEST_AREA_ID,
+        NULL,
+        TEST_SERVER_INSTALLATION_PATH,
+        LATEST_LOCATION_INFO,
+        TEST_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED);
+
+    hashtable_upload_location_to_database(
+        h_table,
+        TEST_AREA_ID,
+        NULL,
+        TEST_SERVER_INSTALLATION_PATH,
+        LOCATION_FOR_HISTORY,
+        TEST_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED);
+
+    summary_rows = get_replay_uploaded_rows(false) - summary_rows;
+    history_rows = get_replay_uploaded_rows(true) - history_rows;
+
+    if(summary_rows != TEST_OBJECTS || history_rows != TEST_OBJECTS){
+        sprintf(settings->failure,
+                "%ld summary rows and %ld history rows uploaded " \
+                "for %d objects",
+                summary_rows, history_rows, TEST_OBJECTS);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+Summarizes the hashtable until the objects are evicted, and checks that all
+of them are gone.
+*/
+
+static bool evict_test_objects(TestSettings *settings,
+                               HashTable *h_table,
+                               int first_object){
+
+    unsigned int start_time = get_clock_time_in_ms();
+    int found;
+    int located;
+
+    do{
+        sleep_t(NORMAL_WAITING_TIME_IN_MS);
+
+        summarize_test_area(h_table);
+
+        found = count_test_objects(h_table,
+                                   first_object,
+                                   TEST_OBJECTS,
+                                   &located);
+
+    }while(found != 0 &&
+           get_clock_time_in_ms() - start_time < TEST_TIMEOUT_IN_MS);
+
+    if(found != 0){
+        sprintf(settings->failure,
+                "%d of %d objects are not evicted after %d ms",
+                found, TEST_OBJECTS, TEST_TIMEOUT_IN_MS);
+        return false;
+    }
+
+    return true;
+}
+
+bool test_hashtable(TestSettings *settings){
+
+    HashTable *h_table;
+    char area_time_list[CONFIG_BUFFER_SIZE];
+    int row_count;
+    bool passed = false;
+
+    if(WORK_SUCCESSFULLY != initialize_area_table()){
+        strcpy(settings->failure, "cannot initialize the area table");
+        return false;
+    }
+
+    sprintf(area_time_list, "%d:%d",
+            TEST_AREA_ID, TEST_TOLERANT_NOT_SCANNING_TIME_IN_SEC);
+
+    if(WORK_SUCCESSFULLY !=
+       set_area_tolerant_not_scanning_time(area_time_list)){
+
+        strcpy(settings->failure, "cannot set the tolerant time of the area");
+        destroy_area_table();
+        return false;
+    }
+
+    h_table = hash_table_of_specific_area_id(TEST_AREA_ID);
+    if(h_table == NULL){
+        strcpy(settings->failure, "cannot create the hashtable of the area");
+        destroy_area_table();
+        return false;
+    }
+
+    if(put_and_summarize_test_objects(settings, h_table, 0) &&
+       evict_test_objects(settings, h_table, 0)){
+
+        row_count = h_table->row_count;
+
+        // the new objects take the rows released by the evicted objects
+        if(put_and_summarize_test_objects(settings, h_table, TEST_OBJECTS)){
+
+            if(h_table->row_count != row_count){
+                sprintf(settings->failure,
+                        "%d rows are used for %d objects after eviction",
+                        h_table->row_count, TEST_OBJECTS);
+            }else{
+                passed = evict_test_objects(settings, h_table, TEST_OBJECTS);
+            }
+        }
+    }
+
+    hashtable_report_mempool_statistics();
+
+    destroy_area_table();
+
+    return passed;
+}
+
+/*
+Returns the size of the content of a buffer node of the dispatcher test. The
+sizes cover every payload size class and its boundaries.
+*/
+
+static int get_test_content_size(int node_index){
+
+    static const int content_sizes[] = {
+
+        1, 16, SIZE_OF_SMALL_BUFFER_NODE_PAYLOAD - 1,
+        SIZE_OF_SMALL_BUFFER_NODE_PAYLOAD, 700,
+        SIZE_OF_MEDIUM_BUFFER_NODE_PAYLOAD - 1,
+        SIZE_OF_MEDIUM_BUFFER_NODE_PAYLOAD,
+        SIZE_OF_LARGE_BUFFER_NODE_PAYLOAD - 1
+    };
+
+    return content_sizes[node_index %
+                         (sizeof(content_sizes) / sizeof(content_sizes[0]))];
+}
+
+/*
+Fills the content of a buffer node of the dispatcher test with a pattern
+derived from the index of the node.
+*/
+
+static void fill_test_content(char *content, int node_index, int content_size){
+
+    int i;
+
+    for(i = 0; i < content_size; i++)
+        content[i] = 'a' + (node_index + i) % 26;
+}
+
+/*
+Handles a buffer node of the dispatcher test. The index of the node is kept
+in the port of the node, and the content is checked against the pattern of
+the index before the node is released.
+*/
+
+static void *process_test_node(void *_buffer_node){
+
+    BufferNode *current_node = (BufferNode *)_buffer_node;
+    int node_index = current_node->port;
+    int content_size = get_test_content_size(node_index);
+    int i;
+
+    if(current_node->content_size != content_size ||
+       current_node->content[content_size] != '\0'){
+
+        atomic_increment(&corrupted_nodes);
+
+    }else{
+
+        for(i = 0; i < content_size; i++){
+            if(current_node->content[i] != 'a' + (node_index + i) % 26){
+                atomic_increment(&corrupted_nodes);
+                break;
+            }
+        }
+    }
+
+    release_buffer_node(current_node);
+
+    atomic_increment(&processed_nodes);
+
+    return (void *)NULL;
+}
+
+/*
+Checks that every slot of the buffer node memory pools has been returned.
+*/
+
+static bool check_buffer_node_mempools(TestSettings *settings){
+
+    MemoryPoolStatistics stats;
+    int content_class;
+
+    mp_get_statistics(&node_mempool, &stats);
+
+    if(stats.used_slots != 0){
+        sprintf(settings->failure, "%d buffer nodes are not released",
+                stats.used_slots);
+        return false;
+    }
+
+    for(content_class = 0;
+        content_class < NUMBER_OF_BUFFER_NODE_PAYLOAD_CLASSES;
+        content_class++){
+
+        mp_get_statistics(&node_payload_mempool[content_class], &stats);
+
+        if(stats.used_slots != 0){
+            sprintf(settings->failure,
+                    "%d payloads of class %d are not released",
+                    stats.used_slots, content_class);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool test_dispatcher(TestSettings *settings){
+
+    BufferListHead buffer_lists[TEST_BUFFER_LISTS];
+    BufferListHead *current_head;
+    BufferNode *new_node;
+    char content[WIFI_MESSAGE_LENGTH];
+    pthread_t CommUnit_thread;
+    unsigned int start_time;
+    int content_size;
+    int node_index;
+    int i;
+    bool passed = true;
+
+    processed_nodes = 0;
+    corrupted_nodes = 0;
+
+    memset(&common_config, 0, sizeof(CommonConfig));
+    common_config.number_worker_threads = TEST_NUMBER_WORKER_THREADS;
+    common_config.min_age_out_of_date_packet_in_sec =
+        TEST_MIN_AGE_OUT_OF_DATE_PACKET_IN_SEC;
+    common_config.time_critical_priority = TEST_TIME_CRITICAL_PRIORITY;
+    common_config.high_priority = TEST_HIGH_PRIORITY;
+    common_config.normal_priority = TEST_NORMAL_PRIORITY;
+    common_config.low_priority = TEST_LOW_PRIORITY;
+
+    if(WORK_SUCCESSFULLY !=
+       init_buffer_node_mempools(TEST_SLOTS_IN_MEM_POOL_BUFFER_NODE)){
+
+        strcpy(settings->failure, "cannot initialize the buffer node pools");
+        return false;
+    }
+
+    /* Initialize one buffer list of each priority in the priority list, as
+       the server does */
+    init_buffer(&priority_list_head, (void *) sort_priority_list,
+                common_config.high_priority);
+
+    init_buffer(&buffer_lists[0], (void *) process_test_node,
+                common_config.low_priority);
+    init_buffer(&buffer_lists[1], (void *) process_test_node,
+                common_config.normal_priority);
+    init_buffer(&buffer_lists[2], (void *) process_test_node,
+                common_config.high_priority);
+    init_buffer(&buffer_lists[3], (void *) process_test_node,
+                common_config.time_critical_priority);
+
+    for(i = 0; i < TEST_BUFFER_LISTS; i++){
+        insert_list_tail(&buffer_lists[i].priority_list_entry,
+                         &priority_list_head.priority_list_entry);
+    }
+
+    sort_priority_list(&common_config, &priority_list_head);
+
+    ready_to_work = true;
+    initialization_failed = false;
+    NSI_initialization_complete = true;
+
+    if(pthread_create(&CommUnit_thread, NULL, CommUnit_routine, NULL) != 0){
+        strcpy(settings->failure, "cannot start the communication unit");
+        destroy_buffer_node_mempools();
+        return false;
+    }
+
+    for(node_index = 0; node_index < TEST_BUFFER_NODES; node_index++){
+
+        while(node_index - processed_nodes >= TEST_MAX_PENDING_BUFFER_NODES)
+            sleep_t(1);
+
+        /* Every node starts in the smallest class, so the larger contents
+           move the payload to a larger class */
+        new_node = allocate_buffer_node(1);
+        if(new_node == NULL){
+            sprintf(settings->failure, "cannot allocate buffer node %d",
+                    node_index);
+            passed = false;
+            break;
+        }
+
+        content_size = get_test_content_size(node_index);
+        fill_test_content(content, node_index, content_size);
+
+        if(WORK_SUCCESSFULLY !=
+           set_buffer_node_content(new_node, content, content_size)){
+
+            sprintf(settings->failure, "cannot set the content of node %d",
+                    node_index);
+            release_buffer_node(new_node);
+            passed = false;
+            break;
+        }
+
+        /* The packet handlers pass the current content back, which must be
+           kept as it is */
+        set_buffer_node_content(new_node,
+                                new_node->content,
+                                new_node->content_size);
+
+        new_node->port = node_index;
+        new_node->uptime_at_receive = get_clock_time();
+
+        current_head = &buffer_lists[node_index % TEST_BUFFER_LISTS];
+
+        pthread_mutex_lock(&current_head->list_lock);
+        insert_list_tail(&new_node->buffer_entry, &current_head->list_head);
+        pthread_mutex_unlock(&current_head->list_lock);
+    }
+
+    if(passed){
+
+        start_time = get_clock_time_in_ms();
+
+        while(processed_nodes != TEST_BUFFER_NODES &&
+              get_clock_time_in_ms() - start_time < TEST_TIMEOUT_IN_MS){
+
+            sleep_t(BUSY_WAITING_TIME_IN_PRIORITY_LIST_IN_MS);
+        }
+
+        if(processed_nodes != TEST_BUFFER_NODES){
+            sprintf(settings->failure,
+                    "%ld of %d buffer nodes processed after %d ms",
+                    processed_nodes, TEST_BUFFER_NODES, TEST_TIMEOUT_IN_MS);
+            passed = false;
+        }else if(corrupted_nodes != 0){
+            sprintf(settings->failure,
+                    "%ld of %d buffer nodes are corrupted",
+                    corrupted_nodes, TEST_BUFFER_NODES);
+            passed = false;
+        }
+    }
+
+    /* The communication unit destroys its thread pool, which waits for the
+       worker threads, before it returns */
+    ready_to_work = false;
+    pthread_join(CommUnit_thread, NULL);
+
+    if(passed)
+        passed = check_buffer_node_mempools(settings);
+
+    report_buffer_node_mempool_statistics();
+
+    destroy_buffer_node_mempools();
+
+    return passed;
+}
+
+/*
+Writes the same value to all fields of the summarized location of a row.
+The caller holds node_lock of the row.
+*/
+
+static void write_seqlock_row(hash_table_row *table_row, int value){
+
+    hashtable_begin_row_update(table_row);
+
+    table_row->average_rssi = value;
+    table_row->summary_coordinateX = (float)(value & 0xFFFF);
+    table_row->summary_coordinateY = (float)(value & 0xFFFF);
+    table_row->initial_timestamp = value;
+    table_row->final_timestamp = value;
+    table_row->summary_lbeacon_id = value;
+    sprintf(table_row->battery, "%03d", value % 1000);
+
+    hashtable_end_row_update(table_row);
+}
+
+static void *run_seqlock_writer(void *_argument){
+
+    SeqlockArgument *argument = (SeqlockArgument *)_argument;
+    hash_table_row *table_row;
+    int value = argument->first_value;
+    int row_index;
+
+    while(!seqlock_stopped){
+
+        for(row_index = 0; row_index < TEST_SEQLOCK_ROWS; row_index++){
+
+            table_row = hashtable_get_row(argument->h_table, row_index);
+
+            pthread_mutex_lock(&table_row->node_lock);
+            write_seqlock_row(table_row, value);
+            pthread_mutex_unlock(&table_row->node_lock);
+
+            value++;
+            argument->operations++;
+        }
+    }
+
+    return (void *)NULL;
+}
+
+static void *run_seqlock_reader(void *_argument){
+
+    SeqlockArgument *argument = (SeqlockArgument *)_argument;
+    hash_table_row row_summary;
+    char battery[LENGTH_OF_BATTERY_VOLTAGE];
+    int value;
+    int row_index;
+
+    while(!seqlock_stopped){
+
+        for(row_index = 0; row_index < TEST_SEQLOCK_ROWS; row_index++){
+
+            hashtable_get_row_summary(
+                hashtable_get_row(argument->h_table, row_index),
+                &row_summary);
+
+            value = row_summary.average_rssi;
+            sprintf(battery, "%03d", value % 1000);
+
+            if(row_summary.summary_coordinateX != (float)(value & 0xFFFF) ||
+               row_summary.summary_coordinateY != (float)(value & 0xFFFF) ||
+               row_summary.initial_timestamp != value ||
+               row_summary.final_timestamp != value ||
+               row_summary.summary_lbeacon_id != value ||
+               strcmp(row_summary.battery, battery) != 0){
+
+                argument->torn++;
+            }
+
+            argument->operations++;
+        }
+    }
+
+    return (void *)NULL;
+}
+
+bool test_seqlock(TestSettings *settings){
+
+    HashTable *h_table;
+    HashShard *shard;
+    hash_table_row *table_row;
+    SeqlockArgument arguments[TEST_SEQLOCK_WRITERS + TEST_SEQLOCK_READERS];
+    pthread_t threads[TEST_SEQLOCK_WRITERS + TEST_SEQLOCK_READERS];
+    long long writes = 0;
+    long long reads = 0;
+    long long torn = 0;
+    uint64_t key;
+    int i;
+
+    h_table = hashtable_new_default(destroy_value_part);
+    if(h_table == NULL){
+        strcpy(settings->failure, "cannot create the hashtable");
+        return false;
+    }
+
+    for(i = 0; i < TEST_SEQLOCK_ROWS; i++){
+
+        key = get_test_key(i);
+        shard = hashtable_get_shard(h_table, key);
+
+        pthread_rwlock_wrlock(&shard->shard_lock);
+
+        table_row = hashtable_maintain_key_part(
+            h_table,
+            key,
+            TEST_NUMBER_OF_LBEACONS_UNDER_TRACKED,
+            TEST_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED);
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+
+        // the writers update the rows by their index
+        if(table_row == NULL || table_row->row_index != i){
+            strcpy(settings->failure, "cannot put the rows");
+            hashtable_destroy(h_table);
+            return false;
+        }
+
+        pthread_mutex_lock(&table_row->node_lock);
+        write_seqlock_row(table_row, 0);
+        pthread_mutex_unlock(&table_row->node_lock);
+    }
+
+    seqlock_stopped = false;
+
+    for(i = 0; i < TEST_SEQLOCK_WRITERS + TEST_SEQLOCK_READERS; i++){
+
+        memset(&arguments[i], 0, sizeof(SeqlockArgument));
+        arguments[i].h_table = h_table;
+        arguments[i].first_value = (i + 1) * 1000000;
+
+        pthread_create(&threads[i],
+                       NULL,
+                       i < TEST_SEQLOCK_WRITERS ?
+                       run_seqlock_writer : run_seqlock_reader,
+                       &arguments[i]);
+    }
+
+    sleep_t(TEST_SEQLOCK_DURATION_IN_MS);
+
+    seqlock_stopped = true;
+
+    for(i = 0; i < TEST_SEQLOCK_WRITERS + TEST_SEQLOCK_READERS; i++){
+
+        pthread_join(threads[i], NULL);
+
+        if(i < TEST_SEQLOCK_WRITERS){
+            writes += arguments[i].operations;
+        }else{
+            reads += arguments[i].operations;
+            torn += arguments[i].torn;
+        }
+    }
+
+    hashtable_destroy(h_table);
+
+    if(writes == 0 || reads == 0){
+        sprintf(settings->failure, "%lld writes and %lld reads were made",
+                writes, reads);
+        return false;
+    }
+
+    if(torn != 0){
+        sprintf(settings->failure, "%lld of %lld copies are torn "                 "during %lld writes", torn, reads, writes);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+Returns the next number of a linear congruential generator, so that every
+run puts the same tracking data.
+*/
+
+static unsigned int test_random(unsigned int *seed){
+
+    *seed = *seed * 1103515245 + 12345;
+
+    return (*seed >> 8) & 0xFFFFFF;
+}
+
+/*
+The average of rssi signals computed as get_average_rssi did before the 
+running sums were kept, copied without change with its array of int.
+*/
+
+static int baseline_get_average_rssi(
+    const int *rssi_array,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change){
+
+    int k = 0;
+    int valid_rssi_count = 0;
+    int prev_index = 0;
+    int sum_rssi = 0;
+    int ret_avg_rssi = 0;
+
+    for(k = 0; k < number_of_rssi_signals_under_tracked; k++){
+
+        // ignore the timing at which no rssi signal was scanned
+        if(rssi_array[k] == 0)
+            continue;
+   
+        // ignore weak rssi signals from poor lbeacons
+        if(rssi_array[k] < rssi_threashold_for_summarize_location_pin)
+            continue;
+
+        prev_index = 
+            (k - 1 + number_of_rssi_signals_under_tracked) % 
+            number_of_rssi_signals_under_tracked;
+
+        // ignore abnormal signal
+        if(rssi_array[prev_index] != 0 && 
+           abs(rssi_array[k] - rssi_array[prev_index]) > 
+           unreasonable_rssi_change){
+                        
+            continue;
+        }
+                            
+        sum_rssi += rssi_array[k];
+        valid_rssi_count++; 
+    }
+    if(valid_rssi_count == 0 )
+        return ret_avg_rssi;
+
+    ret_avg_rssi = sum_rssi / valid_rssi_count;
+    return ret_avg_rssi;
+}
+
+/*
+Compares the running average of every record of the objects with the average
+of the baseline. Returns the number of records compared, and adds the number
+of records whose averages differ to the input counter.
+*/
+
+static long check_running_rssi(HashTable *h_table,
+                               const RssiFilterSettings *filter,
+                               long *mismatches){
+
+    HashShard *shard;
+    hash_table_row *table_row;
+    uuid_record_table_row *record;
+    int rssi_array[MAX_NUMBER_OF_RSSI_SIGNAL_UNDER_TRACKING];
+    long checked = 0;
+    uint64_t key;
+    int object;
+    int m;
+    int k;
+
+    for(object = 0; object < TEST_RUNNING_RSSI_OBJECTS; object++){
+
+        key = get_test_key(object);
+        shard = hashtable_get_shard(h_table, key);
+
+        pthread_rwlock_rdlock(&shard->shard_lock);
+
+        table_row = hashtable_find_row(h_table, key);
+
+        if(table_row != NULL){
+
+            pthread_mutex_lock(&table_row->node_lock);
+
+            // the records released since they were written keep their
+            // rings, and are compared as well
+            for(m = 0; m < table_row->number_uuid_records; m++){
+
+                record = get_uuid_record(table_row, m);
+
+                for(k = 0; k < MAX_NUMBER_OF_RSSI_SIGNAL_UNDER_TRACKING; k++)
+                    rssi_array[k] = record->rssi_array[k];
+
+                if(get_record_average_rssi(
+                       record,
+                       filter->number_of_rssi_signals_under_tracked,
+                       filter->rssi_threashold_for_summarize_location_pin,
+                       filter->unreasonable_rssi_change) !=
+                   baseline_get_average_rssi(
+                       rssi_array,
+                       filter->rssi_threashold_for_summarize_location_pin,
+                       filter->number_of_rssi_signals_under_tracked,
+                       filter->unreasonable_rssi_change)){
+
+                    (*mismatches)++;
+                }
+
+                checked++;
+            }
+
+            pthread_mutex_unlock(&table_row->node_lock);
+        }
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+    }
+
+    return checked;
+}
+
+bool test_running_rssi(TestSettings *settings){
+
+    HashTable *h_table;
+    const RssiFilterSettings *filter;
+    DataForHashtable data_row;
+    unsigned int seed = 1;
+    int timestamp = get_system_time();
+    long checked = 0;
+    long mismatches = 0;
+    int number_settings;
+    int setting;
+    int second;
+    int object;
+    int k;
+
+    h_table = hashtable_new_default(destroy_value_part);
+    if(h_table == NULL){
+        strcpy(settings->failure, "cannot create the hashtable");
+        return false;
+    }
+
+    memset(&data_row, 0, sizeof(DataForHashtable));
+    strcpy(data_row.battery_voltage, "12");
+    strcpy(data_row.panic_button, "0");
+
+    number_settings = sizeof(running_rssi_settings) / 
+                      sizeof(running_rssi_settings[0]);
+
+    for(setting = 0; setting < number_settings; setting++){
+
+        filter = &running_rssi_settings[setting];
+
+        // the running sums of the previous settings are not used
+        checked += check_running_rssi(h_table, filter, &mismatches);
+
+        for(second = 0; second < TEST_RUNNING_RSSI_SECONDS; second++){
+
+            timestamp++;
+
+            for(object = 0; object < TEST_RUNNING_RSSI_OBJECTS; object++){
+
+                for(k = 0; k < TEST_LBEACONS_PER_OBJECT; k++){
+
+                    // the lbeacons miss some seconds, so the gaps in the
+                    // rings are filled
+                    if(test_random(&seed) % 8 == 0)
+                        continue;
+
+                    data_row.lbeacon_id =
+                        settings->lbeacon_ids[(object + k) % TEST_LBEACONS];
+                    data_row.initial_timestamp_GMT = timestamp;
+                    data_row.final_timestamp_GMT = timestamp;
+
+                    // the signals swing around the threshold, and jump
+                    // further than the unreasonable change at times
+                    data_row.rssi = -40 - (int)(test_random(&seed) % 50);
+
+                    hashtable_put_new_tracking_data(
+                        h_table,
+                        get_test_key(object),
+                        &data_row,
+                        TEST_NUMBER_OF_LBEACONS_UNDER_TRACKED,
+                        filter->number_of_rssi_signals_under_tracked,
+                        filter->rssi_threashold_for_summarize_location_pin,
+                        filter->unreasonable_rssi_change);
+                }
+            }
+
+            checked += check_running_rssi(h_table, filter, &mismatches);
+        }
+    }
+
+    hashtable_destroy(h_table);
+
+    if(mismatches != 0){
+        sprintf(settings->failure,
+                "%ld of %ld running averages differ from the baseline",
+                mismatches, checked);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+Opens the log of the server, which the tested code writes its errors to.
+*/
+
+static ErrorCode init_test_log(){
+
+    if(zlog_init(TEST_ZLOG_CONFIG_FILE_NAME) != 0)
+        return E_OPEN_FILE;
+
+    category_health_report = zlog_get_category(LOG_CATEGORY_HEALTH_REPORT);
+    category_debug = zlog_get_category(LOG_CATEGORY_DEBUG);
+    category_dump = zlog_get_category(LOG_CATEGORY_DUMP_TRACKING);
+
+    if(category_health_report == NULL || category_debug == NULL ||
+       category_dump == NULL){
+
+        zlog_fini();
+        return E_OPEN_FILE;
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+void display_usage(){
+    printf("\n");
+    printf("testHashTable [-t test]\n");
+    printf("\n");
+    printf("-t: specify the test to run, i.e., hashtable, dispatcher, " \
+           "seqlock or running_rssi. All tests are run if not " \
+           "specified\n");
+    printf("\n");
+    printf("The tool reads %s, and is run from the installation " \
+           "directory of BOT server\n", TEST_ZLOG_CONFIG_FILE_NAME);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int ch;
+    char *test_name = NULL;
+    TestSettings settings;
+    int test;
+    int failed_tests = 0;
+    bool passed;
+
+    memset(&settings, 0, sizeof(TestSettings));
+
+    while((ch = getopt(argc, argv, "t:h")) != -1){
+        switch(ch){
+            case 't':
+                test_name = optarg;
+                break;
+            case 'h':
+                display_usage();
+                return 1;
+            case '?':
+                return -1;
+            default:
+                return -1;
+        }
+    }
+
+    if(test_name != NULL){
+
+        for(test = 0; test < TEST_MAX; test++){
+            if(strcmp(test_name, HashTableTest_String[test]) == 0)
+                break;
+        }
+
+        if(test == TEST_MAX){
+            display_usage();
+            return -1;
+        }
+    }
+
+    if(WORK_SUCCESSFULLY != init_test_log()){
+        printf("Cannot open the log with %s\n", TEST_ZLOG_CONFIG_FILE_NAME);
+        return -1;
+    }
+
+    if(WORK_SUCCESSFULLY != initialize_lbeacon_registry() ||
+       WORK_SUCCESSFULLY != init_test_lbeacons(&settings) ||
+       WORK_SUCCESSFULLY !=
+       update_rssi_weight_table(TEST_RSSI_WEIGHT_MULTIPLIER)){
+
+        printf("Cannot initialize the lbeacons\n");
+        zlog_fini();
+        return -1;
+    }
+
+    for(test = 0; test < TEST_MAX; test++){
+
+        if(test_name != NULL &&
+           strcmp(test_name, HashTableTest_String[test]) != 0)
+            continue;
+
+        settings.failure[0] = '\0';
+
+        switch(test){
+            case TEST_HASHTABLE:
+                passed = test_hashtable(&settings);
+                break;
+            case TEST_DISPATCHER:
+                passed = test_dispatcher(&settings);
+                break;
+            case TEST_SEQLOCK:
+                passed = test_seqlock(&settings);
+                break;
+            case TEST_RUNNING_RSSI:
+                passed = test_running_rssi(&settings);
+                break;
+            default:
+                passed = false;
+                break;
+        }
+
+        if(passed){
+            printf("PASS %s\n", HashTableTest_String[test]);
+        }else{
+            printf("FAIL %s: %s\n", HashTableTest_String[test],
+                   settings.failure);
+            failed_tests++;
+        }
+    }
+
+    destroy_rssi_weight_table();
+    destroy_lbeacon_registry();
+    zlog_fini();
+
+    return failed_tests;
+}
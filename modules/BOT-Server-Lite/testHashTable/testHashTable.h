@@ -0,0 +1,275 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and cnditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     testHashTable.h
+
+  File Description:
+
+     This file contains the definitions and declarations of constants,
+     structures, and functions used in the test tool of the area hashtables
+     and the buffer nodes of BOT server.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     The test tool is built with MEMPOOL_DEBUG defined, so every memory pool
+     used by the tested code checks the redzones and the poisoned slots of
+     its objects, and aborts at the first overflow, write after free, double
+     free or foreign free. Each test drives one path of the server with
+     synthetic data and checks its results, and the tool prints one line
+     for each test and returns the number of failed tests. The database is
+     replaced by the replay database of the benchmark tool.
+*/
+
+#ifndef TEST_HASHTABLE_H
+#define TEST_HASHTABLE_H
+
+#include "getopt.h"
+
+#include "BeDIS.h"
+#include "HashTable.h"
+#include "LBeaconRegistry.h"
+#include "replayDatabase.h"
+
+#ifndef MEMPOOL_DEBUG
+#error "testHashTable is built with MEMPOOL_DEBUG defined"
+#endif
+
+/* The configuration file of zlog, the same as BOT server */
+#define TEST_ZLOG_CONFIG_FILE_NAME "./config/zlog.conf"
+
+/* The installation path of the files uploaded to the replay database. It is
+   empty, as in server.conf, so the files are written under ./temp. */
+#define TEST_SERVER_INSTALLATION_PATH ""
+
+/* The area id of the tested area */
+#define TEST_AREA_ID 1
+
+/* The number of objects in the tested area. They fill more than one summary
+   chunk. */
+#define TEST_OBJECTS 20000
+
+/* The lbeacons are placed on a grid of TEST_LBEACONS_IN_ONE_ROW columns
+   spaced TEST_LBEACON_SPACING_IN_MM apart */
+#define TEST_LBEACONS 64
+#define TEST_LBEACONS_IN_ONE_ROW 8
+#define TEST_LBEACON_SPACING_IN_MM 5000
+
+/* The number of lbeacons scanning each object. It is more than the records
+   of lbeacons kept in a row, so the overflow blocks are used. */
+#define TEST_LBEACONS_PER_OBJECT 6
+
+/* The settings of the server used by the tests. The rssi signals of an
+   object are kept for a short time, so the objects are evicted within
+   seconds. */
+#define TEST_NUMBER_OF_LBEACONS_UNDER_TRACKED 16
+#define TEST_NUMBER_OF_RSSI_SIGNALS_UNDER_TRACKED 2
+#define TEST_RSSI_THRESHOLD -70
+#define TEST_UNREASONABLE_RSSI_CHANGE 15
+#define TEST_RSSI_WEIGHT_MULTIPLIER 3
+#define TEST_RSSI_DIFFERENCE_OF_LOCATION_ACCURACY_TOLERANCE 5
+#define TEST_BASE_LOCATION_TOLERANCE_IN_MILLIMETER 500
+#define TEST_TOLERANT_NOT_SCANNING_TIME_IN_SEC 1
+
+/* The mask of the 48 bits of a MAC address */
+#define TEST_MAC_ADDRESS_MASK 0xFFFFFFFFFFFFULL
+
+/* The settings of the communication unit used by the dispatcher test */
+#define TEST_NUMBER_WORKER_THREADS 4
+#define TEST_MIN_AGE_OUT_OF_DATE_PACKET_IN_SEC 60
+#define TEST_TIME_CRITICAL_PRIORITY -6
+#define TEST_HIGH_PRIORITY -4
+#define TEST_NORMAL_PRIORITY -2
+#define TEST_LOW_PRIORITY 0
+
+/* The number of slots the buffer node memory pools start with. It is small,
+   so the pools expand during the test. */
+#define TEST_SLOTS_IN_MEM_POOL_BUFFER_NODE 64
+
+/* The number of buffer nodes sent through the dispatcher */
+#define TEST_BUFFER_NODES 20000
+
+/* The maximum number of buffer nodes waiting in the buffer lists. The test
+   waits for the worker threads when it is reached. */
+#define TEST_MAX_PENDING_BUFFER_NODES 128
+
+/* The number of buffer lists of the dispatcher test, one for each priority */
+#define TEST_BUFFER_LISTS 4
+
+/* The maximum time in milliseconds a test waits for the worker threads */
+#define TEST_TIMEOUT_IN_MS 30000
+
+/* The number of rows updated by the writers of the seqlock test, the number
+   of writer and reader threads, and the length of the test */
+#define TEST_SEQLOCK_ROWS 64
+#define TEST_SEQLOCK_WRITERS 2
+#define TEST_SEQLOCK_READERS 2
+#define TEST_SEQLOCK_DURATION_IN_MS 3000
+
+/* The number of objects of the running rssi test, and the number of seconds
+   of tracking data put with each settings of the filter */
+#define TEST_RUNNING_RSSI_OBJECTS 200
+#define TEST_RUNNING_RSSI_SECONDS 60
+
+/* The tests which can be selected by the -t option */
+typedef enum _HashTableTest {
+
+    TEST_HASHTABLE = 0,
+    TEST_DISPATCHER = 1,
+    TEST_SEQLOCK = 2,
+    TEST_RUNNING_RSSI = 3,
+    TEST_MAX
+
+} HashTableTest;
+
+/* Readable names of the tests used in the option and the output */
+const char * const HashTableTest_String[] = {
+
+    "hashtable",
+    "dispatcher",
+    "seqlock",
+    "running_rssi"
+};
+
+/* The state shared by the tests */
+typedef struct {
+
+    /* The ids of the lbeacons in the lbeacon registry */
+    int lbeacon_ids[TEST_LBEACONS];
+
+    /* The reason of the failure of the last failed test */
+    char failure[CONFIG_BUFFER_SIZE];
+
+} TestSettings;
+
+
+/*
+  get_test_key:
+
+     This function returns the binary MAC address of an object. The MAC
+     addresses of different objects are different and scattered over the
+     48 bits.
+
+  Parameters:
+
+     object - the index of the object
+
+  Return value:
+
+     uint64_t - the binary MAC address
+*/
+uint64_t get_test_key(int object);
+
+/*
+  put_test_objects:
+
+     This function puts one rssi signal of every object scanned by each of
+     TEST_LBEACONS_PER_OBJECT lbeacons into the hashtable at the current
+     time.
+
+  Parameters:
+
+     settings - the settings of the tests
+     h_table - the hashtable of the tested area
+     first_object - the index of the first object
+     number_objects - the number of objects
+
+  Return value:
+
+     None
+*/
+void put_test_objects(TestSettings *settings,
+                      HashTable *h_table,
+                      int first_object,
+                      int number_objects);
+
+/*
+  test_hashtable:
+
+     This function puts objects into the hashtable of an area, checks that
+     every record of their lbeacons is kept, summarizes and uploads their
+     locations, waits until the objects are evicted by the summary pass, 
+     and puts new objects into the released rows.
+
+  Parameters:
+
+     settings - the settings of the tests
+
+  Return value:
+
+     bool - true if the test passed, false otherwise
+*/
+bool test_hashtable(TestSettings *settings);
+
+/*
+  test_dispatcher:
+
+     This function sends buffer nodes of different payload sizes through
+     the buffer lists of all priorities to the worker threads of the
+     communication unit, and checks that every node reaches its handler
+     intact and is returned to the memory pools.
+
+  Parameters:
+
+     settings - the settings of the tests
+
+  Return value:
+
+     bool - true if the test passed, false otherwise
+*/
+bool test_dispatcher(TestSettings *settings);
+
+/*
+  test_seqlock:
+
+     This function has writer threads update the summarized location of
+     rows under node_lock, while reader threads copy the rows without the
+     lock by hashtable_get_row_summary, as the uploads do. Every update
+     writes the same value to all fields, so a copy with different values
+     is torn.
+
+  Parameters:
+
+     settings - the settings of the tests
+
+  Return value:
+
+     bool - true if the test passed, false otherwise
+*/
+bool test_seqlock(TestSettings *settings);
+
+/*
+  test_running_rssi:
+
+     This function puts random rssi signals with gaps into the records of
+     objects while the settings of the rssi filter change, and compares the
+     average of every record from get_record_average_rssi with the average
+     computed by a copy of get_average_rssi as it was before the running
+     sums were kept. The averages are compared after every second of
+     tracking data and right after each change of the settings.
+
+  Parameters:
+
+     settings - the settings of the tests
+
+  Return value:
+
+     bool - true if the test passed, false otherwise
+*/
+bool test_running_rssi(TestSettings *settings);
+
+#endif
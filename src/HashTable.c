@@ -4,10 +4,138 @@
 
 
 #include "HashTable.h"
+#include "LocationEstimator.h"
 
 // Static function to be used in this file
 
-static uint32_t _hashtable_hash_adler32(const void *buf, size_t buflength);
+static uint32_t _hashtable_hash_mac_address(uint64_t key);
+
+static int _hashtable_insert_slot(HashSlot * slots, 
+                                  int size, 
+                                  HashFunc hash,
+                                  uint64_t key, 
+                                  int row_index);
+
+static int _hashtable_find_slot(HashSlot * slots, 
+                                int size, 
+                                HashFunc hash,
+                                uint64_t key);
+
+static void _hashtable_migrate_slots(HashTable * h_table, 
+                                     HashShard * shard,
+                                     int number_of_slots);
+
+static int _hashtable_resize(HashTable * h_table, HashShard * shard);
+
+static int _hashtable_allocate_row(HashTable * h_table);
+
+static void _hashtable_retire_row(HashTable * h_table, int row_index);
+
+static void _hashtable_reclaim_rows(HashTable * h_table);
+
+static void _hashtable_schedule_row(HashTable * h_table, 
+                                    hash_table_row * table_row,
+                                    int timeout_timestamp,
+                                    int current_time);
+
+static int _area_table_read_lock();
+
+static void _area_table_read_unlock(int epoch);
+
+static void _area_table_synchronize();
+
+static bool _area_table_get_entry(int index, AreaTable * entry);
+
+static bool _area_work_queue_take(AreaWorkQueue *work_queue, 
+                                  AreaWorkItem *item);
+
+static bool _area_work_queue_finish_chunk(AreaWorkQueue *work_queue,
+                                          AreaWorkItem *item);
+
+static void _area_work_queue_finish(AreaWorkQueue *work_queue);
+
+static ErrorCode _location_buffer_reserve(LocationBuffer * buffer, 
+                                          int length);
+
+static void _format_gmt_time(time_t timestamp, char *buf, size_t buf_len);
+
+static bool _is_valid_rssi(const int8_t *rssi_array,
+                           int index,
+                           int number_of_rssi_signals_under_tracked,
+                           int rssi_threashold_for_summarize_location_pin,
+                           int unreasonable_rssi_change);
+
+static bool _record_sums_match(const uuid_record_table_row *record,
+                               int number_of_rssi_signals_under_tracked,
+                               int rssi_threashold_for_summarize_location_pin,
+                               int unreasonable_rssi_change);
+
+static void _record_rebuild_rssi_sums(
+    uuid_record_table_row *record,
+    int number_of_rssi_signals_under_tracked,
+    int rssi_threashold_for_summarize_location_pin,
+    int unreasonable_rssi_change);
+
+static void _record_write_rssi(uuid_record_table_row *record,
+                               int write_index,
+                               int8_t rssi,
+                               int number_of_rssi_signals_under_tracked,
+                               int rssi_threashold_for_summarize_location_pin,
+                               int unreasonable_rssi_change);
+
+static void _summary_batch_apply(
+    HashTable * h_table,
+    SummaryBatch * batch,
+    int current_time,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance);
+
+static void _summary_visit_row(
+    HashTable * h_table,
+    SummaryBatch * batch,
+    hash_table_row * table_row,
+    int current_time,
+    RssiWeightTable * weight_table,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance);
+
+static void _summary_process_wheel_slot(
+    HashTable * h_table,
+    SummaryBatch * batch,
+    TimeoutWheelSlot * slot,
+    int current_time,
+    RssiWeightTable * weight_table,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance);
+
+static void _hashtable_check_urgent_row(
+    HashTable * h_table,
+    hash_table_row * table_row,
+    uuid_record_table_row * record,
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change);
+
+static bool _hashtable_queue_urgent_row(HashTable * h_table,
+                                        const UrgentRow * urgent_row);
+
+static int _compare_urgent_rows(const void * a, const void * b);
+
+static ErrorCode _location_buffer_append_row(
+    LocationBuffer * buffer,
+    hash_table_row * table_row,
+    int area_id,
+    const LocationInfoType location_type,
+    const int number_of_rssi_signals_under_tracked,
+    int current_time);
 
 /*
 static int _hashtable_replace(HashTable * h_table, 
@@ -23,43 +151,127 @@ HashTable * hashtable_new(
     int init_size,
     double max_load,
     double resize_factor,
-    EqualityFunc equal,
     HashFunc hash,
-    DeleteData deleteKey,
     DeleteData deleteValue
 ) {
 
     HashTable * ht = calloc(sizeof(HashTable), 1);
+    int shard_size;
+    bool is_slots_allocated = true;
+    int i;
 
     if (ht != 0) {
-        ht->table = calloc(sizeof(HNode *), init_size);
-        ht->size = init_size;
-        ht->count = 0;
-        ht->equal = equal;
+
+        ma_init(&ht->arena, SIZE_OF_AREA_ARENA_CHUNK);
+
+        shard_size = init_size / NUMBER_OF_HASH_TABLE_SHARDS;
+        if(shard_size < 2)
+            shard_size = 2;
+
+        for(i = 0; i < NUMBER_OF_HASH_TABLE_SHARDS; i++){
+            ht->shards[i].slots = calloc(shard_size, sizeof(HashSlot));
+            if(ht->shards[i].slots == NULL)
+                is_slots_allocated = false;
+        }
+
+        ht->row_chunks = ma_alloc(&ht->arena, sizeof(hash_table_row *) * 
+                                  MAX_ROW_CHUNKS_IN_ONE_HASH_TABLE);
+        ht->row_mutex = ma_alloc(&ht->arena, sizeof(pthread_mutex_t));
+
+        if(!is_slots_allocated || ht->row_chunks == NULL || 
+           ht->row_mutex == NULL ||
+           mp_init_in_arena(&ht->overflow_mempool, 
+                            sizeof(uuid_record_table_row) * 
+                            NUMBER_OF_OVERFLOW_UUID_RECORDS,
+                            SLOTS_IN_OVERFLOW_MEM_POOL,
+                            &ht->arena) != MEMORY_POOL_SUCCESS){
+
+            zlog_error(category_debug, "cannot initialize hashtable memory");
+
+            for(i = 0; i < NUMBER_OF_HASH_TABLE_SHARDS; i++)
+                free(ht->shards[i].slots);
+            ma_destroy(&ht->arena);
+            free(ht);
+            return NULL;
+        }
+
+        for(i = 0; i < NUMBER_OF_HASH_TABLE_SHARDS; i++){
+            ht->shards[i].size = shard_size;
+            ht->shards[i].count = 0;
+            pthread_rwlock_init(&ht->shards[i].shard_lock, NULL);
+        }
+
+        ht->row_count = 0;
+        ht->free_row_index = NO_FREE_ROW;
+        ht->row_epoch = 0;
+        ht->retired_row_index[0] = NO_FREE_ROW;
+        ht->retired_row_index[1] = NO_FREE_ROW;
         ht->hash = hash;
         ht->max_load = max_load;
         ht->resize_factor = resize_factor;
-        ht->deleteKey = deleteKey;
         ht->deleteValue = deleteValue;
-        ht->ht_mutex = malloc(sizeof(pthread_mutex_t));
-        pthread_mutex_init(ht->ht_mutex, 0);
+        ht->tolerant_not_scanning_time_in_sec = 
+            TOLERANT_NOT_SCANNING_TIME_IN_SEC;
+        pthread_mutex_init(ht->row_mutex, 0);
+        pthread_mutex_init(&ht->urgent_mutex, 0);
     }
 
     return ht;
 }
 
+void hashtable_destroy(HashTable * h_table) {
+
+    int i;
+    int j;
+    SummaryChunk * summary_chunk;
+
+    // every row handed out has its node_lock initialized, whether or not 
+    // the row is in use now
+    for (i = 0; i < h_table->row_count; i++)
+        pthread_mutex_destroy(&hashtable_get_row(h_table, i)->node_lock);
+
+    pthread_mutex_destroy(h_table->row_mutex);
+
+    pthread_mutex_destroy(&h_table->urgent_mutex);
+    free(h_table->urgent_rows);
+
+    for(i = 0; i < hashtable_get_number_summary_chunks(h_table); i++){
+
+        summary_chunk = h_table->summary_chunks[i];
+
+        pthread_mutex_destroy(&summary_chunk->summary_mutex);
+
+        for(j = 0; j < NUMBER_OF_TIMEOUT_WHEEL_SLOTS; j++)
+            free(summary_chunk->timeout_wheel[j].entries);
+
+        for(j = 0; j < NUMBER_OF_COARSE_TIMEOUT_WHEEL_SLOTS; j++)
+            free(summary_chunk->coarse_timeout_wheel[j].entries);
+    }
+
+    for(i = 0; i < NUMBER_OF_HASH_TABLE_SHARDS; i++){
+
+        pthread_rwlock_destroy(&h_table->shards[i].shard_lock);
+
+        free(h_table->shards[i].slots);
+        free(h_table->shards[i].old_slots);
+    }
+
+    mp_destroy(&h_table->overflow_mempool);
+
+    // the rows and the row directory are all released with the arena
+    ma_destroy(&h_table->arena);
+
+    free(h_table);
+}
+
 HashTable * hashtable_new_default(
-    EqualityFunc equal,
-    DeleteData deleteKey,
     DeleteData deleteValue
 ) {
 
     return hashtable_new(NUMBER_ENTRIES_IN_ONE_HASH_TABLE, 
-                         1, 
-                         1, 
-                         equal, 
-                         _hashtable_hash_adler32, 
-                         deleteKey, 
+                         HASH_TABLE_MAX_LOAD, 
+                         HASH_TABLE_RESIZE_FACTOR, 
+                         _hashtable_hash_mac_address, 
                          deleteValue
     );
 
@@ -67,962 +279,3071 @@ HashTable * hashtable_new_default(
 
 
 /*
-adler32 code taken from Stack Overflow post
+The finalizer of MurmurHash3 64-bit, which mixes every bit of the MAC address
+into the lower bits used to select the bucket.
+*/
+
+static uint32_t _hashtable_hash_mac_address(uint64_t key) {
 
-http://stackoverflow.com/a/14409947/3158248
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
 
-Please note, that the rest of the code is my own.
+    return (uint32_t)key;
+}
+
+
+/*
+Robin Hood insertion. The key being placed takes over any slot whose key is 
+closer to its home position, and the displaced key continues probing. The 
+slot array must have at least one empty slot. Returns the index of the slot
+holding the input key.
 */
 
-static uint32_t _hashtable_hash_adler32(const void *buf, size_t buflength) {
+static int _hashtable_insert_slot(HashSlot * slots, 
+                                  int size, 
+                                  HashFunc hash,
+                                  uint64_t key, 
+                                  int row_index) {
 
-     char * buffer;
-     uint32_t s1;
-     uint32_t s2;
-     size_t n;
-     buffer = (const char*)buf;
+    int mask = size - 1;
+    int index = hash(key) & mask;
+    int distance = 1;
+    int placed_index = -1;
+    HashSlot temp;
 
-     s1 = 1;
-     s2 = 0;    
-     
-     for (n = 0; n < buflength; n++) {
-        s1 = (s1 + buffer[n]) % 65521;
-        s2 = (s2 + s1) % 65521;
-     }     
-     return (s2 << 16) | s1;
-}
+    while(slots[index].distance != 0){
 
+        if(slots[index].distance < distance){
 
-int equal_string(void * a, void * b) {
-    char * str1 = (char *) a;
-    char * str2 = (char *) b;
-    int res = strcmp(str1, str2);
-    if (res == 0) {return 1;}
-    else {return 0;}
-}
+            temp = slots[index];
 
-void destroy_key_part(void * key) {
-    // nothing need to do
-    return;
+            slots[index].key = key;
+            slots[index].row_index = row_index;
+            slots[index].distance = distance;
+
+            if(placed_index == -1)
+                placed_index = index;
+
+            key = temp.key;
+            row_index = temp.row_index;
+            distance = temp.distance;
+        }
+
+        index = (index + 1) & mask;
+        distance++;
+    }
+
+    slots[index].key = key;
+    slots[index].row_index = row_index;
+    slots[index].distance = distance;
+
+    if(placed_index == -1)
+        placed_index = index;
+
+    return placed_index;
 }
 
-void destroy_value_part(void * value){
-    hash_table_row * value_part = (hash_table_row*) value;
+static int _hashtable_find_slot(HashSlot * slots, 
+                                int size, 
+                                HashFunc hash,
+                                uint64_t key) {
 
-    pthread_mutex_unlock(&value_part->node_lock);
-    pthread_mutex_destroy(&value_part->node_lock);
+    int mask = size - 1;
+    int index = hash(key) & mask;
+    int distance = 1;
 
-    return;
+    // stop at an empty slot or a slot closer to its home than the key would 
+    // be, since Robin Hood insertion would have placed the key before it
+    while(slots[index].distance >= distance){
+
+        if(slots[index].key == key)
+            return index;
+
+        index = (index + 1) & mask;
+        distance++;
+    }
+
+    return -1;
 }
 
 /*
-initial area table
+Moves up to number_of_slots slots of the old slot array of the shard into its
+slot array. Moved slots are retired rather than emptied, because emptying them
+would cut the probe sequences of the keys not moved yet. The old slot array is
+released once every slot has been visited.
 */
-ErrorCode initialize_area_table(){
-    
-    int i;
-    
 
-    zlog_debug(category_debug,">>initial_area_table");
+static void _hashtable_migrate_slots(HashTable * h_table, 
+                                     HashShard * shard,
+                                     int number_of_slots) {
 
-    if(MEMORY_POOL_SUCCESS != mp_init( &hash_table_node_mempool, 
-                                       sizeof(HNode), 
-                                       SLOTS_IN_MEM_POOL_HASH_TABLE_NODE))
-    {
-        zlog_error(category_debug,"initial fail hash_table_node_mempool");
-        return E_MALLOC;
-    }
-    
-    if(MEMORY_POOL_SUCCESS != mp_init( &mac_address_mempool, 
-                                       LENGTH_OF_MAC_ADDRESS, 
-                                       SLOTS_IN_MEM_POOL_MAC_ADDRESS))
-    {
-        zlog_error(category_debug,"initial fail mac_address_mempool");
-        return E_MALLOC;
-    }
+    int end;
+    HashSlot * old_slot;
 
+    if(shard->old_slots == NULL)
+        return;
 
-    if(MEMORY_POOL_SUCCESS != mp_init( &hash_table_value_mempool, 
-                                       sizeof(hash_table_row), 
-                                       SLOTS_IN_MEM_POOL_HASH_TABLE_VALUE))
-    {
-        zlog_error(category_debug,"initial fail hash_table_value_mempool");
-        return E_MALLOC;
+    end = shard->migrate_index + number_of_slots;
+    if(end > shard->old_size)
+        end = shard->old_size;
+
+    for(; shard->migrate_index < end; shard->migrate_index++){
+
+        old_slot = &shard->old_slots[shard->migrate_index];
+
+        if(old_slot->distance == 0 || old_slot->row_index == RETIRED_SLOT)
+            continue;
+
+        _hashtable_insert_slot(shard->slots, 
+                               shard->size, 
+                               h_table->hash,
+                               old_slot->key, 
+                               old_slot->row_index);
+
+        old_slot->row_index = RETIRED_SLOT;
     }
-   
-    area_table_max_size = INITIAL_AREA_TABLE_MAX_SIZE;
-    next_index_area_table = 0;
-    
-    area_table = malloc((area_table_max_size * sizeof(AreaTable)));
-    if(area_table == NULL)
-    {
-        zlog_error(category_debug,"cannot malloc area_table");
-        return E_MALLOC;
+
+    if(shard->migrate_index >= shard->old_size){
+
+        free(shard->old_slots);
+
+        shard->old_slots = NULL;
+        shard->old_size = 0;
+        shard->migrate_index = 0;
     }
+}
 
-    for(i = 0; i < area_table_max_size; i++){
-        area_table[i].area_id = 0;
-        area_table[i].area_hash_ptr = NULL;
+/*
+Starts a resize of the shard. Only the enlarged slot array is allocated here;
+the keys are moved by _hashtable_migrate_slots in later operations, so no 
+single operation holds shard_lock for a time proportional to the size of the
+shard.
+*/
+
+static int _hashtable_resize(HashTable * h_table, HashShard * shard) {
+
+    int new_size = (int)(shard->size * h_table->resize_factor);
+    HashSlot * new_slots;
+
+    // The previous migration is normally long finished, since the enlarged
+    // array takes many more inserts to fill than operations to migrate into.
+    _hashtable_migrate_slots(h_table, shard, shard->old_size);
+
+    new_slots = calloc(new_size, sizeof(HashSlot));
+    if(new_slots == NULL){
+        zlog_error(category_debug, "cannot resize hashtable to %d slots", 
+                   new_size);
+        return -1;
     }
 
-    pthread_mutex_init( &area_table_lock, NULL);
+    shard->old_slots = shard->slots;
+    shard->old_size = shard->size;
+    shard->migrate_index = 0;
 
-    zlog_debug(category_debug,"initial_area_table successful"); 
+    shard->slots = new_slots;
+    shard->size = new_size;
 
-    return WORK_SUCCESSFULLY;
+    return 0;
 }
 
-HashTable * hash_table_of_specific_area_id(int area_id){
-    
+static int _hashtable_allocate_row(HashTable * h_table) {
+
+    int row_index;
+    int chunk_index;
     int i;
-    HashTable * h_table;
-    AreaTable* area_table_resize_ptr;
-    
+    hash_table_row * chunk;
+    SummaryChunk * summary_chunk;
 
-    zlog_debug(category_debug,"area id %d",area_id);
-    
-    // search for existing hashtable for input area_id
-    for(i = 0; i < area_table_max_size; i++){
-        if(area_table[i].area_id == 0)
-            break;
+    pthread_mutex_lock(h_table->row_mutex);
 
-        if(area_table[i].area_id == area_id){
-            h_table = area_table[i].area_hash_ptr;
+    if(h_table->free_row_index == NO_FREE_ROW)
+        _hashtable_reclaim_rows(h_table);
 
-            return h_table;
-        }
+    if(h_table->free_row_index != NO_FREE_ROW){
+
+        row_index = h_table->free_row_index;
+        h_table->free_row_index = 
+            hashtable_get_row(h_table, row_index)->next_free_row;
+
+        pthread_mutex_unlock(h_table->row_mutex);
+        return row_index;
     }
 
-    // input area_id is not in area_table, so create one new element.
-    pthread_mutex_lock(&area_table_lock);
+    row_index = h_table->row_count;
+    chunk_index = row_index / ROWS_IN_ONE_ROW_CHUNK;
 
-    // search for existing hashtable again to avoid 
-    // duplicated creation for the same area_id
-    for(i = 0; i < area_table_max_size; i++){
-        if(area_table[i].area_id == 0)
-            break;
+    if(chunk_index >= MAX_ROW_CHUNKS_IN_ONE_HASH_TABLE){
+        pthread_mutex_unlock(h_table->row_mutex);
+        zlog_error(category_debug, "hashtable reaches maximum rows");
+        return NO_FREE_ROW;
+    }
 
-        if(area_table[i].area_id == area_id){
-            h_table = area_table[i].area_hash_ptr;
+    if(row_index % ROWS_IN_ONE_ROW_CHUNK == 0){
 
-            pthread_mutex_unlock(&area_table_lock);
-            return h_table;
+        chunk = ma_alloc(&h_table->arena, 
+                         sizeof(hash_table_row) * ROWS_IN_ONE_ROW_CHUNK);
+        if(chunk == NULL){
+            pthread_mutex_unlock(h_table->row_mutex);
+            return NO_FREE_ROW;
         }
-    }
 
-    // create new hashtable for input area_id    
-    if(next_index_area_table >= area_table_max_size){
+        // the node_locks live as long as the rows
+        for(i = 0; i < ROWS_IN_ONE_ROW_CHUNK; i++){
+            pthread_mutex_init(&chunk[i].node_lock, NULL);
+            chunk[i].sequence = 0;
+            chunk[i].row_index = row_index + i;
+        }
 
-        //resize the allocated area_table
-        area_table_resize_ptr = 
-            realloc(area_table, area_table_max_size * 2 * sizeof(AreaTable));
+        h_table->row_chunks[chunk_index] = chunk;
+    }
 
-        if(area_table_resize_ptr == NULL){
-            zlog_error(category_debug,"area_table_resize_ptr == null");
+    if(row_index % ROWS_IN_ONE_SUMMARY_CHUNK == 0){
 
-            pthread_mutex_unlock(&area_table_lock);
-            return NULL;
+        summary_chunk = ma_alloc(&h_table->arena, sizeof(SummaryChunk));
+        if(summary_chunk == NULL){
+            pthread_mutex_unlock(h_table->row_mutex);
+            return NO_FREE_ROW;
         }
 
-        area_table_max_size *= 2;
-        area_table = area_table_resize_ptr;
+        memset(summary_chunk, 0, sizeof(SummaryChunk));
+        pthread_mutex_init(&summary_chunk->summary_mutex, NULL);
+        summary_chunk->timeout_wheel_timestamp = get_system_time();
 
-        for(i = next_index_area_table ; i < area_table_max_size; i++){
-            area_table[i].area_id = 0;
-            area_table[i].area_hash_ptr = NULL;
-        }        
+        h_table->summary_chunks[row_index / ROWS_IN_ONE_SUMMARY_CHUNK] = 
+            summary_chunk;
     }
 
-    h_table = hashtable_new_default(equal_string, 
-                                    destroy_key_part, 
-                                    destroy_value_part);
-
-    area_table[next_index_area_table].area_id = area_id;
-    area_table[next_index_area_table].area_hash_ptr = h_table;
+    // the row must be reachable before scans can see the new row_count
+    memory_barrier();
+    h_table->row_count = row_index + 1;
 
-    next_index_area_table++;
+    pthread_mutex_unlock(h_table->row_mutex);
 
-    pthread_mutex_unlock(&area_table_lock);
-    return h_table;
+    return row_index;
 }
 
-ErrorCode hashtable_update_object_tracking_data(
-    DBConnectionListHead *db_connection_list_head,
-    char* buf,
-    size_t buf_len,
-    const int number_of_lbeacons_under_tracked,
-    const int number_of_rssi_signals_under_tracked){
+/*
+Puts the evicted row on the list of rows retired in the current epoch and 
+tries to reclaim the rows retired before. The overflow block of the row is 
+kept until the row is reclaimed, since readers may still be walking it.
+*/
 
-    ErrorCode ret_val = WORK_SUCCESSFULLY;
-    
-    int num_types = 2; // BR_EDR and BLE types
-    /**/
-    char temp_buf[WIFI_MESSAGE_LENGTH];
-    char *saveptr = NULL;   
-    char *lbeacon_uuid = NULL;
-    char *lbeacon_ip = NULL;
-    char *lbeacon_timestamp = NULL;
-    char *object_type = NULL;
-    char *object_number = NULL;
-    int numbers = 0;
-    char *object_mac_address = NULL;
-    char *initial_timestamp_GMT = NULL;
-    char *final_timestamp_GMT = NULL;
-    char *rssi = NULL;
-    char *panic_button = NULL;
-    char* battery_voltage;
-    int current_time = get_system_time();
-    int lbeacon_timestamp_value;    
-    char str_area_id[5];
-    int area_id = 0;
-    HashTable * area_table_ptr;
-    
-    DataForHashtable data_row;
-    int i;
+static void _hashtable_retire_row(HashTable * h_table, int row_index) {
 
-    time_t rawtime;
-    struct tm ts;
-    char buf_record_time[LENGTH_OF_TIME_FORMAT];
+    int epoch;
 
-    rawtime = get_system_time();
-    ts = *gmtime(&rawtime);
-    strftime(buf_record_time, sizeof(buf_record_time), 
-             "%Y-%m-%d %H:%M:%S", &ts);
-    
-    memset(temp_buf, 0, sizeof(temp_buf));
-    memcpy(temp_buf, buf, buf_len);
-    
-    lbeacon_uuid = strtok_save(temp_buf, DELIMITER_SEMICOLON, &saveptr);
-    lbeacon_timestamp = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);   
-    lbeacon_timestamp_value = atoi(lbeacon_timestamp);
-    lbeacon_ip = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
-    
-    memset(str_area_id, 0, sizeof(str_area_id));
-    strncpy(str_area_id, lbeacon_uuid, LENGTH_OF_AREA_ID_IN_UUID);
-    area_id = atoi(str_area_id);
-    area_table_ptr = hash_table_of_specific_area_id(area_id);
+    pthread_mutex_lock(h_table->row_mutex);
 
-    if(area_table_ptr == NULL){
+    epoch = h_table->row_epoch & 1;
 
-        zlog_error(category_debug, "cannot locate hashtable for area_id %d",
-                   area_id);
-        return E_MALLOC;
-    }
-    
-    while(num_types --){
-        
-        object_type = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    hashtable_get_row(h_table, row_index)->next_free_row = 
+        h_table->retired_row_index[epoch];
+    h_table->retired_row_index[epoch] = row_index;
 
-        object_number = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    _hashtable_reclaim_rows(h_table);
 
-        zlog_debug(category_debug, "object_type=[%s], object_number=[%s]", 
-                   object_type, object_number);
+    pthread_mutex_unlock(h_table->row_mutex);
+}
 
-        if(object_number == NULL){            
-            return E_API_PROTOCOL_FORMAT;
-        }
+/*
+Advances the epoch of the rows when every reader of the previous epoch has 
+finished, and moves the rows retired in the previous epoch to the list of 
+free rows. Readers of the current epoch entered after those rows were 
+removed from the slot arrays, so they cannot have seen them. The function 
+never waits, and the rows are left for a later call if there are readers. 
+The caller holds row_mutex.
+*/
 
-        numbers = atoi(object_number);
-        while(numbers--){
-            
-            object_mac_address = 
-                strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+static void _hashtable_reclaim_rows(HashTable * h_table) {
 
-            initial_timestamp_GMT = 
-                strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    int previous_epoch = (h_table->row_epoch + 1) & 1;
+    int row_index;
+    hash_table_row * table_row;
 
-            final_timestamp_GMT = 
-                strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    memory_barrier();
 
-            rssi = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
-            panic_button = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
-            battery_voltage = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    if(h_table->row_readers[previous_epoch] != 0)
+        return;
 
-            if(atoi(panic_button)){
-                 SQL_identify_panic_status(db_connection_list_head,  
-                                           object_mac_address);
-            }
-            
-            memset(&data_row, 0, sizeof(DataForHashtable));
-            
-            strcpy(data_row.lbeacon_uuid, lbeacon_uuid);
-            strcpy(data_row.initial_timestamp_GMT, initial_timestamp_GMT);
-            strcpy(data_row.final_timestamp_GMT, final_timestamp_GMT);
-            data_row.rssi = atoi(rssi);
-            strcpy(data_row.battery_voltage, battery_voltage);
-            strcpy(data_row.panic_button, panic_button);    
-            
-            hashtable_put_new_tracking_data(
-                area_table_ptr, 
-                object_mac_address,
-                LENGTH_OF_MAC_ADDRESS, 
-                &data_row, 
-                number_of_lbeacons_under_tracked,
-                number_of_rssi_signals_under_tracked);    
+    while(h_table->retired_row_index[previous_epoch] != NO_FREE_ROW){
 
-            //dump tracking data for rssi signal tool
-            zlog_debug(category_dump, "%s,%s,%s,%s",
-                       object_mac_address, 
-                       lbeacon_uuid,
-                       rssi,
-                       buf_record_time);
+        row_index = h_table->retired_row_index[previous_epoch];
+        table_row = hashtable_get_row(h_table, row_index);
+
+        h_table->retired_row_index[previous_epoch] = 
+            table_row->next_free_row;
+
+        if(table_row->overflow_uuid_record_table_array != NULL){
+            mp_free(&h_table->overflow_mempool, 
+                    table_row->overflow_uuid_record_table_array);
+            table_row->overflow_uuid_record_table_array = NULL;
         }
+
+        table_row->next_free_row = h_table->free_row_index;
+        h_table->free_row_index = row_index;
     }
 
-    return WORK_SUCCESSFULLY;
+    // the emptied list collects the rows retired in the new epoch
+    h_table->row_epoch = h_table->row_epoch + 1;
 }
 
-uint32_t hashtable_maintain_key_part(
-    HashTable * h_table, 
-    void * key, 
-    size_t key_len, 
-    const int number_of_lbeacons_under_tracked,
-    int number_of_rssi_signals_under_tracked){ 
- 
-    uint32_t ret_index = -1;
-    int i = 0;
-    int j = 0;
-    hash_table_row* hash_table_row_for_new_MAC;
-    
-    uint32_t hash_val = h_table->hash(key, key_len);
-    uint32_t index = hash_val % h_table->size;
-    HNode * curr = h_table->table[index];
-    HNode * prev_head = NULL;
-    HNode * new_head = NULL;
+long hashtable_enter_row_read(HashTable * h_table) {
 
-    char *MAC_address = NULL;
+    long epoch;
 
+    while(1){
 
-    while (curr) {      
-        // found existing node of mac_address
-        if(1 == h_table->equal(curr->key, key)){
-            ret_index = index;
-            break;
-        }
-        curr = curr->next;
+        epoch = h_table->row_epoch;
+
+        atomic_increment(&h_table->row_readers[epoch & 1]);
+        memory_barrier();
+
+        // the epoch may have advanced before the reader registered, and the
+        // counter may then be the one of the next epoch
+        if(h_table->row_epoch == epoch)
+            return epoch;
+
+        atomic_decrement(&h_table->row_readers[epoch & 1]);
     }
+}
 
-    if(ret_index != -1)
-        return ret_index;
-    
-   
-    // Not found and need to create new node for input mac_address key
+void hashtable_exit_row_read(HashTable * h_table, long epoch) {
+
+    memory_barrier();
+    atomic_decrement(&h_table->row_readers[epoch & 1]);
+}
 
-    // code to add key and value in O(1) time.
-    hash_val = h_table -> hash(key, key_len);
-    prev_head = h_table -> table[index];  
+HashShard * hashtable_get_shard(HashTable * h_table, uint64_t key) {
 
-    new_head = mp_alloc(&hash_table_node_mempool);
-    if(new_head == NULL){
-        zlog_error(category_debug,"malloc failed: HNode");
+    // the upper bits of the hash select the shard and the lower bits select
+    // the slot within the shard
+    return &h_table->shards[h_table->hash(key) >> 
+                            (32 - NUMBER_OF_HASH_TABLE_SHARD_BITS)];
+}
 
-        return ret_index;
-    }
-    memset(new_head, 0, sizeof(HNode));
-               
-    MAC_address = mp_alloc(&mac_address_mempool);
-    if(MAC_address == NULL){
-        free(new_head); 
-        zlog_error(category_debug,"malloc failed: mac_address");
+bool hashtable_get_row_summary(hash_table_row * table_row,
+                               hash_table_row * row_summary) {
 
-        return ret_index;
-    }
-    memset(MAC_address, 0, LENGTH_OF_MAC_ADDRESS);
-    strcpy(MAC_address, key);
-            
-    hash_table_row_for_new_MAC = mp_alloc(&hash_table_value_mempool);
-    if(hash_table_row_for_new_MAC == NULL){
-        free(new_head);
-        zlog_error(category_debug, "malloc failed: hashtable value");
-        mp_free(&hash_table_value_mempool, MAC_address);
+    unsigned int sequence;
 
-        return;
+    while(1){
+
+        sequence = table_row->sequence;
+
+        // a writer is updating the row. It holds node_lock for the whole 
+        // update, so waiting on the lock is cheaper than spinning.
+        if(sequence & 1){
+            pthread_mutex_lock(&table_row->node_lock);
+            pthread_mutex_unlock(&table_row->node_lock);
+            continue;
+        }
+
+        memory_barrier();
+
+        memcpy(row_summary, table_row, 
+               offsetof(hash_table_row, uuid_record_table_array));
+
+        memory_barrier();
+
+        if(table_row->sequence == sequence)
+            break;
     }
-    memset(hash_table_row_for_new_MAC, 0, sizeof(hash_table_row));
 
-    pthread_mutex_init(&hash_table_row_for_new_MAC -> node_lock, NULL);
+    return row_summary->is_in_use;
+}
+
+int hashtable_get_located_timestamp(const hash_table_row * table_row,
+                                    int current_time) {
 
-    hash_table_row_for_new_MAC->last_reported_timestamp = get_system_time();
-            
-    for(i = 0; i < number_of_lbeacons_under_tracked; i++){
-        hash_table_row_for_new_MAC -> 
-            uuid_record_table_array[i].is_in_use = false;
-        hash_table_row_for_new_MAC ->
-            uuid_record_table_array[i].write_index = 0;
+    int located_timestamp = table_row->location_expiry_timestamp - 1;
+
+    if(located_timestamp > current_time)
+        located_timestamp = current_time;
+
+    if(located_timestamp < table_row->last_reported_timestamp)
+        located_timestamp = table_row->last_reported_timestamp;
+
+    return located_timestamp;
+}
+
+hash_table_row * hashtable_find_row(HashTable * h_table, uint64_t key) {
+
+    HashShard * shard = hashtable_get_shard(h_table, key);
+    int index;
+
+    index = _hashtable_find_slot(shard->slots, 
+                                 shard->size, 
+                                 h_table->hash, 
+                                 key);
+    if(index != -1)
+        return hashtable_get_row(h_table, shard->slots[index].row_index);
+
+    if(shard->old_slots == NULL)
+        return NULL;
+
+    index = _hashtable_find_slot(shard->old_slots, 
+                                 shard->old_size, 
+                                 h_table->hash, 
+                                 key);
+    if(index == -1 || shard->old_slots[index].row_index == RETIRED_SLOT)
+        return NULL;
+
+    return hashtable_get_row(h_table, shard->old_slots[index].row_index);
+}
+
+void hashtable_remove_row(HashTable * h_table, uint64_t key) {
+
+    HashShard * shard = hashtable_get_shard(h_table, key);
+    int mask;
+    int index;
+    int next;
+    int row_index;
+    hash_table_row * table_row;
+
+    _hashtable_migrate_slots(h_table, shard, SLOTS_MIGRATED_IN_ONE_OPERATION);
+
+    mask = shard->size - 1;
+    index = _hashtable_find_slot(shard->slots, 
+                                 shard->size, 
+                                 h_table->hash, 
+                                 key);
+
+    if(index != -1){
+
+        row_index = shard->slots[index].row_index;
+
+        // backward-shift deletion keeps the probe sequences without 
+        // tombstones
+        next = (index + 1) & mask;
+
+        while(shard->slots[next].distance > 1){
+
+            shard->slots[index] = shard->slots[next];
+            shard->slots[index].distance--;
+
+            index = next;
+            next = (next + 1) & mask;
+        }
+
+        shard->slots[index].distance = 0;
+
+    }else{
+
+        // the key has not been migrated yet. Slots of the old slot array 
+        // are never shifted during migration, so the slot is only retired.
+        if(shard->old_slots == NULL)
+            return;
+
+        index = _hashtable_find_slot(shard->old_slots, 
+                                     shard->old_size, 
+                                     h_table->hash, 
+                                     key);
+        if(index == -1 || 
+           shard->old_slots[index].row_index == RETIRED_SLOT)
+            return;
+
+        row_index = shard->old_slots[index].row_index;
+        shard->old_slots[index].row_index = RETIRED_SLOT;
     }
 
-    hash_table_row_for_new_MAC -> number_uuid_size = 
-        number_of_lbeacons_under_tracked;
+    shard->count = shard->count - 1;
 
-    // for node of hashtable structure
-    new_head->key = MAC_address;
-    new_head->key_len = LENGTH_OF_MAC_ADDRESS;
-            
-    new_head->value = hash_table_row_for_new_MAC;
-    new_head->value_len = sizeof(hash_table_row_for_new_MAC);         
-            
-    new_head->deleteKey = h_table->deleteKey;
-    new_head->deleteValue = h_table->deleteValue;
-    new_head->next = NULL;
-        
-    new_head->next = prev_head;
-            
-    h_table->count = h_table->count + 1;
-    h_table->table[index] = new_head;   
+    table_row = hashtable_get_row(h_table, row_index);
 
-    return ret_index;
+    hashtable_begin_row_update(table_row);
+    table_row->is_in_use = false;
+    hashtable_end_row_update(table_row);
 
+    // releases node_lock of the row
+    h_table->deleteValue(table_row);
+
+    _hashtable_retire_row(h_table, row_index);
 }
 
-void hashtable_put_new_tracking_data(
-    HashTable * h_table, 
-    const void * key, 
-    const size_t key_len, 
-    DataForHashtable * value, 
-    const int number_of_lbeacons_under_tracked,
-    const int number_of_rssi_signals_under_tracked){
 
-    uint32_t index;
-    HNode * curr = NULL;
-    char coordinateX[LENGTH_OF_COORDINATE];
-    char coordinateY[LENGTH_OF_COORDINATE];
-    char* MAC_address;
+bool parse_mac_address(const char *mac_address, uint64_t *key) {
+
+    uint64_t value = 0;
+    int digit;
     int i;
-    int write_index = 0;
-    int time_gap = 0;
-    
-    int j = 0;
-    int index_not_used = 0;
-    int record_table_size;
-    hash_table_row* hash_table_row_for_new_MAC;
-    hash_table_row * exist_MAC_address_row;
-    const int MISSED_SINGAL_SINCE_SECONDS = 2;
+    char c;
 
-    //try to replace existing key's value if possible
-    pthread_mutex_t * ht_mutex = h_table->ht_mutex; 
+    if(mac_address == NULL)
+        return false;
 
+    for(i = 0; i < LENGTH_OF_MAC_ADDRESS - 1; i++){
 
-    pthread_mutex_lock(ht_mutex);
+        c = mac_address[i];
 
-    index = -1;
-    index = hashtable_maintain_key_part(
-        h_table, 
-        key, 
-        key_len, 
-        number_of_lbeacons_under_tracked,
-        number_of_rssi_signals_under_tracked);
-    
-    if(index == -1){
-        pthread_mutex_unlock(ht_mutex);
-        return;
+        // every third character is the colon separator
+        if(i % 3 == 2){
+            if(c != ':')
+                return false;
+            continue;
+        }
+
+        if(c >= '0' && c <= '9'){
+            digit = c - '0';
+        }else if(c >= 'a' && c <= 'f'){
+            digit = c - 'a' + 10;
+        }else if(c >= 'A' && c <= 'F'){
+            digit = c - 'A' + 10;
+        }else{
+            return false;
+        }
+
+        value = (value << 4) | digit;
     }
 
-    if(index != -1){
-        
-        curr = h_table->table[index];
+    if(mac_address[LENGTH_OF_MAC_ADDRESS - 1] != '\0')
+        return false;
 
-        while(curr){
-            if(1 == h_table->equal(curr->key, key)){
+    *key = value;
 
-                exist_MAC_address_row = curr -> value;
+    return true;
+}
 
-                // lock node of mac_address and release whole hashtable lock
-                pthread_mutex_lock(&exist_MAC_address_row -> node_lock);
-                pthread_mutex_unlock(ht_mutex);
 
+void format_mac_address(uint64_t key, char *mac_address) {
 
-                // update real-time information 
-                record_table_size = exist_MAC_address_row -> number_uuid_size;
-                strcpy(exist_MAC_address_row -> battery, 
-                       value -> battery_voltage);
-                strcpy(exist_MAC_address_row -> panic_button,
-                       value->panic_button);
-                
-                //search lbeacon uuid in the array of recently scanned 
-                //lbeacon uuid
-                index_not_used = -1;
+    const char *digits = "0123456789abcdef";
+    int i;
+    int shift;
 
-                for(i = 0; i < record_table_size; i++){
+    for(i = 0; i < 6; i++){
 
-                    if(index_not_used == -1 &&
-                       !exist_MAC_address_row ->
-                        uuid_record_table_array[i].is_in_use){
+        shift = (5 - i) * 8;
 
-                       // record the index of not used space of uuid array for 
-                       // not-found case below.
-                       index_not_used = i;
+        mac_address[i * 3] = digits[(key >> (shift + 4)) & 0xF];
+        mac_address[i * 3 + 1] = digits[(key >> shift) & 0xF];
+        mac_address[i * 3 + 2] = (i == 5) ? '\0' : ':';
+    }
+}
 
-                    }else if(exist_MAC_address_row -> 
-                             uuid_record_table_array[i].is_in_use && 
-                             0 == strcmp(value -> lbeacon_uuid,
-                                         exist_MAC_address_row -> 
-                                         uuid_record_table_array[i].uuid)){
+void destroy_value_part(void * value){
+    hash_table_row * value_part = (hash_table_row*) value;
 
-                        // fill the missing rssi signal as zero.
-                        time_gap = atoi(value -> final_timestamp_GMT) - 
-                                   atoi(exist_MAC_address_row ->
-                                   uuid_record_table_array[i].final_timestamp);
+    // node_lock is owned by the row storage and is kept for the next object
+    pthread_mutex_unlock(&value_part->node_lock);
 
-                        strcpy(exist_MAC_address_row ->
-                               uuid_record_table_array[i].final_timestamp,
-                               value -> final_timestamp_GMT);
+    return;
+}
 
-                        exist_MAC_address_row -> 
-                        uuid_record_table_array[i].last_reported_timestamp = 
-                            get_system_time();
+/*
+The read side of area_table. The returned epoch must be passed to 
+_area_table_read_unlock. A reader registers in the counter of the epoch 
+before it loads area_table, so a writer which has seen the counter drain 
+after publishing a new array knows the reader has finished with the old one.
+*/
 
-                        write_index = exist_MAC_address_row -> 
-                            uuid_record_table_array[i].write_index;
+static int _area_table_read_lock(){
 
-                        // fill zero to rssi_array[] for the missing seconds.
-                        if(time_gap >= MISSED_SINGAL_SINCE_SECONDS){
+    int epoch = area_table_epoch & 1;
 
-                            for(j = MISSED_SINGAL_SINCE_SECONDS ; 
-                                j <= time_gap ; j++){
-                        
-                                write_index++;
-                                if(write_index == 
-                                   number_of_rssi_signals_under_tracked){
+    atomic_increment(&area_table_readers[epoch]);
 
-                                    write_index = 0;
-                                }
+    return epoch;
+}
 
-                                exist_MAC_address_row -> 
-                                uuid_record_table_array[i].
-                                rssi_array[write_index] = 0;
-                            }
-                        }
-                    
-                        write_index++;
-                        if(write_index == 
-                            number_of_rssi_signals_under_tracked){
+static void _area_table_read_unlock(int epoch){
 
-                            write_index = 0;
-                        }
-                   
-                        exist_MAC_address_row ->
-                        uuid_record_table_array[i].
-                        rssi_array[write_index] = value->rssi;
+    atomic_decrement(&area_table_readers[epoch]);
+}
 
-                        exist_MAC_address_row ->
-                        uuid_record_table_array[i].write_index = write_index;
- 
-                        pthread_mutex_unlock(&exist_MAC_address_row -> node_lock);
-                        return;
-                    } // else
-                } // for-loop
-            
-                // case of new lbeacon uuid
-                if(index_not_used != -1){
-                
-                    strcpy(exist_MAC_address_row -> 
-                           uuid_record_table_array[index_not_used].uuid,
-                           value->lbeacon_uuid);
-
-                    strcpy(exist_MAC_address_row -> 
-                           uuid_record_table_array[index_not_used].
-                           initial_timestamp, 
-                           value -> initial_timestamp_GMT);
-
-                    strcpy(exist_MAC_address_row -> 
-                           uuid_record_table_array[index_not_used].
-                           final_timestamp, 
-                           value->final_timestamp_GMT);
-
-                    exist_MAC_address_row ->
-                    uuid_record_table_array[index_not_used].
-                    last_reported_timestamp  = get_system_time();
-
-                    write_index = 0;
-                    exist_MAC_address_row -> 
-                    uuid_record_table_array[index_not_used].
-                    rssi_array[write_index] = value->rssi;
-
-                    exist_MAC_address_row -> 
-                    uuid_record_table_array[index_not_used].
-                    write_index = write_index;
-                
-                    memcpy(coordinateX,value -> 
-                           lbeacon_uuid + INDEX_OF_COORDINATE_X_IN_UUID, 
-                           LENGTH_OF_COORDINATE_IN_UUID);
-                    coordinateX[LENGTH_OF_COORDINATE_IN_UUID]='\0';
-                
-                    exist_MAC_address_row -> 
-                    uuid_record_table_array[index_not_used].
-                    coordinateX = atof(coordinateX);          
-
-                    memcpy(coordinateY,value -> 
-                           lbeacon_uuid + INDEX_OF_COORDINATE_Y_IN_UUID, 
-                           LENGTH_OF_COORDINATE_IN_UUID);
-                    coordinateY[LENGTH_OF_COORDINATE_IN_UUID]='\0';
-
-                    exist_MAC_address_row -> 
-                    uuid_record_table_array[index_not_used].
-                    coordinateY = atof(coordinateY);
-                
-                    exist_MAC_address_row -> 
-                    uuid_record_table_array[index_not_used].is_in_use = true;
-                
-                }else{
-                    zlog_error(category_debug,"need more uuid record table");
-                } 
+/*
+Waits until every reader which might have loaded the area_table array 
+replaced before this call has finished. Readers arriving after each flip of 
+the epoch register in the other counter, so each wait is bounded by the 
+readers already in their read side. The caller holds area_table_lock.
+*/
 
-                pthread_mutex_unlock(&exist_MAC_address_row->node_lock);
+static void _area_table_synchronize(){
 
-                break;
+    int i;
+    int epoch;
 
-            } // if
+    for(i = 0; i < 2; i++){
 
-            curr = curr->next;
-        } // while
+        epoch = area_table_epoch & 1;
+
+        area_table_epoch = epoch ^ 1;
+        memory_barrier();
+
+        while(area_table_readers[epoch] != 0)
+            sleep_t(AREA_TABLE_GRACE_PERIOD_POLLING_TIME_IN_MS);
     }
+}
 
-    pthread_mutex_unlock(ht_mutex);
-    return;
+/*
+Copies the entry at the input index of area_table while holding the read 
+side, so the caller can use the hashtable after the array is replaced. The
+hashtables themselves live until destroy_area_table.
+*/
+
+static bool _area_table_get_entry(int index, AreaTable * entry){
+
+    int epoch;
+    bool is_found = false;
+
+    epoch = _area_table_read_lock();
+
+    if(index < next_index_area_table){
+
+        // the count is read before the array, and the array published 
+        // before the count was increased holds the entry
+        memory_barrier();
+
+        *entry = area_table[index];
+        is_found = true;
+    }
+
+    _area_table_read_unlock(epoch);
+
+    return is_found;
 }
 
-int get_rssi_weight(float average_rssi,
-                    const int rssi_weight_multiplier){
+/*
+initial area table
+*/
+ErrorCode initialize_area_table(){
     
-    //return the corresponding weight according to the rssi singal 
-    if(average_rssi > -40)
-        return pow(rssi_weight_multiplier, 9);
-    else if(average_rssi > -45)
-        return pow(rssi_weight_multiplier, 8);
-    else if(average_rssi > -50)
-        return pow(rssi_weight_multiplier, 7);
-    else if(average_rssi > -55)
-        return pow(rssi_weight_multiplier, 6);
-    else if(average_rssi > -60)
-        return pow(rssi_weight_multiplier, 5);
-    else if(average_rssi > -65)
-        return pow(rssi_weight_multiplier, 4);
-    else if(average_rssi > -70)
-        return pow(rssi_weight_multiplier, 3);
-    else if(average_rssi > -80)
-        return pow(rssi_weight_multiplier, 2);
-    else if(average_rssi > -90)
-        return pow(rssi_weight_multiplier, 1);
-    else if(average_rssi >= -100)
-        return 1;
-    return 0;
+    zlog_debug(category_debug,">>initial_area_table");
+
+    area_table_max_size = INITIAL_AREA_TABLE_MAX_SIZE;
+    next_index_area_table = 0;
+    area_table_epoch = 0;
+    area_table_readers[0] = 0;
+    area_table_readers[1] = 0;
+    
+    area_table = calloc(area_table_max_size, sizeof(AreaTable));
+    area_directory = calloc(MAX_NUMBER_OF_AREA_ID, sizeof(HashTable *));
+    area_settings = calloc(MAX_NUMBER_OF_AREA_ID, sizeof(AreaSettings));
+    number_time_critical_areas = 0;
+
+    if(area_table == NULL || area_directory == NULL || 
+       area_settings == NULL)
+    {
+        zlog_error(category_debug,"cannot malloc area_table");
+
+        free(area_table);
+        free(area_directory);
+        free(area_settings);
+        return E_MALLOC;
+    }
+
+    pthread_mutex_init( &area_table_lock, NULL);
+
+    zlog_debug(category_debug,"initial_area_table successful"); 
+
+    return WORK_SUCCESSFULLY;
 }
 
-int get_average_rssi(const int *rssi_array,
-                     const int rssi_threashold_for_summarize_location_pin,
-                     const int number_of_rssi_signals_under_tracked,
-                     const int unreasonable_rssi_change){
+void destroy_area_table(){
 
-    int k = 0;
-    int valid_rssi_count = 0;
-    int prev_index = 0;
-    int sum_rssi = 0;
-    int ret_avg_rssi = 0;
+    int i;
 
-    for(k = 0; k < number_of_rssi_signals_under_tracked; k++){
+    pthread_mutex_lock(&area_table_lock);
 
-        // ignore the timing at which no rssi signal was scanned
-        if(rssi_array[k] == 0)
-            continue;
-   
-        // ignore weak rssi signals from poor lbeacons
-        if(rssi_array[k] < rssi_threashold_for_summarize_location_pin)
-            continue;
+    for(i = 0; i < next_index_area_table; i++){
+
+        area_directory[area_table[i].area_id] = NULL;
+
+        hashtable_destroy(area_table[i].area_hash_ptr);
+
+        area_table[i].area_id = 0;
+        area_table[i].area_hash_ptr = NULL;
+    }
+
+    next_index_area_table = 0;
+
+    free(area_table);
+    area_table = NULL;
+
+    free(area_directory);
+    area_directory = NULL;
+
+    free(area_settings);
+    area_settings = NULL;
+    number_time_critical_areas = 0;
+
+    pthread_mutex_unlock(&area_table_lock);
+
+    pthread_mutex_destroy(&area_table_lock);
+}
+
+ErrorCode set_time_critical_areas(
+    const char *area_id_list,
+    const int rssi_difference_of_location_accuracy_tolerance){
+
+    char temp_buf[WIFI_MESSAGE_LENGTH];
+    char *saveptr = NULL;
+    char *area_id_str = NULL;
+    char *end = NULL;
+    long area_id;
+    ErrorCode ret_val = WORK_SUCCESSFULLY;
+
+    memset(temp_buf, 0, sizeof(temp_buf));
+    strncpy(temp_buf, area_id_list, sizeof(temp_buf) - 1);
+
+    time_critical_rssi_difference = 
+        rssi_difference_of_location_accuracy_tolerance;
+
+    pthread_mutex_lock(&area_table_lock);
+
+    area_id_str = strtok_save(temp_buf, DELIMITER_SEMICOLON, &saveptr);
+
+    while(area_id_str != NULL){
+
+        area_id = strtol(area_id_str, &end, 10);
+
+        if(end == area_id_str || *end != '\0' ||
+           area_id < 0 || area_id >= MAX_NUMBER_OF_AREA_ID){
+
+            zlog_error(category_debug, 
+                       "invalid time critical area id [%s]", area_id_str);
+            ret_val = E_INPUT_PARAMETER;
+
+        }else if(!area_settings[area_id].is_time_critical){
+
+            area_settings[area_id].is_time_critical = true;
+            number_time_critical_areas++;
+
+            // the hashtable of the area may have been created already
+            if(area_directory[area_id] != NULL)
+                area_directory[area_id]->is_time_critical = true;
+
+            zlog_info(category_debug, "time critical area [%ld]", area_id);
+        }
+
+        area_id_str = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    }
+
+    pthread_mutex_unlock(&area_table_lock);
+
+    return ret_val;
+}
+
+ErrorCode set_area_tolerant_not_scanning_time(const char *area_time_list){
+
+    char temp_buf[WIFI_MESSAGE_LENGTH];
+    char *saveptr = NULL;
+    char *pair_str = NULL;
+    char *time_str = NULL;
+    char *end = NULL;
+    long area_id;
+    long time_in_sec;
+    ErrorCode ret_val = WORK_SUCCESSFULLY;
+
+    memset(temp_buf, 0, sizeof(temp_buf));
+    strncpy(temp_buf, area_time_list, sizeof(temp_buf) - 1);
+
+    pthread_mutex_lock(&area_table_lock);
+
+    pair_str = strtok_save(temp_buf, DELIMITER_SEMICOLON, &saveptr);
+
+    while(pair_str != NULL){
+
+        area_id = strtol(pair_str, &end, 10);
+        time_in_sec = 0;
+
+        if(end != pair_str && *end == ':'){
+            time_str = end + 1;
+            time_in_sec = strtol(time_str, &end, 10);
+        }
+
+        if(end == pair_str || *end != '\0' ||
+           area_id < 0 || area_id >= MAX_NUMBER_OF_AREA_ID ||
+           time_in_sec <= 0 || time_in_sec > INT_MAX / 2){
+
+            zlog_error(category_debug, 
+                       "invalid tolerant not scanning time [%s]", pair_str);
+            ret_val = E_INPUT_PARAMETER;
+
+        }else{
+
+            area_settings[area_id].tolerant_not_scanning_time_in_sec = 
+                (int)time_in_sec;
+
+            // the hashtable of the area may have been created already. Its
+            // rows are evicted by the new time from their next summary on.
+            if(area_directory[area_id] != NULL){
+                area_directory[area_id]->tolerant_not_scanning_time_in_sec =
+                    (int)time_in_sec;
+            }
+
+            zlog_info(category_debug, 
+                      "tolerant not scanning time of area [%ld] = [%ld]", 
+                      area_id, time_in_sec);
+        }
+
+        pair_str = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    }
+
+    pthread_mutex_unlock(&area_table_lock);
+
+    return ret_val;
+}
+
+void initialize_area_work_queue(AreaWorkQueue *work_queue, 
+                                const char *name,
+                                int period_in_ms){
+
+    memset(work_queue, 0, sizeof(AreaWorkQueue));
+
+    pthread_mutex_init(&work_queue->lock, NULL);
+
+    work_queue->name = name;
+    work_queue->period_in_ms = period_in_ms;
+
+    // the first pass is due at once
+    work_queue->pass_start_time = get_clock_time_in_ms() - period_in_ms;
+}
+
+void destroy_area_work_queue(AreaWorkQueue *work_queue){
+
+    int i;
+    int j;
+
+    for(i = 0; i < work_queue->max_areas; i++){
+        for(j = 0; j < MAX_SUMMARY_CHUNKS_IN_ONE_HASH_TABLE; j++)
+            free(work_queue->area_works[i].buffers[j].data);
+    }
+
+    free(work_queue->area_works);
+    work_queue->area_works = NULL;
+    work_queue->max_areas = 0;
+
+    pthread_mutex_destroy(&work_queue->lock);
+}
+
+/*
+Takes the next chunk of the current pass, and starts the next pass when the 
+current pass is done and the period has passed. The areas created after a 
+pass started are left to the next pass, and so are the chunks of an area
+created after the first chunk of the area is taken.
+*/
+
+static bool _area_work_queue_take(AreaWorkQueue *work_queue, 
+                                  AreaWorkItem *item){
+
+    unsigned int current_time = get_clock_time_in_ms();
+    int number_areas;
+    AreaWork * area_works;
+    AreaWork * area_work;
+    bool is_taken = false;
+
+    pthread_mutex_lock(&work_queue->lock);
+
+    if(work_queue->number_finished_areas == work_queue->number_areas &&
+       current_time - work_queue->pass_start_time >= 
+       (unsigned int)work_queue->period_in_ms){
+
+        number_areas = next_index_area_table;
+
+        // no thread holds the work of an area between passes
+        if(number_areas > work_queue->max_areas){
+
+            area_works = realloc(work_queue->area_works, 
+                                 sizeof(AreaWork) * number_areas);
+
+            if(area_works == NULL){
+
+                zlog_error(category_debug, 
+                           "cannot expand %s work queue", 
+                           work_queue->name);
+                number_areas = work_queue->max_areas;
+            }else{
+
+                memset(area_works + work_queue->max_areas, 0, 
+                       sizeof(AreaWork) * 
+                       (number_areas - work_queue->max_areas));
+
+                work_queue->area_works = area_works;
+                work_queue->max_areas = number_areas;
+            }
+        }
+
+        work_queue->pass_start_time = current_time;
+        work_queue->number_areas = number_areas;
+        work_queue->next_area_index = 0;
+        work_queue->next_chunk_index = 0;
+        work_queue->number_finished_areas = 0;
+    }
+
+    while(!is_taken && 
+          work_queue->next_area_index < work_queue->number_areas){
+
+        area_work = &work_queue->area_works[work_queue->next_area_index];
+
+        if(work_queue->next_chunk_index == 0){
+
+            // every area of a pass has been created before the pass started
+            if(!_area_table_get_entry(work_queue->next_area_index, 
+                                      &area_work->entry)){
+
+                work_queue->next_area_index++;
+                work_queue->number_finished_areas++;
+                continue;
+            }
+
+            // an area without objects still uploads an empty batch
+            area_work->number_chunks = 
+                hashtable_get_number_summary_chunks(
+                    area_work->entry.area_hash_ptr);
+            if(area_work->number_chunks == 0)
+                area_work->number_chunks = 1;
+
+            area_work->number_finished_chunks = 0;
+        }
+
+        item->area_work = area_work;
+        item->chunk_index = work_queue->next_chunk_index;
+
+        work_queue->next_chunk_index++;
+
+        if(work_queue->next_chunk_index == area_work->number_chunks){
+            work_queue->next_area_index++;
+            work_queue->next_chunk_index = 0;
+        }
+
+        is_taken = true;
+    }
+
+    pthread_mutex_unlock(&work_queue->lock);
+
+    return is_taken;
+}
+
+/*
+Marks one chunk of an area done, and returns whether it is the last chunk of 
+the area. The caller finishing the last chunk uploads the area and then 
+marks the area done by _area_work_queue_finish.
+*/
+
+static bool _area_work_queue_finish_chunk(AreaWorkQueue *work_queue,
+                                          AreaWorkItem *item){
+
+    bool is_last;
+
+    pthread_mutex_lock(&work_queue->lock);
+
+    item->area_work->number_finished_chunks++;
+
+    is_last = (item->area_work->number_finished_chunks == 
+               item->area_work->number_chunks);
+
+    pthread_mutex_unlock(&work_queue->lock);
+
+    return is_last;
+}
+
+/*
+Marks one area of the current pass done. The thread finishing the last area
+of the pass records how long the pass took.
+*/
+
+static void _area_work_queue_finish(AreaWorkQueue *work_queue){
+
+    pthread_mutex_lock(&work_queue->lock);
+
+    work_queue->number_finished_areas++;
+
+    if(work_queue->number_finished_areas == work_queue->number_areas){
+
+        work_queue->last_pass_duration_in_ms = 
+            get_clock_time_in_ms() - work_queue->pass_start_time;
+
+        if(work_queue->last_pass_duration_in_ms > work_queue->period_in_ms){
+
+            zlog_error(category_debug,
+                       "%s pass over %d areas took %d ms, longer than its " \
+                       "period of %d ms",
+                       work_queue->name,
+                       work_queue->number_areas,
+                       work_queue->last_pass_duration_in_ms,
+                       work_queue->period_in_ms);
+        }else{
+
+            zlog_debug(category_debug,
+                       "%s pass over %d areas took %d ms",
+                       work_queue->name,
+                       work_queue->number_areas,
+                       work_queue->last_pass_duration_in_ms);
+        }
+    }
+
+    pthread_mutex_unlock(&work_queue->lock);
+}
+
+void hashtable_report_mempool_statistics(){
+
+    int i;
+    int j;
+    int number_of_objects;
+    int number_of_slots;
+    AreaTable entry;
+    HashTable * h_table;
+
+    for(i = 0; _area_table_get_entry(i, &entry); i++){
+
+        h_table = entry.area_hash_ptr;
+
+        number_of_objects = 0;
+        number_of_slots = 0;
+
+        for(j = 0; j < NUMBER_OF_HASH_TABLE_SHARDS; j++){
+            number_of_objects += h_table->shards[j].count;
+            number_of_slots += h_table->shards[j].size;
+        }
+
+        zlog_info(category_debug, 
+                  "[Mempool] area_id [%d] arena size [%lu] objects [%d] " \
+                  "slots [%d] rows [%d]",
+                  entry.area_id, 
+                  (unsigned long)ma_get_current_size(&h_table->arena),
+                  number_of_objects,
+                  number_of_slots,
+                  h_table->row_count);
+    }
+}
+
+HashTable * hash_table_of_specific_area_id(int area_id){
+    
+    HashTable * h_table;
+    AreaTable * new_area_table;
+    AreaTable * old_area_table;
+    
+    zlog_debug(category_debug,"area id %d",area_id);
+
+    if(area_id < 0 || area_id >= MAX_NUMBER_OF_AREA_ID){
+        zlog_error(category_debug, "area_id %d is out of range", area_id);
+        return NULL;
+    }
+    
+    // the entry is set after the hashtable is fully initialized
+    h_table = area_directory[area_id];
+    memory_barrier();
+
+    if(h_table != NULL)
+        return h_table;
+
+    // input area_id is not in area_table, so create one new element.
+    pthread_mutex_lock(&area_table_lock);
+
+    // search for existing hashtable again to avoid 
+    // duplicated creation for the same area_id
+    h_table = area_directory[area_id];
+    if(h_table != NULL){
+        pthread_mutex_unlock(&area_table_lock);
+        return h_table;
+    }
+
+    h_table = hashtable_new_default(destroy_value_part);
+
+    if(h_table == NULL){
+        zlog_error(category_debug,"cannot create hashtable for area_id %d",
+                   area_id);
+
+        pthread_mutex_unlock(&area_table_lock);
+        return NULL;
+    }
+
+    h_table->is_time_critical = area_settings[area_id].is_time_critical;
+
+    if(area_settings[area_id].tolerant_not_scanning_time_in_sec > 0){
+        h_table->tolerant_not_scanning_time_in_sec = 
+            area_settings[area_id].tolerant_not_scanning_time_in_sec;
+    }
+
+    old_area_table = NULL;
+
+    if(next_index_area_table >= area_table_max_size){
+
+        // publish a larger copy instead of resizing the array under readers
+        new_area_table = 
+            calloc(area_table_max_size * 2, sizeof(AreaTable));
+
+        if(new_area_table == NULL){
+            zlog_error(category_debug,"cannot resize area_table");
+
+            hashtable_destroy(h_table);
+            pthread_mutex_unlock(&area_table_lock);
+            return NULL;
+        }
+
+        memcpy(new_area_table, area_table, 
+               area_table_max_size * sizeof(AreaTable));
+
+        old_area_table = area_table;
+        area_table_max_size *= 2;
+    }else{
+        new_area_table = area_table;
+    }
+
+    // the new entry is beyond next_index_area_table, so no reader looks at 
+    // it before the count is increased
+    new_area_table[next_index_area_table].area_id = area_id;
+    new_area_table[next_index_area_table].area_hash_ptr = h_table;
+
+    memory_barrier();
+    area_table = new_area_table;
+    area_directory[area_id] = h_table;
+
+    memory_barrier();
+    next_index_area_table++;
+
+    if(old_area_table != NULL){
+        _area_table_synchronize();
+        free(old_area_table);
+    }
+
+    pthread_mutex_unlock(&area_table_lock);
+    return h_table;
+}
+
+ErrorCode hashtable_update_object_tracking_data(
+    DBConnectionListHead *db_connection_list_head,
+    char* buf,
+    size_t buf_len,
+    const int number_of_lbeacons_under_tracked,
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change){
+
+    ErrorCode ret_val = WORK_SUCCESSFULLY;
+    
+    int num_types = 2; // BR_EDR and BLE types
+    /**/
+    char temp_buf[WIFI_MESSAGE_LENGTH];
+    char *saveptr = NULL;   
+    char *lbeacon_uuid = NULL;
+    char *lbeacon_ip = NULL;
+    char *lbeacon_timestamp = NULL;
+    char *object_type = NULL;
+    char *object_number = NULL;
+    int numbers = 0;
+    char *object_mac_address = NULL;
+    char *initial_timestamp_GMT = NULL;
+    char *final_timestamp_GMT = NULL;
+    char *rssi = NULL;
+    char *panic_button = NULL;
+    char* battery_voltage;
+    int current_time = get_system_time();
+    int lbeacon_timestamp_value;    
+    int lbeacon_id;
+    int area_id = 0;
+    HashTable * area_table_ptr;
+    uint64_t mac_address_key;
+    
+    DataForHashtable data_row;
+    int i;
+
+    time_t rawtime;
+    struct tm ts;
+    char buf_record_time[LENGTH_OF_TIME_FORMAT];
+
+    rawtime = get_system_time();
+    ts = *gmtime(&rawtime);
+    strftime(buf_record_time, sizeof(buf_record_time), 
+             "%Y-%m-%d %H:%M:%S", &ts);
+    
+    memset(temp_buf, 0, sizeof(temp_buf));
+    memcpy(temp_buf, buf, buf_len);
+    
+    lbeacon_uuid = strtok_save(temp_buf, DELIMITER_SEMICOLON, &saveptr);
+    lbeacon_timestamp = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);   
+    lbeacon_timestamp_value = atoi(lbeacon_timestamp);
+    lbeacon_ip = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+    
+    // the area id of the lbeacon is parsed once when it is interned
+    lbeacon_id = lbeacon_registry_intern(lbeacon_uuid);
+    if(lbeacon_id == LBEACON_ID_UNKNOWN){
+
+        zlog_error(category_debug, "invalid lbeacon uuid [%s]", 
+                   lbeacon_uuid);
+        return E_API_PROTOCOL_FORMAT;
+    }
+
+    area_id = lbeacon_registry_get_entry(lbeacon_id)->area_id;
+    area_table_ptr = hash_table_of_specific_area_id(area_id);
+
+    if(area_table_ptr == NULL){
+
+        zlog_error(category_debug, "cannot locate hashtable for area_id %d",
+                   area_id);
+        return E_MALLOC;
+    }
+    
+    while(num_types --){
+        
+        object_type = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+
+        object_number = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+
+        zlog_debug(category_debug, "object_type=[%s], object_number=[%s]", 
+                   object_type, object_number);
+
+        if(object_number == NULL){            
+            return E_API_PROTOCOL_FORMAT;
+        }
+
+        numbers = atoi(object_number);
+        while(numbers--){
+            
+            object_mac_address = 
+                strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+
+            initial_timestamp_GMT = 
+                strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+
+            final_timestamp_GMT = 
+                strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+
+            rssi = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+            panic_button = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+            battery_voltage = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+
+            if(!parse_mac_address(object_mac_address, &mac_address_key)){
+                zlog_error(category_debug, 
+                           "invalid mac_address [%s] from lbeacon [%s]",
+                           object_mac_address, lbeacon_uuid);
+                continue;
+            }
+
+            // normalize the case of the mac_address once, so the database
+            // and the logs see the same text as the key
+            format_mac_address(mac_address_key, object_mac_address);
+
+            if(atoi(panic_button)){
+                 SQL_identify_panic_status(db_connection_list_head,  
+                                           object_mac_address);
+            }
+            
+            memset(&data_row, 0, sizeof(DataForHashtable));
+            
+            data_row.lbeacon_id = lbeacon_id;
+            data_row.initial_timestamp_GMT = atoi(initial_timestamp_GMT);
+            data_row.final_timestamp_GMT = atoi(final_timestamp_GMT);
+            data_row.rssi = atoi(rssi);
+            strcpy(data_row.battery_voltage, battery_voltage);
+            strcpy(data_row.panic_button, panic_button);    
+            
+            hashtable_put_new_tracking_data(
+                area_table_ptr, 
+                mac_address_key,
+                &data_row, 
+                number_of_lbeacons_under_tracked,
+                number_of_rssi_signals_under_tracked,
+                rssi_threashold_for_summarize_location_pin,
+                unreasonable_rssi_change);    
+
+            //dump tracking data for rssi signal tool
+            zlog_debug(category_dump, "%s,%s,%s,%s",
+                       object_mac_address, 
+                       lbeacon_uuid,
+                       rssi,
+                       buf_record_time);
+        }
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+hash_table_row * hashtable_maintain_key_part(
+    HashTable * h_table, 
+    uint64_t key, 
+    const int number_of_lbeacons_under_tracked,
+    int number_of_rssi_signals_under_tracked){ 
+ 
+    int i = 0;
+    int row_index;
+    HashShard * shard = hashtable_get_shard(h_table, key);
+    hash_table_row* hash_table_row_for_new_MAC;
+
+    // every operation moves a bounded part of an in-flight resize
+    _hashtable_migrate_slots(h_table, shard, SLOTS_MIGRATED_IN_ONE_OPERATION);
+
+    hash_table_row_for_new_MAC = hashtable_find_row(h_table, key);
+
+    // found existing row of mac_address
+    if(hash_table_row_for_new_MAC != NULL)
+        return hash_table_row_for_new_MAC;
+   
+    // Not found and need to create new row for input mac_address key
+
+    // keep the load factor under max_load before taking one more slot
+    if(shard->count + 1 > shard->size * h_table->max_load){
+        if(_hashtable_resize(h_table, shard) != 0)
+            return NULL;
+    }
+
+    row_index = _hashtable_allocate_row(h_table);
+    if(row_index == NO_FREE_ROW){
+        zlog_error(category_debug, "malloc failed: hashtable value");
+
+        return NULL;
+    }
+
+    hash_table_row_for_new_MAC = hashtable_get_row(h_table, row_index);
+
+    // the uploader may be reading a reused row under its node_lock, so the
+    // row is cleared under the same lock and node_lock itself is kept
+    pthread_mutex_lock(&hash_table_row_for_new_MAC -> node_lock);
+    hashtable_begin_row_update(hash_table_row_for_new_MAC);
+
+    memset(hash_table_row_for_new_MAC, 0, 
+           offsetof(hash_table_row, node_lock));
+
+    hash_table_row_for_new_MAC->mac_address = key;
+    hash_table_row_for_new_MAC->last_reported_timestamp = get_system_time();
+    hash_table_row_for_new_MAC->summary_lbeacon_id = LBEACON_ID_UNKNOWN;
+
+    // records are handed out on demand, and the memset above has already 
+    // marked the inline records not in use
+    hash_table_row_for_new_MAC -> number_uuid_records = 0;
+    hash_table_row_for_new_MAC -> number_uuid_size = 
+        number_of_lbeacons_under_tracked;
+
+    if(hash_table_row_for_new_MAC -> number_uuid_size > 
+       MAX_NUMBER_OF_LBEACON_UNDER_TRACKING){
+
+        hash_table_row_for_new_MAC -> number_uuid_size = 
+            MAX_NUMBER_OF_LBEACON_UNDER_TRACKING;
+    }
+
+    hash_table_row_for_new_MAC -> is_in_use = true;
+
+    hashtable_end_row_update(hash_table_row_for_new_MAC);
+    pthread_mutex_unlock(&hash_table_row_for_new_MAC -> node_lock);
+
+    _hashtable_insert_slot(shard->slots, 
+                           shard->size, 
+                           h_table->hash, 
+                           key, 
+                           row_index);
+            
+    shard->count = shard->count + 1;
+
+    return hash_table_row_for_new_MAC;
+
+}
+
+/*
+Returns whether the rssi signal at the input index of rssi_array is counted 
+by get_average_rssi. Whether a signal is counted depends only on itself and 
+on the signal before it in the ring.
+*/
+
+static bool _is_valid_rssi(const int8_t *rssi_array,
+                           int index,
+                           int number_of_rssi_signals_under_tracked,
+                           int rssi_threashold_for_summarize_location_pin,
+                           int unreasonable_rssi_change){
+
+    int prev_index = 
+        (index - 1 + number_of_rssi_signals_under_tracked) % 
+        number_of_rssi_signals_under_tracked;
+
+    if(rssi_array[index] == 0)
+        return false;
+
+    if(rssi_array[index] < rssi_threashold_for_summarize_location_pin)
+        return false;
+
+    if(rssi_array[prev_index] != 0 && 
+       abs(rssi_array[index] - rssi_array[prev_index]) > 
+       unreasonable_rssi_change)
+        return false;
+
+    return true;
+}
+
+/*
+Returns whether the running sum and count of valid signals of the record were
+kept with the input settings of the filter.
+*/
+
+static bool _record_sums_match(const uuid_record_table_row *record,
+                               int number_of_rssi_signals_under_tracked,
+                               int rssi_threashold_for_summarize_location_pin,
+                               int unreasonable_rssi_change){
+
+    return record -> sum_number_of_rssi_signals == 
+           number_of_rssi_signals_under_tracked &&
+           record -> sum_rssi_threshold == 
+           rssi_threashold_for_summarize_location_pin &&
+           record -> sum_unreasonable_rssi_change == 
+           unreasonable_rssi_change;
+}
+
+/*
+Recomputes the running sum and count of valid signals of the record from its
+ring with the input settings of the filter, and keeps the settings with them.
+*/
+
+static void _record_rebuild_rssi_sums(
+    uuid_record_table_row *record,
+    int number_of_rssi_signals_under_tracked,
+    int rssi_threashold_for_summarize_location_pin,
+    int unreasonable_rssi_change){
+
+    int k;
+
+    record -> valid_rssi_sum = 0;
+    record -> valid_rssi_count = 0;
+
+    for(k = 0; k < number_of_rssi_signals_under_tracked; k++){
+        if(_is_valid_rssi(record -> rssi_array, 
+                          k,
+                          number_of_rssi_signals_under_tracked,
+                          rssi_threashold_for_summarize_location_pin,
+                          unreasonable_rssi_change)){
+
+            record -> valid_rssi_sum += record -> rssi_array[k];
+            record -> valid_rssi_count++;
+        }
+    }
+
+    record -> sum_number_of_rssi_signals = 
+        (short)number_of_rssi_signals_under_tracked;
+    record -> sum_rssi_threshold = 
+        (short)rssi_threashold_for_summarize_location_pin;
+    record -> sum_unreasonable_rssi_change = 
+        (short)unreasonable_rssi_change;
+}
+
+/*
+Writes the rssi signal at the input index of the ring of the record and 
+keeps the running sum and count of valid signals. Writing one signal changes
+whether it and the signal after it are counted, so only these two are taken 
+out of the running values and added back. If the settings of the filter have
+changed since the running values were kept, or the record is new, they are 
+rebuilt from the whole ring instead.
+*/
+
+static void _record_write_rssi(uuid_record_table_row *record,
+                               int write_index,
+                               int8_t rssi,
+                               int number_of_rssi_signals_under_tracked,
+                               int rssi_threashold_for_summarize_location_pin,
+                               int unreasonable_rssi_change){
+
+    int affected_index[2];
+    int number_of_affected = 2;
+    int i;
+
+    if(!_record_sums_match(record,
+                           number_of_rssi_signals_under_tracked,
+                           rssi_threashold_for_summarize_location_pin,
+                           unreasonable_rssi_change)){
+
+        record -> rssi_array[write_index] = rssi;
+
+        _record_rebuild_rssi_sums(record,
+                                  number_of_rssi_signals_under_tracked,
+                                  rssi_threashold_for_summarize_location_pin,
+                                  unreasonable_rssi_change);
+        return;
+    }
+
+    affected_index[0] = write_index;
+    affected_index[1] = (write_index + 1) % 
+                        number_of_rssi_signals_under_tracked;
+
+    // a ring of one signal compares the signal with itself
+    if(affected_index[1] == affected_index[0])
+        number_of_affected = 1;
+
+    for(i = 0; i < number_of_affected; i++){
+        if(_is_valid_rssi(record -> rssi_array, 
+                          affected_index[i],
+                          number_of_rssi_signals_under_tracked,
+                          rssi_threashold_for_summarize_location_pin,
+                          unreasonable_rssi_change)){
+
+            record -> valid_rssi_sum -= 
+                record -> rssi_array[affected_index[i]];
+            record -> valid_rssi_count--;
+        }
+    }
+
+    record -> rssi_array[write_index] = rssi;
+
+    for(i = 0; i < number_of_affected; i++){
+        if(_is_valid_rssi(record -> rssi_array, 
+                          affected_index[i],
+                          number_of_rssi_signals_under_tracked,
+                          rssi_threashold_for_summarize_location_pin,
+                          unreasonable_rssi_change)){
+
+            record -> valid_rssi_sum += 
+                record -> rssi_array[affected_index[i]];
+            record -> valid_rssi_count++;
+        }
+    }
+}
+
+/*
+Appends the row to the list of urgent rows of the hashtable. Returns false if
+the list cannot be enlarged.
+*/
+
+static bool _hashtable_queue_urgent_row(HashTable * h_table,
+                                        const UrgentRow * urgent_row){
+
+    UrgentRow * urgent_rows;
+    int max_urgent_rows;
+
+    pthread_mutex_lock(&h_table->urgent_mutex);
+
+    if(h_table->number_urgent_rows == h_table->max_urgent_rows){
+
+        max_urgent_rows = h_table->max_urgent_rows * 2;
+        if(max_urgent_rows == 0)
+            max_urgent_rows = INITIAL_URGENT_ROWS_SIZE;
+
+        urgent_rows = realloc(h_table->urgent_rows, 
+                              sizeof(UrgentRow) * max_urgent_rows);
+        if(urgent_rows == NULL){
+            pthread_mutex_unlock(&h_table->urgent_mutex);
+            zlog_error(category_debug, "cannot expand urgent rows");
+            return false;
+        }
+
+        h_table->urgent_rows = urgent_rows;
+        h_table->max_urgent_rows = max_urgent_rows;
+    }
+
+    h_table->urgent_rows[h_table->number_urgent_rows] = *urgent_row;
+    h_table->number_urgent_rows++;
+
+    pthread_mutex_unlock(&h_table->urgent_mutex);
+
+    return true;
+}
+
+/*
+Makes the row of a time critical area urgent if the record just updated may 
+change the closest lbeacon of the object, by the same rssi difference the 
+summary pass uses to change it. The node_lock of the row is held. A row 
+which has no closest lbeacon yet is made urgent by its first signal.
+*/
+
+static void _hashtable_check_urgent_row(
+    HashTable * h_table,
+    hash_table_row * table_row,
+    uuid_record_table_row * record,
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change){
+
+    int avg_rssi;
+    UrgentRow urgent_row;
+
+    if(!h_table->is_time_critical || table_row->is_urgent)
+        return;
+
+    avg_rssi = get_record_average_rssi(
+        record,
+        number_of_rssi_signals_under_tracked,
+        rssi_threashold_for_summarize_location_pin,
+        unreasonable_rssi_change);
+
+    if(avg_rssi == 0)
+        return;
+
+    if(table_row->summary_lbeacon_id != LBEACON_ID_UNKNOWN){
+
+        if(record->lbeacon_id == table_row->summary_lbeacon_id){
+
+            // the closest lbeacon is fading away
+            if(table_row->average_rssi - avg_rssi <= 
+               time_critical_rssi_difference)
+                return;
+
+        }else{
+
+            // another lbeacon is taking over
+            if(avg_rssi - table_row->average_rssi <= 
+               time_critical_rssi_difference)
+                return;
+        }
+    }
+
+    urgent_row.row_index = table_row->row_index;
+    urgent_row.mac_address = table_row->mac_address;
+    urgent_row.urgent_time = get_clock_time_in_ms();
+
+    if(_hashtable_queue_urgent_row(h_table, &urgent_row))
+        table_row->is_urgent = true;
+}
+
+void hashtable_put_new_tracking_data(
+    HashTable * h_table, 
+    const uint64_t key, 
+    DataForHashtable * value, 
+    const int number_of_lbeacons_under_tracked,
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change){
+
+    int i;
+    int write_index = 0;
+    int time_gap = 0;
+    int number_of_missed_signals;
+    
+    int j = 0;
+    int index_not_used = 0;
+    int record_table_size;
+    int8_t rssi;
+    HashShard * shard = hashtable_get_shard(h_table, key);
+    hash_table_row * exist_MAC_address_row;
+    uuid_record_table_row * record;
+    const int MISSED_SINGAL_SINCE_SECONDS = 2;
+    int current_time = get_system_time();
+    long dirty_bit;
+    volatile long * dirty_word;
+
+    // rssi values are kept in one byte. Anything outside the range is not a
+    // valid rssi, and is clamped rather than wrapped around to another value.
+    if(value -> rssi < INT8_MIN)
+        rssi = INT8_MIN;
+    else if(value -> rssi > INT8_MAX)
+        rssi = INT8_MAX;
+    else
+        rssi = (int8_t)value -> rssi;
+
+    // Objects already in the table are found in shared mode, so updates of
+    // different objects proceed in parallel. The shard lock is taken 
+    // exclusively only to add a new object.
+    pthread_rwlock_rdlock(&shard->shard_lock);
+
+    exist_MAC_address_row = hashtable_find_row(h_table, key);
+
+    if(exist_MAC_address_row == NULL){
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+        pthread_rwlock_wrlock(&shard->shard_lock);
+
+        exist_MAC_address_row = hashtable_maintain_key_part(
+            h_table, 
+            key, 
+            number_of_lbeacons_under_tracked,
+            number_of_rssi_signals_under_tracked);
+    
+        if(exist_MAC_address_row == NULL){
+            pthread_rwlock_unlock(&shard->shard_lock);
+            return;
+        }
+    }
+
+    // lock node of mac_address and release the shard lock. The row cannot be
+    // removed while its node_lock is held.
+    pthread_mutex_lock(&exist_MAC_address_row -> node_lock);
+    pthread_rwlock_unlock(&shard->shard_lock);
+
+    // the next summary pass recomputes the location of the object. The bit
+    // is set under node_lock, so a pass taking the bit sees this update 
+    // once it takes node_lock.
+    dirty_word = &h_table -> dirty_rows[exist_MAC_address_row -> row_index / 
+                                        ROWS_IN_ONE_DIRTY_WORD];
+    dirty_bit = (long)(1UL << (exist_MAC_address_row -> row_index % 
+                               ROWS_IN_ONE_DIRTY_WORD));
+
+    if((*dirty_word & dirty_bit) == 0)
+        atomic_or(dirty_word, dirty_bit);
+
+    // update real-time information 
+    record_table_size = exist_MAC_address_row -> number_uuid_records;
+
+    hashtable_begin_row_update(exist_MAC_address_row);
+    strcpy(exist_MAC_address_row -> battery, 
+           value -> battery_voltage);
+    strcpy(exist_MAC_address_row -> panic_button,
+           value->panic_button);
+    hashtable_end_row_update(exist_MAC_address_row);
+    
+    //search lbeacon uuid in the array of recently scanned 
+    //lbeacon uuid
+    index_not_used = -1;
+
+    for(i = 0; i < record_table_size; i++){
+
+        record = get_uuid_record(exist_MAC_address_row, i);
+
+        // release the record of lbeacon which has not scanned this object 
+        // for long time. The summary pass releases it only when the object 
+        // is summarized, which may be later than this update.
+        if(record -> is_in_use &&
+           record -> last_reported_timestamp < 
+           current_time - number_of_rssi_signals_under_tracked){
+
+            record -> is_in_use = false;
+        }
+
+        if(index_not_used == -1 && !record -> is_in_use){
+
+           // record the index of not used space of uuid array for 
+           // not-found case below.
+           index_not_used = i;
+
+        }else if(record -> is_in_use && 
+                 value -> lbeacon_id == record -> lbeacon_id){
+
+            // fill the missing rssi signal as zero.
+            time_gap = value -> final_timestamp_GMT - 
+                       record -> final_timestamp;
+
+            record -> final_timestamp = value -> final_timestamp_GMT;
+
+            record -> last_reported_timestamp = get_system_time();
+
+            write_index = record -> write_index;
+
+            // fill zero to rssi_array[] for the missing seconds. Zeros are
+            // never counted, so a gap covering the whole ring just clears 
+            // it, and the work under node_lock is bounded by the size of 
+            // the ring however long the object was not scanned.
+            if(time_gap >= MISSED_SINGAL_SINCE_SECONDS){
+
+                number_of_missed_signals = 
+                    time_gap - MISSED_SINGAL_SINCE_SECONDS + 1;
+
+                if(number_of_missed_signals >= 
+                   number_of_rssi_signals_under_tracked){
+
+                    memset(record -> rssi_array, 0, 
+                           number_of_rssi_signals_under_tracked);
+                    record -> valid_rssi_sum = 0;
+                    record -> valid_rssi_count = 0;
+
+                    write_index = 
+                        (write_index + number_of_missed_signals % 
+                         number_of_rssi_signals_under_tracked) % 
+                        number_of_rssi_signals_under_tracked;
+
+                }else{
+
+                    for(j = 0; j < number_of_missed_signals; j++){
+            
+                        write_index++;
+                        if(write_index >= 
+                           number_of_rssi_signals_under_tracked){
+
+                            write_index = 0;
+                        }
+
+                        _record_write_rssi(
+                            record,
+                            write_index,
+                            0,
+                            number_of_rssi_signals_under_tracked,
+                            rssi_threashold_for_summarize_location_pin,
+                            unreasonable_rssi_change);
+                    }
+                }
+            }
+        
+            // the ring may have been longer when the last signal was 
+            // written
+            write_index++;
+            if(write_index >= 
+                number_of_rssi_signals_under_tracked){
+
+                write_index = 0;
+            }
+       
+            _record_write_rssi(record,
+                               write_index,
+                               rssi,
+                               number_of_rssi_signals_under_tracked,
+                               rssi_threashold_for_summarize_location_pin,
+                               unreasonable_rssi_change);
+
+            record -> write_index = write_index;
+
+            _hashtable_check_urgent_row(
+                h_table, 
+                exist_MAC_address_row, 
+                record,
+                number_of_rssi_signals_under_tracked,
+                rssi_threashold_for_summarize_location_pin,
+                unreasonable_rssi_change);
+
+            pthread_mutex_unlock(&exist_MAC_address_row -> node_lock);
+            return;
+        } // else
+    } // for-loop
+
+    // hand out a record never used before, taking the overflow block when 
+    // the inline records run out
+    if(index_not_used == -1 &&
+       record_table_size < exist_MAC_address_row -> number_uuid_size){
+
+        if(record_table_size == NUMBER_OF_INLINE_UUID_RECORDS){
+
+            exist_MAC_address_row -> overflow_uuid_record_table_array = 
+                mp_alloc(&h_table -> overflow_mempool);
+
+            if(exist_MAC_address_row -> overflow_uuid_record_table_array != 
+               NULL){
+
+                memset(exist_MAC_address_row -> 
+                       overflow_uuid_record_table_array, 0, 
+                       sizeof(uuid_record_table_row) * 
+                       NUMBER_OF_OVERFLOW_UUID_RECORDS);
+                index_not_used = record_table_size;
+            }
+        }else{
+            index_not_used = record_table_size;
+        }
+
+        if(index_not_used != -1){
+            hashtable_begin_row_update(exist_MAC_address_row);
+            exist_MAC_address_row -> number_uuid_records = 
+                record_table_size + 1;
+            hashtable_end_row_update(exist_MAC_address_row);
+        }
+    }
+
+    // case of new lbeacon uuid
+    if(index_not_used != -1){
+
+        record = get_uuid_record(exist_MAC_address_row, index_not_used);
+    
+        record -> lbeacon_id = value -> lbeacon_id;
+
+        record -> initial_timestamp = value -> initial_timestamp_GMT;
+
+        record -> final_timestamp = value -> final_timestamp_GMT;
+
+        record -> last_reported_timestamp  = get_system_time();
+
+        // the signals left in the ring by the previous lbeacon of a reused
+        // record stay, and so do their running sum and count
+        write_index = 0;
+        _record_write_rssi(record,
+                           write_index,
+                           rssi,
+                           number_of_rssi_signals_under_tracked,
+                           rssi_threashold_for_summarize_location_pin,
+                           unreasonable_rssi_change);
+
+        record -> write_index = write_index;
+    
+        record -> is_in_use = true;
+
+        _hashtable_check_urgent_row(
+            h_table, 
+            exist_MAC_address_row, 
+            record,
+            number_of_rssi_signals_under_tracked,
+            rssi_threashold_for_summarize_location_pin,
+            unreasonable_rssi_change);
+    
+    }else{
+        zlog_error(category_debug,"need more uuid record table");
+    } 
+
+    pthread_mutex_unlock(&exist_MAC_address_row->node_lock);
+
+    return;
+}
+
+int get_rssi_weight(float average_rssi,
+                    const int rssi_weight_multiplier){
+    
+    //return the corresponding weight according to the rssi singal 
+    if(average_rssi > -40)
+        return pow(rssi_weight_multiplier, 9);
+    else if(average_rssi > -45)
+        return pow(rssi_weight_multiplier, 8);
+    else if(average_rssi > -50)
+        return pow(rssi_weight_multiplier, 7);
+    else if(average_rssi > -55)
+        return pow(rssi_weight_multiplier, 6);
+    else if(average_rssi > -60)
+        return pow(rssi_weight_multiplier, 5);
+    else if(average_rssi > -65)
+        return pow(rssi_weight_multiplier, 4);
+    else if(average_rssi > -70)
+        return pow(rssi_weight_multiplier, 3);
+    else if(average_rssi > -80)
+        return pow(rssi_weight_multiplier, 2);
+    else if(average_rssi > -90)
+        return pow(rssi_weight_multiplier, 1);
+    else if(average_rssi >= -100)
+        return 1;
+    return 0;
+}
+
+ErrorCode update_rssi_weight_table(const int rssi_weight_multiplier){
+
+    RssiWeightTable * new_table;
+    int i;
+
+    new_table = malloc(sizeof(RssiWeightTable));
+    if(new_table == NULL){
+        zlog_error(category_debug, "cannot allocate rssi weight table");
+        return E_MALLOC;
+    }
+
+    new_table->rssi_weight_multiplier = rssi_weight_multiplier;
+
+    for(i = 0; i < NUMBER_OF_RSSI_WEIGHTS; i++){
+        new_table->weights[i] = 
+            get_rssi_weight((float)(i + INT8_MIN), rssi_weight_multiplier);
+    }
+
+    new_table->replaced = rssi_weight_table;
+
+    // the weights must be visible before the table is
+    memory_barrier();
+    rssi_weight_table = new_table;
+
+    return WORK_SUCCESSFULLY;
+}
+
+void destroy_rssi_weight_table(){
+
+    RssiWeightTable * table = rssi_weight_table;
+    RssiWeightTable * replaced;
+
+    rssi_weight_table = NULL;
+
+    while(table != NULL){
+        replaced = table->replaced;
+        free(table);
+        table = replaced;
+    }
+}
+
+int get_average_rssi(const int8_t *rssi_array,
+                     const int rssi_threashold_for_summarize_location_pin,
+                     const int number_of_rssi_signals_under_tracked,
+                     const int unreasonable_rssi_change){
+
+    int k = 0;
+    int valid_rssi_count = 0;
+    int prev_index = 0;
+    int sum_rssi = 0;
+    int ret_avg_rssi = 0;
+
+    for(k = 0; k < number_of_rssi_signals_under_tracked; k++){
+
+        // ignore the timing at which no rssi signal was scanned
+        if(rssi_array[k] == 0)
+            continue;
+   
+        // ignore weak rssi signals from poor lbeacons
+        if(rssi_array[k] < rssi_threashold_for_summarize_location_pin)
+            continue;
+
+        prev_index = 
+            (k - 1 + number_of_rssi_signals_under_tracked) % 
+            number_of_rssi_signals_under_tracked;
+
+        // ignore abnormal signal
+        if(rssi_array[prev_index] != 0 && 
+           abs(rssi_array[k] - rssi_array[prev_index]) > 
+           unreasonable_rssi_change){
+                        
+            continue;
+        }
+                            
+        sum_rssi += rssi_array[k];
+        valid_rssi_count++; 
+    }
+    if(valid_rssi_count == 0 )
+        return ret_avg_rssi;
+
+    ret_avg_rssi = sum_rssi / valid_rssi_count;
+    return ret_avg_rssi;
+}
+
+int get_record_average_rssi(
+    const uuid_record_table_row *record,
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change){
+
+    // the running values were kept with other settings. They are rebuilt
+    // by the next write, and the ring is walked until then.
+    if(!_record_sums_match(record,
+                           number_of_rssi_signals_under_tracked,
+                           rssi_threashold_for_summarize_location_pin,
+                           unreasonable_rssi_change)){
+
+        return get_average_rssi(record -> rssi_array,
+                                rssi_threashold_for_summarize_location_pin,
+                                number_of_rssi_signals_under_tracked,
+                                unreasonable_rssi_change);
+    }
+
+    if(record -> valid_rssi_count == 0)
+        return 0;
+
+    return record -> valid_rssi_sum / record -> valid_rssi_count;
+}
+
+/*
+Schedules the row to be summarized again at the input time in the timeout 
+wheel of the summary chunk of the row, or in the coarse wheel if the time is
+beyond the timeout wheel. The time is clamped to the range of the coarse 
+wheel. A row whose entry in either wheel is not later than the input time 
+keeps the entry, and is moved to the slot of the input time when the entry 
+comes, so rows updated every second are not added to the wheel at every 
+pass.
+*/
+
+static void _hashtable_schedule_row(HashTable * h_table, 
+                                    hash_table_row * table_row,
+                                    int timeout_timestamp,
+                                    int current_time){
+
+    SummaryChunk * summary_chunk = 
+        h_table->summary_chunks[table_row->row_index / 
+                                ROWS_IN_ONE_SUMMARY_CHUNK];
+    TimeoutWheelSlot * slot;
+    TimeoutEntry * entries;
+    int max_entries;
+    int wheel_timestamp;
+
+    if(timeout_timestamp <= current_time)
+        timeout_timestamp = current_time + 1;
+    else if(timeout_timestamp > 
+            current_time + COARSE_TIMEOUT_WHEEL_SPAN_IN_SEC - 1)
+        timeout_timestamp = current_time + COARSE_TIMEOUT_WHEEL_SPAN_IN_SEC - 1;
+
+    table_row->timeout_timestamp = timeout_timestamp;
+
+    if(table_row->wheel_timestamp != 0 &&
+       table_row->wheel_timestamp <= timeout_timestamp)
+        return;
+
+    if(timeout_timestamp < current_time + NUMBER_OF_TIMEOUT_WHEEL_SLOTS){
+
+        wheel_timestamp = timeout_timestamp;
+        slot = &summary_chunk->timeout_wheel[wheel_timestamp % 
+                                             NUMBER_OF_TIMEOUT_WHEEL_SLOTS];
+    }else{
+
+        // the entry comes at the start of the period of the coarse slot, 
+        // which is after the current time and within the timeout wheel 
+        // from then on
+        wheel_timestamp = timeout_timestamp - 
+                          timeout_timestamp % NUMBER_OF_TIMEOUT_WHEEL_SLOTS;
+        slot = &summary_chunk->coarse_timeout_wheel[
+                   (wheel_timestamp / NUMBER_OF_TIMEOUT_WHEEL_SLOTS) % 
+                   NUMBER_OF_COARSE_TIMEOUT_WHEEL_SLOTS];
+    }
+
+    if(slot->number_entries == slot->max_entries){
+
+        max_entries = slot->max_entries * 2;
+        if(max_entries == 0)
+            max_entries = INITIAL_TIMEOUT_WHEEL_SLOT_SIZE;
+
+        entries = realloc(slot->entries, sizeof(TimeoutEntry) * max_entries);
+        if(entries == NULL){
+            zlog_error(category_debug, "cannot expand timeout wheel");
+            return;
+        }
+
+        slot->entries = entries;
+        slot->max_entries = max_entries;
+    }
+
+    slot->entries[slot->number_entries].row_index = table_row->row_index;
+    slot->entries[slot->number_entries].wheel_timestamp = wheel_timestamp;
+    slot->number_entries++;
+
+    table_row->wheel_timestamp = wheel_timestamp;
+}
+
+/*
+Runs the location estimator over the batch and updates the location pins and the
+closest lbeacons of the objects in the batch, and schedules the objects in 
+the timeout wheel. The node_locks of the rows of the objects have been held
+since the objects were staged, and are released here. The batch is emptied.
+*/
+
+static void _summary_batch_apply(
+    HashTable * h_table,
+    SummaryBatch * batch,
+    int current_time,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance){
+
+    int o;
+    int timeout_timestamp;
+    float summary_coordinateX_this_turn;
+    float summary_coordinateY_this_turn;
+    SummaryObject * object;
+    hash_table_row * table_row;
+
+    location_estimator->estimate_locations(batch, current_time);
+
+    for(o = 0; o < batch->number_objects; o++){
+
+        object = &batch->objects[o];
+        table_row = object->table_row;
+
+        // update the position of location pin. Without any weight the 
+        // location is kept, and the object is due for eviction when it has
+        // not been located for long time.
+        if(!batch->is_located[o]){
+
+            timeout_timestamp = 
+                hashtable_get_located_timestamp(table_row, current_time) + 
+                h_table->tolerant_not_scanning_time_in_sec + 1;
+
+            if(object->record_expiry_timestamp < timeout_timestamp)
+                timeout_timestamp = object->record_expiry_timestamp;
+
+            _hashtable_schedule_row(h_table,
+                                    table_row,
+                                    timeout_timestamp,
+                                    current_time);
+
+            pthread_mutex_unlock(&table_row->node_lock);
+            continue;
+        }
+
+        hashtable_begin_row_update(table_row);
+
+        summary_coordinateX_this_turn = batch->estimated_x[o];
+        summary_coordinateY_this_turn = batch->estimated_y[o];
+
+        // avoid moving location pins when the objects are not really moved.
+        if(abs(summary_coordinateX_this_turn - 
+               table_row->summary_coordinateX) > drift_distance || 
+           abs(summary_coordinateY_this_turn - 
+               table_row->summary_coordinateY) > drift_distance){
+            //coordinateX
+            table_row->summary_coordinateX = 
+                summary_coordinateX_this_turn;
+            //coordinateY
+            table_row->summary_coordinateY = 
+                summary_coordinateY_this_turn;
+        }  
+
+        // update the closest lbeacon
+        if(object->summary_index == -1 || 
+           (object->strongest_avg_rssi - object->summary_avg_rssi > 
+            rssi_difference_of_location_accuracy_tolerance) ){
+
+            table_row->average_rssi = object->strongest_avg_rssi;
+            table_row->summary_lbeacon_id = object->strongest_lbeacon_id;
+            // MUST use final_timestamp but not initiali_timesatmp to have 
+            // correct lasting time under this newly closest lbeacon uuid.
+            table_row->initial_timestamp = object->strongest_final_timestamp;
+            table_row->final_timestamp = object->strongest_final_timestamp;
+       
+        }else{
+    
+            table_row->average_rssi = object->summary_avg_rssi;
+            table_row->summary_lbeacon_id = object->summary_lbeacon_id;
+            table_row->final_timestamp = object->summary_final_timestamp;
+        }
+
+        table_row->last_reported_timestamp = current_time;
+        table_row->location_expiry_timestamp = 
+            object->location_expiry_timestamp;
+
+        hashtable_end_row_update(table_row);
+
+        // the location stays the same until new tracking data arrive or a 
+        // record used by it becomes stale. Records not used are released 
+        // when they become stale.
+        timeout_timestamp = object->location_expiry_timestamp;
+
+        if(object->record_expiry_timestamp < timeout_timestamp)
+            timeout_timestamp = object->record_expiry_timestamp;
+
+        _hashtable_schedule_row(h_table, 
+                                table_row, 
+                                timeout_timestamp,
+                                current_time);
+
+        pthread_mutex_unlock(&table_row->node_lock);
+    }
+
+    batch->number_objects = 0;
+    batch->max_number_weights = 0;
+}
+
+/*
+Evicts the row if it has not been located for long time, or stages the row 
+in the summary batch otherwise. The node_lock of a staged row is held until 
+the batch is applied.
+*/
+
+static void _summary_visit_row(
+    HashTable * h_table,
+    SummaryBatch * batch,
+    hash_table_row * table_row,
+    int current_time,
+    RssiWeightTable * weight_table,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance){
+
+    int j = 0;
+    int m = 0;
+    int avg_rssi;
+    int weight_count_for_specific_uuid;
+    uuid_record_table_row * record;
+    LBeaconRegistryEntry * lbeacon;
+    uint64_t mac_address;
+    HashShard * shard;
+    SummaryObject * object;
+    int lane;
+    int number_weights;
+
+    if(!table_row->is_in_use)
+        return;
+
+    //release the old row from hashtable to have more space. The row is
+    //checked without lock first, and checked again under both locks 
+    //taken in the same order as hashtable_put_new_tracking_data. The row
+    //may have been reused by another object in between, so its key is
+    //checked again as well.
+    if(hashtable_get_located_timestamp(table_row, current_time) < 
+       current_time - 
+       h_table->tolerant_not_scanning_time_in_sec ){
+
+        // Taking the shard lock while holding the node_locks of the 
+        // batch could deadlock with a put waiting for one of them under
+        // the shard lock, so the batch is finished first.
+        _summary_batch_apply(h_table,
+                             batch,
+                             current_time,
+                             rssi_difference_of_location_accuracy_tolerance,
+                             drift_distance);
+
+        mac_address = table_row -> mac_address;
+        shard = hashtable_get_shard(h_table, mac_address);
+
+        pthread_rwlock_wrlock(&shard->shard_lock);
+        pthread_mutex_lock(&table_row->node_lock);
+
+        if(table_row -> is_in_use &&
+           table_row -> mac_address == mac_address &&
+           hashtable_get_located_timestamp(table_row, current_time) < 
+           current_time - 
+           h_table->tolerant_not_scanning_time_in_sec ){
+
+            // remove the slot, destroy value part and release the row
+            hashtable_remove_row(h_table, mac_address);
+        }else{
+            pthread_mutex_unlock(&table_row->node_lock);
+        }
+
+        pthread_rwlock_unlock(&shard->shard_lock);
+
+        return;
+    }
+
+    pthread_mutex_lock(&table_row->node_lock);
+
+    if(!table_row->is_in_use){
+        pthread_mutex_unlock(&table_row->node_lock);
+        return;
+    }
+
+    // the row is not visited again from the timeout wheel until it is 
+    // scheduled again by _summary_batch_apply
+    table_row->timeout_timestamp = 0;
+
+    //reset the summary data
+    lane = batch->number_objects;
+    object = &batch->objects[lane];
+
+    object->table_row = table_row;
+    number_weights = 0;
+    object->summary_index = -1;
+    object->summary_avg_rssi = INITIAL_AVERAGE_RSSI;
+    object->summary_lbeacon_id = LBEACON_ID_UNKNOWN;
+    object->summary_final_timestamp = 0;
+    object->strongest_avg_rssi = INITIAL_AVERAGE_RSSI;
+    object->strongest_lbeacon_id = LBEACON_ID_UNKNOWN;
+    object->strongest_final_timestamp = 0;
+    object->location_expiry_timestamp = 
+        current_time + NUMBER_OF_TIMEOUT_WHEEL_SLOTS;
+    object->record_expiry_timestamp = 
+        current_time + COARSE_TIMEOUT_WHEEL_SPAN_IN_SEC;
+   
+    //calculate the average rssi signal of current summary lbeacon uuid
+    for(m = 0; m < table_row -> number_uuid_records; m++){
+
+        record = get_uuid_record(table_row, m);
+
+        if(record -> is_in_use &&
+           record -> lbeacon_id == table_row -> summary_lbeacon_id){
+
+            // ensure current summary lbeacon uuid is still scanning this
+            // object.
+            if(record -> last_reported_timestamp < 
+               current_time - number_of_rssi_signals_under_tracked){
+
+                record -> is_in_use = false;
+               
+                break;
+            }
+
+            // calculate the average rssi
+            avg_rssi = get_record_average_rssi(
+                record,
+                number_of_rssi_signals_under_tracked,
+                rssi_threashold_for_summarize_location_pin,
+                unreasonable_rssi_change);
+
+            if(avg_rssi != 0){
+                object->summary_index = m;
+                object->summary_avg_rssi = avg_rssi;
+                object->summary_lbeacon_id = record -> lbeacon_id;
+                object->summary_final_timestamp = 
+                    record -> final_timestamp;
+            }
+
+            break;
+        }
+    }
+
+    // choose the strongest lbeacon uuid, and stage the weights and 
+    // coordinates of all lbeacons for the summary kernel
+    for(j = 0 ; j < table_row -> number_uuid_records ; j++){
+
+        record = get_uuid_record(table_row, j);
+
+        // ignore not used element 
+        if(!record -> is_in_use) {
+            continue;   
+        }
+
+        
+        // ignore and delete old lbeacon uuid which has not scanned
+        // this object for long time.
+        if(record -> last_reported_timestamp < 
+           current_time - number_of_rssi_signals_under_tracked){
+
+            record -> is_in_use = false;
+            continue;
+        }
+
+        // the record is released when it becomes stale, whether or not it 
+        // is used by the location
+        if(record -> last_reported_timestamp + 
+           number_of_rssi_signals_under_tracked + 1 < 
+           object->record_expiry_timestamp){
+
+            object->record_expiry_timestamp = 
+                record -> last_reported_timestamp + 
+                number_of_rssi_signals_under_tracked + 1;
+        }
+        
+        // calculate the average rssi
+        avg_rssi = get_record_average_rssi(
+            record,
+            number_of_rssi_signals_under_tracked,
+            rssi_threashold_for_summarize_location_pin,
+            unreasonable_rssi_change);
+
+#ifdef debugging
+        if(avg_rssi != get_average_rssi(
+               record -> rssi_array,
+               rssi_threashold_for_summarize_location_pin,
+               number_of_rssi_signals_under_tracked,
+               unreasonable_rssi_change)){
+
+            zlog_error(category_debug, 
+                       "running average rssi [%d] of lbeacon [%s] " \
+                       "differs from the rssi array",
+                       avg_rssi,
+                       lbeacon_registry_get_uuid(record -> lbeacon_id));
+        }
+#endif
+
+        // ignore this lbeacon uuid if no signal data is used.
+        if(avg_rssi == 0){
+            continue;
+        }
+
+        // the location changes when this record becomes stale
+        if(record -> last_reported_timestamp + 
+           number_of_rssi_signals_under_tracked + 1 < 
+           object->location_expiry_timestamp){
+
+            object->location_expiry_timestamp = 
+                record -> last_reported_timestamp + 
+                number_of_rssi_signals_under_tracked + 1;
+        }
+
+        if(j != object->summary_index && 
+           avg_rssi > object->strongest_avg_rssi){
+
+            object->strongest_avg_rssi = (int) avg_rssi;
+            object->strongest_lbeacon_id = record -> lbeacon_id;
+            object->strongest_final_timestamp = record -> final_timestamp;
+        }
+
+        if(weight_table != NULL){
+            weight_count_for_specific_uuid = 
+                weight_table -> weights[avg_rssi - INT8_MIN];
+        }else{
+            weight_count_for_specific_uuid = 
+                get_rssi_weight(avg_rssi, rssi_weight_multiplier);
+        }
+
+        lbeacon = lbeacon_registry_get_entry(record -> lbeacon_id);
+
+        batch->weights[number_weights][lane] = 
+            weight_count_for_specific_uuid;
+        batch->coordinateX[number_weights][lane] = 
+            lbeacon -> coordinateX;
+        batch->coordinateY[number_weights][lane] = 
+            lbeacon -> coordinateY;
+
+        number_weights++;
+    }
+
+    object->number_weights = number_weights;
+
+    if(object->number_weights > batch->max_number_weights)
+        batch->max_number_weights = object->number_weights;
+
+    batch->number_objects++;
+
+    if(batch->number_objects == SUMMARY_BATCH_SIZE){
+        _summary_batch_apply(h_table,
+                             batch,
+                             current_time,
+                             rssi_difference_of_location_accuracy_tolerance,
+                             drift_distance);
+    }
+}
+
+/*
+Summarizes the rows due in the slot of the timeout wheel or the coarse wheel,
+and schedules the other rows of the slot again, which moves the rows of the 
+coarse wheel to the timeout wheel. Rows scheduled while the slot is processed
+are kept for a later round of the wheel.
+*/
+
+static void _summary_process_wheel_slot(
+    HashTable * h_table,
+    SummaryBatch * batch,
+    TimeoutWheelSlot * slot,
+    int current_time,
+    RssiWeightTable * weight_table,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance){
+
+    int i;
+    int number_entries = slot->number_entries;
+    TimeoutEntry * entry;
+    hash_table_row * table_row;
+
+    // the entries of a slot are allocated with its first entry
+    if(number_entries == 0)
+        return;
+
+    for(i = 0; i < number_entries; i++){
+
+        entry = &slot->entries[i];
+        table_row = hashtable_get_row(h_table, entry->row_index);
+
+        // the row has been evicted, or has an earlier entry
+        if(table_row->wheel_timestamp != entry->wheel_timestamp)
+            continue;
+
+        table_row->wheel_timestamp = 0;
+
+        // the row is in the batch and is scheduled when the batch is 
+        // applied
+        if(table_row->timeout_timestamp == 0)
+            continue;
+
+        if(table_row->timeout_timestamp > current_time){
+            _hashtable_schedule_row(h_table, 
+                                    table_row, 
+                                    table_row->timeout_timestamp, 
+                                    current_time);
+            continue;
+        }
+
+        _summary_visit_row(h_table, 
+                           batch, 
+                           table_row, 
+                           current_time,
+                           weight_table,
+                           rssi_threashold_for_summarize_location_pin,
+                           number_of_rssi_signals_under_tracked,
+                           unreasonable_rssi_change,
+                           rssi_weight_multiplier,
+                           rssi_difference_of_location_accuracy_tolerance,
+                           drift_distance);
+    }
+
+    memmove(slot->entries, 
+            slot->entries + number_entries,
+            sizeof(TimeoutEntry) * (slot->number_entries - number_entries));
+    slot->number_entries = slot->number_entries - number_entries;
+}
+
+void hashtable_summarize_location_chunk(
+    HashTable * h_table,
+    int chunk_index,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance) {
+
+    int i = 0;
+    int row_index;
+    int timestamp;
+    int first_word;
+    int end_word;
+    int row_count;
+    long dirty_bits;
+    SummaryChunk * summary_chunk;
+    long row_epoch;
+    RssiWeightTable * weight_table = rssi_weight_table;
+    SummaryBatch * batch;
+    int current_time = get_system_time();
+
+    // the summary chunk is allocated before its rows are counted
+    row_count = h_table->row_count;
+    memory_barrier();
+
+    if(chunk_index * ROWS_IN_ONE_SUMMARY_CHUNK >= row_count)
+        return;
+
+    summary_chunk = h_table->summary_chunks[chunk_index];
+
+    // another summary thread is working on this chunk
+    if(pthread_mutex_trylock(&summary_chunk->summary_mutex) != 0)
+        return;
+    
+    // the weights are computed on the fly until a table of the multiplier
+    // is loaded
+    if(weight_table != NULL && 
+       weight_table -> rssi_weight_multiplier != rssi_weight_multiplier)
+        weight_table = NULL;
+
+    batch = malloc(sizeof(SummaryBatch));
+    if(batch == NULL){
+        zlog_error(category_debug, "cannot allocate summary batch");
+        pthread_mutex_unlock(&summary_chunk->summary_mutex);
+        return;
+    }
+
+    batch->number_objects = 0;
+    batch->max_number_weights = 0;
+
+    // rows are read before their node_lock is taken, and rows evicted by 
+    // this pass are not reused until the pass ends
+    row_epoch = hashtable_enter_row_read(h_table);
+
+    // summarize the rows of the chunk updated since the last pass
+    first_word = chunk_index * 
+                 (ROWS_IN_ONE_SUMMARY_CHUNK / ROWS_IN_ONE_DIRTY_WORD);
+    end_word = (row_count + ROWS_IN_ONE_DIRTY_WORD - 1) / 
+               ROWS_IN_ONE_DIRTY_WORD;
+
+    if(end_word > first_word + 
+                  ROWS_IN_ONE_SUMMARY_CHUNK / ROWS_IN_ONE_DIRTY_WORD)
+        end_word = first_word + 
+                   ROWS_IN_ONE_SUMMARY_CHUNK / ROWS_IN_ONE_DIRTY_WORD;
+
+    for(i = first_word; i < end_word; i++){
+
+        if(h_table->dirty_rows[i] == 0)
+            continue;
+
+        // an update after this point sets the bit of its row again
+        dirty_bits = atomic_exchange(&h_table->dirty_rows[i], 0);
+
+        for(row_index = i * ROWS_IN_ONE_DIRTY_WORD; 
+            dirty_bits != 0; 
+            row_index++){
+
+            if(dirty_bits & 1){
+
+                _summary_visit_row(
+                    h_table, 
+                    batch, 
+                    hashtable_get_row(h_table, row_index), 
+                    current_time,
+                    weight_table,
+                    rssi_threashold_for_summarize_location_pin,
+                    number_of_rssi_signals_under_tracked,
+                    unreasonable_rssi_change,
+                    rssi_weight_multiplier,
+                    rssi_difference_of_location_accuracy_tolerance,
+                    drift_distance);
+            }
+
+            dirty_bits = (long)((unsigned long)dirty_bits >> 1);
+        }
+    }
+
+    // move the rows of the coarse wheel due since the last pass to the 
+    // timeout wheel, or summarize them if they are due already. After a long
+    // pause every coarse slot is due once. If the clock has been set back,
+    // the wheel restarts from the current time.
+    timestamp = summary_chunk->timeout_wheel_timestamp;
+
+    if(timestamp > current_time || 
+       current_time - timestamp > COARSE_TIMEOUT_WHEEL_SPAN_IN_SEC)
+        timestamp = current_time - COARSE_TIMEOUT_WHEEL_SPAN_IN_SEC;
+
+    timestamp = timestamp - timestamp % NUMBER_OF_TIMEOUT_WHEEL_SLOTS + 
+                NUMBER_OF_TIMEOUT_WHEEL_SLOTS;
+
+    while(timestamp <= current_time){
+
+        _summary_process_wheel_slot(
+            h_table,
+            batch,
+            &summary_chunk->coarse_timeout_wheel[
+                (timestamp / NUMBER_OF_TIMEOUT_WHEEL_SLOTS) % 
+                NUMBER_OF_COARSE_TIMEOUT_WHEEL_SLOTS],
+            current_time,
+            weight_table,
+            rssi_threashold_for_summarize_location_pin,
+            number_of_rssi_signals_under_tracked,
+            unreasonable_rssi_change,
+            rssi_weight_multiplier,
+            rssi_difference_of_location_accuracy_tolerance,
+            drift_distance);
+
+        timestamp += NUMBER_OF_TIMEOUT_WHEEL_SLOTS;
+    }
+
+    // summarize the rows due in the timeout wheel since the last pass. After
+    // a long pause every slot is due once. If the clock has been set back, 
+    // the wheel restarts from the current time.
+    timestamp = summary_chunk->timeout_wheel_timestamp;
+
+    if(timestamp > current_time || 
+       current_time - timestamp > NUMBER_OF_TIMEOUT_WHEEL_SLOTS)
+        timestamp = current_time - NUMBER_OF_TIMEOUT_WHEEL_SLOTS;
+
+    while(timestamp < current_time){
+
+        timestamp++;
+
+        _summary_process_wheel_slot(
+            h_table,
+            batch,
+            &summary_chunk->timeout_wheel[timestamp % 
+                                          NUMBER_OF_TIMEOUT_WHEEL_SLOTS],
+            current_time,
+            weight_table,
+            rssi_threashold_for_summarize_location_pin,
+            number_of_rssi_signals_under_tracked,
+            unreasonable_rssi_change,
+            rssi_weight_multiplier,
+            rssi_difference_of_location_accuracy_tolerance,
+            drift_distance);
+    }
+
+    summary_chunk->timeout_wheel_timestamp = current_time;
+
+    _summary_batch_apply(h_table,
+                         batch,
+                         current_time,
+                         rssi_difference_of_location_accuracy_tolerance,
+                         drift_distance);
+
+    hashtable_exit_row_read(h_table, row_epoch);
+
+    pthread_mutex_unlock(&summary_chunk->summary_mutex);
+
+    free(batch);
+}
+
+void hashtable_summarize_location_information(
+    HashTable * h_table,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance) {
+
+    int number_chunks = hashtable_get_number_summary_chunks(h_table);
+    int chunk_index;
+
+    for(chunk_index = 0; chunk_index < number_chunks; chunk_index++){
+
+        hashtable_summarize_location_chunk(
+            h_table,
+            chunk_index,
+            rssi_threashold_for_summarize_location_pin,
+            number_of_rssi_signals_under_tracked,
+            unreasonable_rssi_change,
+            rssi_weight_multiplier,
+            rssi_difference_of_location_accuracy_tolerance,
+            drift_distance);
+    }
+}
+
+void hashtable_traverse_areas_to_upload_latest_location(
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
+    AreaWorkQueue *work_queue,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance){
+
+    AreaWorkItem item;
+    AreaWork * area_work;
+    LocationBuffer * buffer;
+    
+    while(_area_work_queue_take(work_queue, &item)){
+
+        area_work = item.area_work;
+        buffer = &area_work->buffers[item.chunk_index];
+
+        zlog_debug(category_debug,"area table id %d chunk %d",
+                   area_work->entry.area_id,
+                   item.chunk_index);
+
+        hashtable_summarize_location_chunk(
+            area_work->entry.area_hash_ptr, 
+            item.chunk_index,
+            rssi_threashold_for_summarize_location_pin,
+            number_of_rssi_signals_under_tracked,
+            unreasonable_rssi_change,
+            rssi_weight_multiplier,
+            rssi_difference_of_location_accuracy_tolerance,
+            drift_distance);
+
+        buffer->length = 0;
+
+        hashtable_format_location_chunk(
+            area_work->entry.area_hash_ptr,
+            area_work->entry.area_id,
+            item.chunk_index,
+            LATEST_LOCATION_INFO,
+            number_of_rssi_signals_under_tracked,
+            buffer);
+
+        // the lines of all chunks of the area are uploaded together
+        if(_area_work_queue_finish_chunk(work_queue, &item)){
+
+            hashtable_upload_location_buffers(
+                db_connection_list_head,
+                server_installation_path,
+                LATEST_LOCATION_INFO,
+                number_of_rssi_signals_under_tracked,
+                area_work->buffers,
+                area_work->number_chunks);
+
+            _area_work_queue_finish(work_queue);
+        }
+    }
+}
+
+void hashtable_traverse_areas_to_upload_history_data(
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
+    AreaWorkQueue *work_queue,
+    const int number_of_rssi_signals_under_tracked){
+    
+    AreaWorkItem item;
+    AreaWork * area_work;
+    LocationBuffer * buffer;
+
+    while(_area_work_queue_take(work_queue, &item)){
+
+        area_work = item.area_work;
+        buffer = &area_work->buffers[item.chunk_index];
+
+        zlog_debug(category_debug,
+                   "hashtable_traverse_all_areas_to_upload_history_data: " \
+                   "area table id %d chunk %d",
+                   area_work->entry.area_id,
+                   item.chunk_index);    
+
+        buffer->length = 0;
+
+        hashtable_format_location_chunk(
+            area_work->entry.area_hash_ptr,
+            area_work->entry.area_id,
+            item.chunk_index,
+            LOCATION_FOR_HISTORY,
+            number_of_rssi_signals_under_tracked,
+            buffer);
 
-        prev_index = 
-            (k - 1 + number_of_rssi_signals_under_tracked) % 
-            number_of_rssi_signals_under_tracked;
+        // the lines of all chunks of the area are uploaded together
+        if(_area_work_queue_finish_chunk(work_queue, &item)){
 
-        // ignore abnormal signal
-        if(rssi_array[prev_index] != 0 && 
-           abs(rssi_array[k] - rssi_array[prev_index]) > 
-           unreasonable_rssi_change){
-                        
-            continue;
+            hashtable_upload_location_buffers(
+                db_connection_list_head,
+                server_installation_path,
+                LOCATION_FOR_HISTORY,
+                number_of_rssi_signals_under_tracked,
+                area_work->buffers,
+                area_work->number_chunks);
+
+            _area_work_queue_finish(work_queue);
         }
-                            
-        sum_rssi += rssi_array[k];
-        valid_rssi_count++; 
     }
-    if(valid_rssi_count == 0 )
-        return ret_avg_rssi;
+}
 
-    ret_avg_rssi = sum_rssi / valid_rssi_count;
-    return ret_avg_rssi;
+/*
+Orders urgent rows by row index, so the rows of one summary chunk are 
+summarized together
+*/
+
+static int _compare_urgent_rows(const void * a, const void * b){
+
+    return ((const UrgentRow *)a)->row_index - 
+           ((const UrgentRow *)b)->row_index;
 }
 
-void hashtable_summarize_location_information(
+void hashtable_upload_urgent_location(
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
     HashTable * h_table,
+    int area_id,
     const int rssi_threashold_for_summarize_location_pin,
     const int number_of_rssi_signals_under_tracked,
     const int unreasonable_rssi_change,
     const int rssi_weight_multiplier,
     const int rssi_difference_of_location_accuracy_tolerance,
-    const int drift_distance) {
+    const int drift_distance){
 
-    int size = h_table->size;
-    int table_count = h_table->count;
-    int count = 0;
-    HNode ** table = h_table->table;
-    int i = 0;
-    int j = 0;
-    int k = 0;
-    int prev_index = 0;
-    int m = 0;
-    int avg_rssi;
-    float weight_x;
-    float weight_y;
-    int weight_count;
-    int weight_count_for_specific_uuid;
-    float summary_coordinateX_this_turn;
-    float summary_coordinateY_this_turn;
-    hash_table_row* table_row;  
-    pthread_mutex_t * ht_mutex = h_table->ht_mutex; 
+    int i;
+    int j;
+    int chunk_index;
+    int number_urgent_rows;
+    int number_uploaded_rows = 0;
+    int buffer_length;
+    int latency;
+    int max_latency = 0;
+    int total_latency = 0;
+    bool is_urgent;
+    unsigned int current_time_in_ms;
+    UrgentRow * urgent_rows;
+    hash_table_row * table_row;
+    SummaryChunk * summary_chunk;
+    SummaryBatch * batch;
+    LocationBuffer buffer;
+    long row_epoch;
+    RssiWeightTable * weight_table = rssi_weight_table;
     int current_time = get_system_time();
 
-    int summary_index = -1;
-    int summary_avg_rssi = INITIAL_AVERAGE_RSSI;
-    char summary_uuid[LENGTH_OF_UUID];
-    char summary_final_timestamp[LENGTH_OF_EPOCH_TIME];
+    // take the whole list, so puts making other rows urgent are not held up
+    pthread_mutex_lock(&h_table->urgent_mutex);
 
-    int strongest_avg_rssi = INITIAL_AVERAGE_RSSI;
-    char strongest_uuid[LENGTH_OF_UUID];
-    char strongest_initial_timestamp[LENGTH_OF_EPOCH_TIME];
-    char strongest_final_timestamp[LENGTH_OF_EPOCH_TIME];
-    HNode * curr = NULL;
-    HNode * node_to_release = NULL;
-    HNode * prev_node = NULL;
+    urgent_rows = h_table->urgent_rows;
+    number_urgent_rows = h_table->number_urgent_rows;
 
-    
-    for (i = 0; i < size; i++) {
+    h_table->urgent_rows = NULL;
+    h_table->number_urgent_rows = 0;
+    h_table->max_urgent_rows = 0;
 
-        curr = table[i];
-        prev_node = NULL;
-      
-        while(curr != NULL){
+    pthread_mutex_unlock(&h_table->urgent_mutex);
 
-        if(curr != NULL){
+    if(number_urgent_rows == 0){
+        free(urgent_rows);
+        return;
+    }
 
-            count++;
-        
-            //reset the summary data
-            summary_index = -1;
-            summary_avg_rssi = INITIAL_AVERAGE_RSSI;
-            memset(summary_uuid, 0, sizeof(summary_uuid));
-            memset(summary_final_timestamp, 0, sizeof(summary_final_timestamp));
-            strongest_avg_rssi = INITIAL_AVERAGE_RSSI;
-            memset(strongest_uuid, 0, sizeof(strongest_uuid));
-            memset(strongest_initial_timestamp, 0, sizeof(strongest_initial_timestamp));
-            memset(strongest_final_timestamp, 0, sizeof(strongest_final_timestamp));
-          
-            table_row = curr -> value; 
+    if(weight_table != NULL && 
+       weight_table -> rssi_weight_multiplier != rssi_weight_multiplier)
+        weight_table = NULL;
+
+    batch = malloc(sizeof(SummaryBatch));
+    if(batch == NULL){
+
+        zlog_error(category_debug, "cannot allocate summary batch");
+
+        // the rows stay urgent until the next call
+        for(i = 0; i < number_urgent_rows; i++)
+            _hashtable_queue_urgent_row(h_table, &urgent_rows[i]);
+
+        free(urgent_rows);
+        return;
+    }
+
+    batch->number_objects = 0;
+    batch->max_number_weights = 0;
+
+    qsort(urgent_rows, number_urgent_rows, sizeof(UrgentRow), 
+          _compare_urgent_rows);
+
+    row_epoch = hashtable_enter_row_read(h_table);
+
+    for(i = 0; i < number_urgent_rows; i = j){
+
+        chunk_index = urgent_rows[i].row_index / ROWS_IN_ONE_SUMMARY_CHUNK;
+        summary_chunk = h_table->summary_chunks[chunk_index];
+
+        j = i;
+        while(j < number_urgent_rows && 
+              urgent_rows[j].row_index / ROWS_IN_ONE_SUMMARY_CHUNK == 
+              chunk_index)
+            j++;
+
+        // The timeout wheel of the chunk is used by one summary at a time.
+        // The rows of a chunk being summarized by a summary pass are left 
+        // for the next call rather than hold up this call.
+        if(pthread_mutex_trylock(&summary_chunk->summary_mutex) != 0){
 
+            for(; i < j; i++){
+                _hashtable_queue_urgent_row(h_table, &urgent_rows[i]);
+                urgent_rows[i].row_index = NO_FREE_ROW;
+            }
+
+            continue;
+        }
+
+        for(; i < j; i++){
+
+            table_row = hashtable_get_row(h_table, urgent_rows[i].row_index);
+
+            // the row may have been evicted and reused by another object 
+            // since it became urgent
             pthread_mutex_lock(&table_row->node_lock);
 
-            //release the old HNode from hashtable to have more space
-            if(table_row -> last_reported_timestamp < 
-               current_time - 
-               TOLERANT_NOT_SCANNING_TIME_IN_SEC ){
-               
-                // lock hashtable
-                pthread_mutex_lock(ht_mutex);
+            is_urgent = table_row->is_in_use && 
+                        table_row->is_urgent &&
+                        table_row->mac_address == urgent_rows[i].mac_address;
 
-                // re-link the HNode to remove HNode fro hashtable
-                if(prev_node == NULL){
-                    table[i] = curr -> next;
-                }else{
-                    prev_node -> next = curr -> next;
-                }
-                node_to_release = curr;
-                curr = curr -> next;
-                node_to_release -> next = NULL;
+            if(is_urgent)
+                table_row->is_urgent = false;
 
-                h_table -> count = h_table->count - 1;
-                
-                // unlock hashtable
-                pthread_mutex_unlock(ht_mutex);
+            pthread_mutex_unlock(&table_row->node_lock);
 
-                // destroy key part and release from mempool
-                h_table->deleteKey(node_to_release->key);
-                mp_free(&mac_address_mempool, 
-                        node_to_release->key);
-                
-                // destroy value part and release from mempool 
-                h_table->deleteValue(node_to_release->value);
-                mp_free(&hash_table_value_mempool, 
-                        node_to_release -> value);
-
-                // destroy HNode part and release from mempool
-                mp_free(&hash_table_node_mempool, 
-                        node_to_release);
-  
+            if(!is_urgent){
+                urgent_rows[i].row_index = NO_FREE_ROW;
                 continue;
             }
-           
-            //calculate the average rssi signal of current summary lbeacon uuid
-            for(m = 0; m < table_row -> number_uuid_size; m++){
-
-                if(table_row -> uuid_record_table_array[m].is_in_use &&
-                   strcmp(table_row -> uuid_record_table_array[m].uuid,
-                          table_row -> summary_uuid) == 0){
-
-                    // ensure current summary lbeacon uuid is still scanning this
-                    // object.
-                    if(table_row -> uuid_record_table_array[m].
-                       last_reported_timestamp < 
-                       current_time - number_of_rssi_signals_under_tracked){
-
-                        table_row -> uuid_record_table_array[m].
-                            is_in_use = false;
-                       
-                        break;
-                    }
 
-                    // calculate the average rssi
-                    avg_rssi = get_average_rssi(
-                        table_row->uuid_record_table_array[m].rssi_array,
-                        rssi_threashold_for_summarize_location_pin,
-                        number_of_rssi_signals_under_tracked,
-                        unreasonable_rssi_change);
-
-                    if(avg_rssi != 0){
-                        summary_index = m;
-                        summary_avg_rssi = avg_rssi;
-                        strcpy(summary_uuid, 
-                               table_row->uuid_record_table_array[m].uuid);
-                        strcpy(summary_final_timestamp,
-                               table_row->uuid_record_table_array[m].final_timestamp);  
-                    }
+            _summary_visit_row(h_table, 
+                               batch, 
+                               table_row, 
+                               current_time,
+                               weight_table,
+                               rssi_threashold_for_summarize_location_pin,
+                               number_of_rssi_signals_under_tracked,
+                               unreasonable_rssi_change,
+                               rssi_weight_multiplier,
+                               rssi_difference_of_location_accuracy_tolerance,
+                               drift_distance);
+        }
 
-                    break;
-                }
-            }
+        _summary_batch_apply(h_table,
+                             batch,
+                             current_time,
+                             rssi_difference_of_location_accuracy_tolerance,
+                             drift_distance);
 
-            // calculate average rssi of all lbeacons and choose the strongest 
-            // lbeacon uuid
-            weight_x = 0;
-            weight_y = 0;
-            weight_count = 0;
-           
-            for(j = 0 ; j < table_row -> number_uuid_size ; j++){
-                // ignore not used element 
-                if(!table_row->uuid_record_table_array[j].is_in_use) {
-                    continue;   
-                }
+        pthread_mutex_unlock(&summary_chunk->summary_mutex);
+    }
 
-                
-                // ignore and delete old lbeacon uuid which has not scanned
-                // this object for long time.
-                if(table_row -> uuid_record_table_array[j].
-                   last_reported_timestamp < 
-                   current_time - number_of_rssi_signals_under_tracked){
-
-                    table_row -> uuid_record_table_array[j].
-                        is_in_use = false;
-                    continue;
-                }
-                
-                // calculate the average rssi
-                weight_count_for_specific_uuid = 0;
+    free(batch);
 
-                // calculate the average rssi
-                avg_rssi = get_average_rssi(
-                    table_row->uuid_record_table_array[j].rssi_array,
-                    rssi_threashold_for_summarize_location_pin,
-                    number_of_rssi_signals_under_tracked,
-                    unreasonable_rssi_change);
+    memset(&buffer, 0, sizeof(LocationBuffer));
 
-                // ignore this lbeacon uuid if no signal data is used.
-                if(avg_rssi == 0){
-                    continue;
-                }
- 
-                if(j != summary_index && avg_rssi > strongest_avg_rssi){
+    // only the rows whose line is appended count as uploaded. The others
+    // are evicted or not located by the summary, or are left out when the 
+    // buffer cannot grow.
+    for(i = 0; i < number_urgent_rows; i++){
 
-                    strongest_avg_rssi = (int) avg_rssi;
+        if(urgent_rows[i].row_index == NO_FREE_ROW)
+            continue;
 
-                    strcpy(strongest_uuid, 
-                           table_row->uuid_record_table_array[j].uuid);
-                    strcpy(strongest_initial_timestamp,
-                           table_row->uuid_record_table_array[j].initial_timestamp);
-                    strcpy(strongest_final_timestamp,
-                           table_row->uuid_record_table_array[j].final_timestamp);          
-                }
+        buffer_length = buffer.length;
 
-                weight_count_for_specific_uuid = 
-                    get_rssi_weight(avg_rssi, rssi_weight_multiplier);
+        if(_location_buffer_append_row(
+               &buffer,
+               hashtable_get_row(h_table, urgent_rows[i].row_index),
+               area_id,
+               LATEST_LOCATION_INFO,
+               number_of_rssi_signals_under_tracked,
+               current_time) != WORK_SUCCESSFULLY){
 
-                weight_count += weight_count_for_specific_uuid;
+            for(; i < number_urgent_rows; i++)
+                urgent_rows[i].row_index = NO_FREE_ROW;
+            break;
+        }
 
-                weight_x += 
-                    table_row -> uuid_record_table_array[j].coordinateX * 
-                    weight_count_for_specific_uuid;
-                weight_y += table_row->uuid_record_table_array[j].coordinateY * 
-                    weight_count_for_specific_uuid;               
-            }
-            
-            // update the position of location pin
-            if(weight_count > 0){
-
-                summary_coordinateX_this_turn = weight_x/(float)weight_count;
-                summary_coordinateY_this_turn = weight_y/(float)weight_count;
-
-                // avoid moving location pins when the objects are not really moved.
-                if(abs(summary_coordinateX_this_turn - 
-                       table_row->summary_coordinateX) > drift_distance || 
-                   abs(summary_coordinateY_this_turn - 
-                       table_row->summary_coordinateY) > drift_distance){
-                    //coordinateX
-                    table_row->summary_coordinateX = 
-                        summary_coordinateX_this_turn;
-                    //coordinateY
-                    table_row->summary_coordinateY = 
-                        summary_coordinateY_this_turn;
-                }  
-
-                // update the closest lbeacon
-                if(summary_index == -1 || 
-                   (strongest_avg_rssi - summary_avg_rssi > 
-                    rssi_difference_of_location_accuracy_tolerance) ){
-
-                    table_row->average_rssi = strongest_avg_rssi;
-                    strcpy(table_row->summary_uuid,
-                           strongest_uuid);
-                   // MUST use final_timestamp but not initiali_timesatmp to have 
-                   // correct lasting time under this newly closest lbeacon uuid.
-                   strcpy(table_row->initial_timestamp,
-                          strongest_final_timestamp);  
-                   strcpy(table_row->final_timestamp,
-                           strongest_final_timestamp);
-               
-                }else{
-            
-                    table_row->average_rssi = summary_avg_rssi;
-                    strcpy(table_row->summary_uuid,
-                           summary_uuid);
-                    strcpy(table_row->final_timestamp,
-                            summary_final_timestamp); 
-                }
+        if(buffer.length == buffer_length){
+            urgent_rows[i].row_index = NO_FREE_ROW;
+            continue;
+        }
+
+        number_uploaded_rows++;
+    }
 
-                table_row->last_reported_timestamp = get_system_time();
-            }  
+    hashtable_exit_row_read(h_table, row_epoch);
 
-            pthread_mutex_unlock(&table_row->node_lock);
-            } // if
-        
-            curr -> value = table_row;
-            prev_node = curr;
-            curr = curr->next;
-        } // while
-     
-    } // for-loop
-    
+    if(buffer.length > 0){
+
+        hashtable_upload_location_buffers(db_connection_list_head,
+                                          server_installation_path,
+                                          LATEST_LOCATION_INFO,
+                                          number_of_rssi_signals_under_tracked,
+                                          &buffer,
+                                          1);
+    }
+
+    free(buffer.data);
+
+    // the latency from the tracking data to the upload of the objects
+    current_time_in_ms = get_clock_time_in_ms();
+
+    for(i = 0; i < number_urgent_rows; i++){
+
+        if(urgent_rows[i].row_index == NO_FREE_ROW)
+            continue;
+
+        latency = (int)(current_time_in_ms - urgent_rows[i].urgent_time);
+
+        total_latency += latency;
+        if(latency > max_latency)
+            max_latency = latency;
+    }
+
+    if(number_uploaded_rows > 0){
+
+        zlog_debug(category_debug, 
+                   "urgent location of area %d: %d objects, latency %d ms " \
+                   "on average and %d ms at most",
+                   area_id,
+                   number_uploaded_rows,
+                   total_latency / number_uploaded_rows,
+                   max_latency);
+    }
+
+    free(urgent_rows);
 }
 
-void hashtable_traverse_areas_to_upload_latest_location(
+void hashtable_traverse_areas_to_upload_urgent_location(
     DBConnectionListHead *db_connection_list_head,
     const char *server_installation_path,
-    AreaSet *area_set,
     const int rssi_threashold_for_summarize_location_pin,
     const int number_of_rssi_signals_under_tracked,
     const int unreasonable_rssi_change,
@@ -1030,103 +3351,242 @@ void hashtable_traverse_areas_to_upload_latest_location(
     const int rssi_difference_of_location_accuracy_tolerance,
     const int drift_distance){
 
-    int start_index = area_set -> start_area_index;
-    int number_areas = area_set -> number_areas;
-    
-    while(number_areas--){
+    int i;
+    AreaTable entry;
 
-        if(start_index >= area_table_max_size)
-            continue;
+    for(i = 0; _area_table_get_entry(i, &entry); i++){
 
-        if(area_table[start_index].area_id == 0)
+        if(!entry.area_hash_ptr->is_time_critical || 
+           entry.area_hash_ptr->number_urgent_rows == 0)
             continue;
 
-        zlog_debug(category_debug,"area table id %d",
-                   area_table[start_index].area_id);
-
-        hashtable_summarize_location_information(
-            area_table[start_index].area_hash_ptr, 
+        hashtable_upload_urgent_location(
+            db_connection_list_head,
+            server_installation_path,
+            entry.area_hash_ptr,
+            entry.area_id,
             rssi_threashold_for_summarize_location_pin,
             number_of_rssi_signals_under_tracked,
             unreasonable_rssi_change,
             rssi_weight_multiplier,
             rssi_difference_of_location_accuracy_tolerance,
             drift_distance);
+    }
+}
 
-        hashtable_upload_location_to_database(
-            area_table[start_index].area_hash_ptr,
-            area_table[start_index].area_id,
-            db_connection_list_head,
-            server_installation_path,
-            LATEST_LOCATION_INFO,
-            number_of_rssi_signals_under_tracked);  
+/*
+Makes room for the input number of bytes after the lines in the buffer
+*/
 
-        start_index++;
-    }
+static ErrorCode _location_buffer_reserve(LocationBuffer * buffer, 
+                                          int length){
+
+    int size;
+    char * data;
+
+    if(buffer->size - buffer->length >= length)
+        return WORK_SUCCESSFULLY;
+
+    size = buffer->size * 2;
+    if(size == 0)
+        size = INITIAL_LOCATION_BUFFER_SIZE;
+
+    while(size - buffer->length < length)
+        size = size * 2;
+
+    data = realloc(buffer->data, size);
+    if(data == NULL)
+        return E_MALLOC;
+
+    buffer->data = data;
+    buffer->size = size;
+
+    return WORK_SUCCESSFULLY;
 }
 
-void hashtable_traverse_areas_to_upload_history_data(
-    DBConnectionListHead *db_connection_list_head,
-    const char *server_installation_path,
-    AreaSet *area_set,
-    const int number_of_rssi_signals_under_tracked){
-    
-    int start_index = area_set -> start_area_index;
-    int number_areas = area_set -> number_areas;
+/*
+Formats the time in epoch seconds as GMT into the buffer. Chunks are 
+formatted by several threads at the same time, so the shared buffer of 
+gmtime is not used.
+*/
 
-    while(number_areas--){
+static void _format_gmt_time(time_t timestamp, char *buf, size_t buf_len){
 
-        if(start_index >= area_table_max_size)
-            continue;
+    struct tm ts;
 
-        if(area_table[start_index].area_id == 0) 
-            continue;
+#ifdef _WIN32
+    gmtime_s(&ts, &timestamp);
+#else
+    gmtime_r(&timestamp, &ts);
+#endif
 
-        zlog_debug(category_debug,
-                   "hashtable_traverse_all_areas_to_upload_history_data: " \
-                   "area table id %d",
-                   area_table[start_index].area_id);    
+    strftime(buf, buf_len, "%Y-%m-%d %H:%M:%S", &ts);
+}
 
-        hashtable_upload_location_to_database(
-            area_table[start_index].area_hash_ptr,
-            area_table[start_index].area_id,
-            db_connection_list_head,
-            server_installation_path,
-            LOCATION_FOR_HISTORY,
-            number_of_rssi_signals_under_tracked);      
+/*
+Appends the line of location information of the object in the row to the 
+buffer if the object has been located recently. The row is read without its
+node_lock by a reader registered in the row epoch.
+*/
+
+static ErrorCode _location_buffer_append_row(
+    LocationBuffer * buffer,
+    hash_table_row * table_row,
+    int area_id,
+    const LocationInfoType location_type,
+    const int number_of_rssi_signals_under_tracked,
+    int current_time){
+
+    char buf_initial_time[LENGTH_OF_TIME_FORMAT];
+    char buf_final_time[LENGTH_OF_TIME_FORMAT];
+    char buf_record_time[LENGTH_OF_TIME_FORMAT];
+    char buf_last_reported_time[LENGTH_OF_TIME_FORMAT];
+    hash_table_row row_summary;
+    char mac_address[LENGTH_OF_MAC_ADDRESS];
+
+    if(!table_row->is_in_use)
+        return WORK_SUCCESSFULLY;
+
+    // Only the summary fields placed before the records are copied, without
+    // node_lock, so the uploader never stalls the tracking data of the 
+    // object.
+    if(!hashtable_get_row_summary(table_row, &row_summary))
+        return WORK_SUCCESSFULLY;
 
-        start_index++;
+    row_summary.last_reported_timestamp = 
+        hashtable_get_located_timestamp(&row_summary, current_time);
+
+    if(current_time - row_summary.last_reported_timestamp >= 
+       number_of_rssi_signals_under_tracked || 
+       row_summary.average_rssi == 0)
+        return WORK_SUCCESSFULLY;
+
+    if(_location_buffer_reserve(buffer, MAX_LENGTH_OF_LOCATION_LINE) != 
+       WORK_SUCCESSFULLY){
+
+        zlog_error(category_debug, 
+                   "cannot expand location buffer of area %d",
+                   area_id);
+        return E_MALLOC;
     }
-}
+
+    format_mac_address(row_summary.mac_address, mac_address);
+
+    /*
+    zlog_debug(category_debug,"summary:%s %s %d %d %d %d %s\n",
+               lbeacon_registry_get_uuid(row_summary.summary_lbeacon_id),
+               row_summary.battery,
+               row_summary.initial_timestamp,
+               row_summary.final_timestamp,
+               row_summary.last_reported_timestamp, 
+               row_summary.average_rssi,
+               row_summary.panic_button);
+    */                  
+    //location history file
+    if(LOCATION_FOR_HISTORY == location_type){
+        
+        _format_gmt_time(get_system_time(), 
+                         buf_record_time, 
+                         sizeof(buf_record_time));
+                
+        buffer->length += 
+            sprintf(buffer->data + buffer->length,
+                    "%s,%s,%s,%s,%d,%d,%d\n",
+                    mac_address,
+                    lbeacon_registry_get_uuid(
+                        row_summary.summary_lbeacon_id),
+                    buf_record_time,
+                    row_summary.battery,
+                    row_summary.average_rssi,
+                    (int)row_summary.summary_coordinateX,
+                    (int)row_summary.summary_coordinateY);
+    }else{
+
+        _format_gmt_time(row_summary.initial_timestamp, 
+                         buf_initial_time, 
+                         sizeof(buf_initial_time));
     
-void hashtable_upload_location_to_database(
+        _format_gmt_time(row_summary.final_timestamp, 
+                         buf_final_time, 
+                         sizeof(buf_final_time));
+
+        _format_gmt_time(row_summary.last_reported_timestamp, 
+                         buf_last_reported_time, 
+                         sizeof(buf_last_reported_time));
+        
+        buffer->length += 
+            sprintf(buffer->data + buffer->length,
+                    "%s,%d,%s,%s,%s,%s,%d,%d,%s,%d\n",
+                    lbeacon_registry_get_uuid(
+                        row_summary.summary_lbeacon_id),
+                    row_summary.average_rssi,
+                    row_summary.battery,
+                    buf_initial_time,
+                    buf_final_time,
+                    buf_last_reported_time,
+                    (int)row_summary.summary_coordinateX,
+                    (int)row_summary.summary_coordinateY,
+                    mac_address,
+                    area_id);
+    }
+
+    return WORK_SUCCESSFULLY;
+}
+
+ErrorCode hashtable_format_location_chunk(
     HashTable * h_table,
     int area_id,
+    int chunk_index,
+    const LocationInfoType location_type,
+    const int number_of_rssi_signals_under_tracked,
+    LocationBuffer * buffer) {
+
+    int i = 0;
+    int end_row;
+    long row_epoch;
+    ErrorCode ret_val = WORK_SUCCESSFULLY;
+
+    int current_time = get_system_time();
+
+    end_row = (chunk_index + 1) * ROWS_IN_ONE_SUMMARY_CHUNK;
+    if(end_row > h_table->row_count)
+        end_row = h_table->row_count;
+    
+    row_epoch = hashtable_enter_row_read(h_table);
+
+    for (i = chunk_index * ROWS_IN_ONE_SUMMARY_CHUNK; i < end_row; i++) {
+
+        ret_val = _location_buffer_append_row(
+            buffer,
+            hashtable_get_row(h_table, i),
+            area_id,
+            location_type,
+            number_of_rssi_signals_under_tracked,
+            current_time);
+
+        if(ret_val != WORK_SUCCESSFULLY)
+            break;
+    }
+
+    hashtable_exit_row_read(h_table, row_epoch);
+
+    return ret_val;
+}
+
+void hashtable_upload_location_buffers(
     DBConnectionListHead *db_connection_list_head,
     const char *server_installation_path,
     const LocationInfoType location_type,
-    const int number_of_rssi_signals_under_tracked) {
+    const int number_of_rssi_signals_under_tracked,
+    LocationBuffer * buffers,
+    int number_buffers) {
 
-    int record_size = h_table->size;
-    HNode ** table = h_table->table;
     int i = 0;
 
     char filename[MAX_PATH];
     FILE *file = NULL;
     char location_filename[MAX_PATH];
     FILE *location_file = NULL;
-    
-    time_t rawtime;
-    struct tm ts;
-    char buf_initial_time[LENGTH_OF_TIME_FORMAT];
-    char buf_final_time[LENGTH_OF_TIME_FORMAT];
-    char buf_record_time[LENGTH_OF_TIME_FORMAT];
-    char buf_last_reported_time[LENGTH_OF_TIME_FORMAT];
-    int clock_time_now;          
-    hash_table_row* table_row;   
-
-    int current_time = get_system_time();
-    
 
     if(LOCATION_FOR_HISTORY == location_type){
 
@@ -1144,6 +3604,13 @@ void hashtable_upload_location_to_database(
             return ;
         }
 
+        for(i = 0; i < number_buffers; i++){
+            fwrite(buffers[i].data, 1, buffers[i].length, location_file);
+        }
+
+        fclose(location_file);      
+        SQL_upload_location_history(db_connection_list_head,
+                                    location_filename);
     }else{
         sprintf(filename, "%s%s_%d", 
                 server_installation_path, 
@@ -1158,91 +3625,48 @@ void hashtable_upload_location_to_database(
                        filename);
             return ;
         }
-    }
-    
-    for (i = 0; i < record_size; i++) {
-
-        HNode * curr = table[i];
-
-        while (curr != 0) {    
-
-            table_row = curr->value;  
-
-
-            if(current_time - table_row->last_reported_timestamp < 
-               number_of_rssi_signals_under_tracked && 
-               table_row->average_rssi != 0){  
-            /*
-                zlog_debug(category_debug,"summary:%s %s %s %s %d %d %s\n",
-                           table_row->summary_uuid,
-                           table_row->battery,
-                           table_row->initial_timestamp,
-                           table_row->final_timestamp,
-                           table_row->last_reported_timestamp, 
-                           table_row->average_rssi,
-                           table_row->panic_button);
-              */                  
-                //location history file
-                if(LOCATION_FOR_HISTORY == location_type){
-                    
-                    rawtime = get_system_time();
-                    ts = *gmtime(&rawtime);
-                    strftime(buf_record_time, sizeof(buf_record_time), 
-                            "%Y-%m-%d %H:%M:%S", &ts);
-                            
-                    fprintf(location_file, "%s,%s,%s,%s,%d,%d,%d\n",
-                            curr->key,
-                            table_row->summary_uuid,
-                            buf_record_time,
-                            table_row->battery,
-                            table_row->average_rssi,
-                            (int)table_row->summary_coordinateX,
-                            (int)table_row->summary_coordinateY);
-                }else{
 
-                    rawtime = atoi(table_row->initial_timestamp);
-                    ts = *gmtime(&rawtime);
-                    strftime(buf_initial_time, sizeof(buf_initial_time), 
-                             "%Y-%m-%d %H:%M:%S", &ts);
-                
-                    rawtime = atoi(table_row->final_timestamp);
-                    ts = *gmtime(&rawtime);
-                    strftime(buf_final_time, sizeof(buf_final_time), 
-                             "%Y-%m-%d %H:%M:%S", &ts);
-
-                    rawtime = table_row ->last_reported_timestamp;
-                    ts = *gmtime(&rawtime);
-                    strftime(buf_last_reported_time, sizeof(buf_last_reported_time), 
-                             "%Y-%m-%d %H:%M:%S", &ts);
-                    
-                    fprintf(file, "%s,%d,%s,%s,%s,%s,%d,%d,%s,%d\n",
-                            table_row->summary_uuid,
-                            table_row->average_rssi,
-                            table_row->battery,
-                            buf_initial_time,
-                            buf_final_time,
-                            buf_last_reported_time,
-                            (int)table_row->summary_coordinateX,
-                            (int)table_row->summary_coordinateY,
-                            curr->key,
-                            area_id);
-                }
-                
-            }               
-            
-            curr = curr->next;
+        for(i = 0; i < number_buffers; i++){
+            fwrite(buffers[i].data, 1, buffers[i].length, file);
         }
-    
-    }   
-                                   
-    if(LOCATION_FOR_HISTORY == location_type){
-        fclose(location_file);      
-        SQL_upload_location_history(db_connection_list_head,
-                                    location_filename);
-    }else{
+
         fclose(file);   
         SQL_upload_hashtable_summarize(db_connection_list_head,
                                        filename,
                                        number_of_rssi_signals_under_tracked);
     }   
 }
+    
+void hashtable_upload_location_to_database(
+    HashTable * h_table,
+    int area_id,
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
+    const LocationInfoType location_type,
+    const int number_of_rssi_signals_under_tracked) {
+
+    int number_chunks = hashtable_get_number_summary_chunks(h_table);
+    int chunk_index;
+    LocationBuffer buffer;
+
+    memset(&buffer, 0, sizeof(LocationBuffer));
+
+    for(chunk_index = 0; chunk_index < number_chunks; chunk_index++){
+
+        hashtable_format_location_chunk(h_table,
+                                        area_id,
+                                        chunk_index,
+                                        location_type,
+                                        number_of_rssi_signals_under_tracked,
+                                        &buffer);
+    }
+
+    hashtable_upload_location_buffers(db_connection_list_head,
+                                      server_installation_path,
+                                      location_type,
+                                      number_of_rssi_signals_under_tracked,
+                                      &buffer,
+                                      1);
+
+    free(buffer.data);
+}
@@ -48,6 +48,7 @@
 #include <stdint.h>
 #include <pthread.h>
 #include <string.h>
+#include <stddef.h>
 
 #include "Tabletype.h"
 #include "BeDIS.h"
@@ -60,35 +61,134 @@
 /* The prefix of file path of the dumped location history information */
 #define FILE_PREFIX_DUMP_LOCATION_HISTORY_INFORMATION "./temp/locationtrack"
 
-/* The number of slots in the memory pool for the node of all the 
-hashtables. Value of this constant must be bigger than the total number 
-of objects to be tracked in the system. */
-#define SLOTS_IN_MEM_POOL_HASH_TABLE_NODE 65536
+/* The size in bytes of each chunk of the memory arena owned by the hashtable
+of one covered area. */
+#define SIZE_OF_AREA_ARENA_CHUNK 65536
 
-/* The number of slots in the memory pool for the key part of all the 
-hashtables. Value of this constant must be bigger than the total number 
-of objects to be tracked in the system. */
-#define SLOTS_IN_MEM_POOL_MAC_ADDRESS 65536
-
-/* The number of slots in the memory pool for the value part of all the 
-hashtables. Value of this constant must be bigger than the total number 
-of objects to be tracked in the system. */
-#define SLOTS_IN_MEM_POOL_HASH_TABLE_VALUE 65536
-
-/* The number of entries in each hashtable. */
+/* The initial number of slots in each hashtable. It must be a power of 2. */
 #define NUMBER_ENTRIES_IN_ONE_HASH_TABLE 256
 
+/* The number of shards of each hashtable and its base 2 logarithm. Each 
+shard owns the slots of the keys whose hash falls in its range and has its 
+own lock, so operations on different shards of one covered area run in 
+parallel. */
+#define NUMBER_OF_HASH_TABLE_SHARDS 16
+#define NUMBER_OF_HASH_TABLE_SHARD_BITS 4
+
+/* The ratio of objects to slots above which the slot array of a hashtable is
+enlarged, and the factor by which it is enlarged. */
+#define HASH_TABLE_MAX_LOAD 0.8
+#define HASH_TABLE_RESIZE_FACTOR 2
+
+/* The number of slots of the old slot array moved to the enlarged slot array
+by each operation on a shard being resized. It bounds the work done under 
+shard_lock by one operation, however many objects the shard holds. */
+#define SLOTS_MIGRATED_IN_ONE_OPERATION 64
+
+/* The row index marking a slot of the old slot array whose key has been 
+migrated or removed. The slot keeps its distance so that the probe sequences
+passing through it stay intact until the old slot array is released. */
+#define RETIRED_SLOT -1
+
+/* The number of rows in each chunk of the row storage of a hashtable. Rows 
+are allocated one chunk at a time from the memory arena of the area and 
+never move, so a row can be used after the hashtable lock is released. */
+#define ROWS_IN_ONE_ROW_CHUNK 64
+
+/* The maximum number of row chunks of a hashtable. The product of this 
+constant and ROWS_IN_ONE_ROW_CHUNK is the maximum number of objects to be 
+tracked in one covered area. */
+#define MAX_ROW_CHUNKS_IN_ONE_HASH_TABLE 4096
+
+/* The number of overflow blocks of records of lbeacons in the first 
+expansion of the overflow memory pool of a hashtable. The pool is taken from
+the memory arena of the area, so later expansions double in size and the 
+blocks grow with the rows, up to one block for every row. */
+#define SLOTS_IN_OVERFLOW_MEM_POOL 8
+
+/* The index marking the end of the list of free rows */
+#define NO_FREE_ROW -1
+
+/* The number of rows sharing one word of the dirty set of a hashtable */
+#define ROWS_IN_ONE_DIRTY_WORD 32
+
+/* The number of rows in each summary chunk of a hashtable. The rows of one 
+chunk are summarized and formatted for upload by one thread, and the chunks
+of a large covered area are shared by the threads of the work queue. It must
+be a multiple of ROWS_IN_ONE_ROW_CHUNK and ROWS_IN_ONE_DIRTY_WORD. */
+#define ROWS_IN_ONE_SUMMARY_CHUNK 8192
+
+/* The maximum number of summary chunks of a hashtable */
+#define MAX_SUMMARY_CHUNKS_IN_ONE_HASH_TABLE \
+    (MAX_ROW_CHUNKS_IN_ONE_HASH_TABLE * ROWS_IN_ONE_ROW_CHUNK / \
+     ROWS_IN_ONE_SUMMARY_CHUNK)
+
+/* The number of one-second slots of the timeout wheel of a summary chunk. 
+Rows due within the number of slots are scheduled in the wheel, and rows due
+later in the coarse wheel. */
+#define NUMBER_OF_TIMEOUT_WHEEL_SLOTS 512
+
+/* The number of slots of the coarse timeout wheel of a summary chunk, each
+of which holds the rows due in NUMBER_OF_TIMEOUT_WHEEL_SLOTS seconds. Rows 
+in a slot are moved to the timeout wheel when the slot comes. Rows are never
+scheduled further ahead than the span of the coarse wheel minus one second,
+and rows due later are scheduled again when they come out of the wheel. */
+#define NUMBER_OF_COARSE_TIMEOUT_WHEEL_SLOTS 64
+
+/* The number of seconds covered by the coarse timeout wheel */
+#define COARSE_TIMEOUT_WHEEL_SPAN_IN_SEC \
+    (NUMBER_OF_TIMEOUT_WHEEL_SLOTS * NUMBER_OF_COARSE_TIMEOUT_WHEEL_SLOTS)
+
+/* The initial number of entries of a slot of the timeout wheel. A full slot
+doubles its size. */
+#define INITIAL_TIMEOUT_WHEEL_SLOT_SIZE 64
+
 /* The length of time in seconds to allow a node not to be scanned and 
-updated. */
+updated, unless another length is set for the covered area in server.conf */
 #define TOLERANT_NOT_SCANNING_TIME_IN_SEC 300
 
 /* The default average rssi vlaue for the newly created node in hashtable */
 #define INITIAL_AVERAGE_RSSI -100
 
+/* The number of entries of the table of rssi weights, one for each average
+rssi value. Average rssi values are averages of one-byte rssi signals, so 
+they are within the range of int8_t. */
+#define NUMBER_OF_RSSI_WEIGHTS 256
+
+/* The number of objects whose location pins are computed together by the 
+summary kernel. It must be a multiple of 8, the largest number of lanes of
+the kernels. */
+#define SUMMARY_BATCH_SIZE 64
+
+/* The time in milliseconds between two checks of an area work queue by a
+thread which has found no area to work on */
+#define AREA_WORK_QUEUE_POLLING_TIME_IN_MS 20
+
+/* The time in milliseconds between two checks for urgent rows in the time 
+critical areas, and the initial number of entries of the list of urgent rows
+of a hashtable. A full list doubles its size. */
+#define URGENT_SUMMARY_POLLING_TIME_IN_MS 10
+#define INITIAL_URGENT_ROWS_SIZE 64
+
+/* The initial size in bytes of a buffer of formatted location information, 
+and the maximum length of the line of one object. A full buffer doubles its
+size. */
+#define INITIAL_LOCATION_BUFFER_SIZE 16384
+#define MAX_LENGTH_OF_LOCATION_LINE 256
+
 /* The default number of hashtables to be created to support covered areas 
 in the system. */
 #define INITIAL_AREA_TABLE_MAX_SIZE 32
 
+/* The number of possible area ids. Area ids are encoded in the first 
+LENGTH_OF_AREA_ID_IN_UUID decimal digits of lbeacon uuids, so the hashtable 
+of an area can be found by indexing an array with its area id. */
+#define MAX_NUMBER_OF_AREA_ID 10000
+
+/* The time in milliseconds to wait between checks of whether the readers of 
+a replaced area_table array have finished */
+#define AREA_TABLE_GRACE_PERIOD_POLLING_TIME_IN_MS 1
+
 /* Type of location information. */
 typedef enum _LocationInfoType {
 
@@ -97,11 +197,9 @@ typedef enum _LocationInfoType {
 
 } LocationInfoType;
 
-/* Generic helper function declarations used in member of HNode structure */
+/* Generic helper function declarations used by the hashtable */
 
-typedef uint32_t (* HashFunc)(const void *, size_t);
-
-typedef int (* EqualityFunc)(void *, void *);
+typedef uint32_t (* HashFunc)(uint64_t);
 
 /*
 typedef void (* IteratorCallback)(void *, size_t, void *, size_t);
@@ -109,36 +207,200 @@ typedef void (* IteratorCallback)(void *, size_t, void *, size_t);
 
 typedef void (* DeleteData)(void *);
 
-/* Structure for each node in hashtable */
-typedef struct HNode_{
-    void * key;
-    size_t key_len;
-    void * value;
-    size_t value_len;
-    DeleteData deleteKey;
-    DeleteData deleteValue;
-    struct HNode_ * next;
-} HNode;
+/* Structure for each slot in the open-addressing slot array of hashtable. 
+Slots are placed with Robin Hood hashing, so probe sequences stay short and 
+a lookup can stop as soon as it meets a slot closer to its home position 
+than the key being searched. */
+typedef struct {
 
-/* Structure for hashtable */ 
-typedef struct HashTable {
+    /* The MAC address of the object in binary form */
+    uint64_t key;
+
+    /* The index of the row of the object in the row storage */
+    int row_index;
 
-    HNode ** table;
+    /* The distance from the home position of the key plus one. Zero marks 
+    an empty slot. */
+    int distance;
+
+} HashSlot;
+
+/* Structure for each shard of hashtable */
+typedef struct {
+
+    /* The slot array. The number of slots is always a power of 2. */
+    HashSlot * slots;
     int size;
+
+    /* The slot array before the last resize, or NULL when no migration is in
+    flight. Its keys are moved into slots a few at a time, so lookups consult
+    slots first and then old_slots. */
+    HashSlot * old_slots;
+    int old_size;
+
+    /* The index of the next slot of old_slots to be migrated */
+    int migrate_index;
+
+    /* The number of keys in this shard */
     int count;
+
+    /* The lock protecting the slots of this shard. Looking up an existing 
+    key takes it in shared mode. Inserting and removing keys, which also move
+    slots of an in-flight resize, take it in exclusive mode. */
+    pthread_rwlock_t shard_lock;
+
+} HashShard;
+
+/* Structure of an entry of the timeout wheel */
+typedef struct {
+
+    int row_index;
+
+    /* The time of the entry. The entry is stale unless it is still the entry
+    of the row, i.e., the wheel_timestamp of the row. */
+    int wheel_timestamp;
+
+} TimeoutEntry;
+
+/* Structure of one slot of the timeout wheel, holding the rows scheduled for
+the seconds equal to the index of the slot modulo the number of slots */
+typedef struct {
+
+    TimeoutEntry * entries;
+    int number_entries;
+    int max_entries;
+
+} TimeoutWheelSlot;
+
+/* Structure of the summary state of the rows of one summary chunk */
+typedef struct {
+
+    /* The lock taken by the summary pass of the chunk. Summary threads may 
+    share areas, and a pass finding the chunk being summarized leaves it to 
+    the other thread. */
+    pthread_mutex_t summary_mutex;
+
+    /* The wheels of the rows to be summarized at a later time without new 
+    tracking data, i.e., when a record of lbeacon becomes stale or the row is
+    to be evicted, and the last second whose slot has been processed. The 
+    rows due within NUMBER_OF_TIMEOUT_WHEEL_SLOTS seconds are in the timeout
+    wheel, and the others in the coarse wheel. They are used by the summary 
+    pass of the chunk only. */
+    TimeoutWheelSlot timeout_wheel[NUMBER_OF_TIMEOUT_WHEEL_SLOTS];
+    TimeoutWheelSlot coarse_timeout_wheel[NUMBER_OF_COARSE_TIMEOUT_WHEEL_SLOTS];
+    int timeout_wheel_timestamp;
+
+} SummaryChunk;
+
+/* Structure of an entry of the list of urgent rows of a hashtable, i.e., the
+rows of a time critical area whose closest lbeacon may have changed since 
+they were last summarized */
+typedef struct {
+
+    int row_index;
+
+    /* The key of the object in the row when the row became urgent. The row 
+    may have been reused by another object by the time it is summarized. */
+    uint64_t mac_address;
+
+    /* The time in milliseconds at which the tracking data making the row 
+    urgent were put */
+    unsigned int urgent_time;
+
+} UrgentRow;
+
+/* Structure for hashtable */ 
+typedef struct HashTable {
+
+    HashShard shards[NUMBER_OF_HASH_TABLE_SHARDS];
+
     double max_load;
     double resize_factor;
-    EqualityFunc equal;
     HashFunc hash;
-    DeleteData deleteKey;
     DeleteData deleteValue;
 
-    /* The lock to protect all information within this specific covered 
-    area_id */
-    pthread_mutex_t * ht_mutex;
+    /* The lock protecting the allocation and release of rows, i.e., 
+    row_count, the row chunks and the list of free rows */
+    pthread_mutex_t * row_mutex;
+
+    /* The dense storage of rows. Rows are kept in fixed-size chunks so that
+    full-table scans walk memory sequentially. A row and its node_lock stay
+    valid for the life of the hashtable, so scans can lock the node_lock of
+    any row below row_count and then check whether the row is in use. */
+    hash_table_row ** row_chunks;
+
+    /* The number of rows handed out from the row storage so far. Scans visit
+    rows from 0 to row_count - 1 and skip the rows not in use. */
+    int row_count;
+
+    /* The head of the list of rows released by evicted objects */
+    int free_row_index;
+
+    /* The epoch of the rows and the number of readers in each epoch. Readers
+    which use rows without their node_lock register in the counter of the 
+    current epoch. */
+    volatile long row_epoch;
+    volatile long row_readers[2];
+
+    /* The heads of the lists of rows evicted in the current and the previous
+    epoch. A row is moved to the list of free rows, and its overflow block
+    returned to the memory pool, only after every reader registered before 
+    the row was evicted has finished. */
+    int retired_row_index[2];
+
+    /* The dirty set of rows, one bit for each row which has received 
+    tracking data since it was last summarized. Updates set the bits, and 
+    the summary pass takes them a word at a time and visits the dirty rows in
+    the order of the row storage. */
+    volatile long dirty_rows[MAX_ROW_CHUNKS_IN_ONE_HASH_TABLE * 
+                             ROWS_IN_ONE_ROW_CHUNK / ROWS_IN_ONE_DIRTY_WORD];
+
+    /* The summary state of each chunk of ROWS_IN_ONE_SUMMARY_CHUNK rows. A
+    chunk is allocated with its first row, before the row is counted in 
+    row_count. */
+    SummaryChunk * summary_chunks[MAX_SUMMARY_CHUNKS_IN_ONE_HASH_TABLE];
+
+    /* The length of time in seconds after which an object not located is 
+    evicted from the hashtable */
+    int tolerant_not_scanning_time_in_sec;
+
+    /* A flag indicating whether the covered area is time critical. Rows of a
+    time critical area are summarized and uploaded as soon as new tracking 
+    data may change their closest lbeacon, without waiting for the next 
+    summary pass. */
+    bool is_time_critical;
+
+    /* The lock protecting the list of urgent rows, and the list. A row is in
+    the list at most once, while the is_urgent flag of the row is set. */
+    pthread_mutex_t urgent_mutex;
+    UrgentRow * urgent_rows;
+    int number_urgent_rows;
+    int max_urgent_rows;
+
+    /* The memory pool of the overflow blocks of records of lbeacons, taken 
+    from the memory arena of this covered area */
+    Memory_Pool overflow_mempool;
+
+    /* The memory arena owning the row storage of this specific covered area.
+    The memory is released in one call when the hashtable is destroyed. */
+    Memory_Arena arena;
 
 } HashTable;
 
+/* Structure of the settings of one covered area given in server.conf. The 
+settings are copied to the hashtable of the area when the hashtable is 
+created. */
+typedef struct {
+
+    /* A flag indicating whether the area is time critical */
+    bool is_time_critical;
+
+    /* The length of time in seconds after which an object not located is 
+    evicted, or 0 for TOLERANT_NOT_SCANNING_TIME_IN_SEC */
+    int tolerant_not_scanning_time_in_sec;
+
+} AreaSettings;
+
 /* Structure to store hashtable for each covered area separately */
 typedef struct AreaTable{   
 
@@ -147,28 +409,195 @@ typedef struct AreaTable{
 
 } AreaTable;
 
-/* Global variables */
+/* Structure of a growable buffer of location information formatted for 
+upload, one line for each object */
+typedef struct {
+
+    char * data;
+    int length;
+    int size;
+
+} LocationBuffer;
+
+/* Structure of the work on one covered area in the current pass of an area 
+work queue. The area is split into its summary chunks, and the lines of each
+chunk are formatted into the buffer of the chunk. The thread finishing the 
+last chunk uploads the buffers of all chunks in one batch. */
+typedef struct {
+
+    AreaTable entry;
+
+    /* The number of chunks of the area in the current pass, counted when 
+    its first chunk is taken, and the number of chunks done */
+    int number_chunks;
+    int number_finished_chunks;
+
+    /* The buffers of the chunks, kept from pass to pass */
+    LocationBuffer buffers[MAX_SUMMARY_CHUNKS_IN_ONE_HASH_TABLE];
+
+} AreaWork;
+
+/* Structure of a unit of work taken from an area work queue, i.e., one chunk
+of one area */
+typedef struct {
+
+    AreaWork * area_work;
+    int chunk_index;
 
-/* The memory pool for the each node structure of hashtable. */
-Memory_Pool hash_table_node_mempool;
+} AreaWorkItem;
 
-/* The memory pool for the key part of all the hashtables. */
-Memory_Pool mac_address_mempool;
+/* Structure of the queue distributing the covered areas among the threads 
+doing one kind of periodic work. A pass over all covered areas starts at most
+once every period, and every thread takes the next chunk of the pass which 
+nobody has taken, so the areas of a pass, and the chunks of a large area, are
+shared by however many threads are free. A pass starts only after every area
+of the previous pass is done. */
+typedef struct {
 
-/* The memory pool for the value part of all the hashtables. */
-Memory_Pool hash_table_value_mempool;
+    pthread_mutex_t lock;
 
-/* The pointer to the head of the array of hashtables for all covered areas */
-AreaTable* area_table;
+    /* The name of the work in log messages */
+    const char *name;
 
-/* The lock used to protect the array of hashtables for all covered areas */
+    int period_in_ms;
+
+    /* The time in milliseconds at which the current pass started */
+    unsigned int pass_start_time;
+
+    /* The number of areas in the current pass, i.e., the areas created 
+    before the pass started, the index of the next area and of its next 
+    chunk to be taken, and the number of areas done */
+    int number_areas;
+    int next_area_index;
+    int next_chunk_index;
+    int number_finished_areas;
+
+    /* The work on each area of the current pass, and the number of areas it
+    can hold. It is enlarged only when a pass starts. */
+    AreaWork * area_works;
+    int max_areas;
+
+    /* The time in milliseconds the last finished pass took from its start 
+    to the end of its last area */
+    int last_pass_duration_in_ms;
+
+} AreaWorkQueue;
+
+/* Structure of the weights of all average rssi values for one rssi weight 
+multiplier. The weight of an average rssi is at the index of the average 
+minus INT8_MIN. */
+typedef struct RssiWeightTable{
+
+    int rssi_weight_multiplier;
+    int weights[NUMBER_OF_RSSI_WEIGHTS];
+
+    /* The table this table has replaced. Replaced tables may still be read 
+    by summary passes started before the replacement, and they are small 
+    and rarely replaced, so they are kept until destroy_rssi_weight_table. */
+    struct RssiWeightTable * replaced;
+
+} RssiWeightTable;
+
+/* Structure of the state of one object gathered for the summary kernel, i.e.,
+the candidates for the closest lbeacon chosen while the records are read */
+typedef struct {
+
+    hash_table_row * table_row;
+
+    int number_weights;
+
+    int summary_index;
+    int summary_avg_rssi;
+    int summary_lbeacon_id;
+    int summary_final_timestamp;
+
+    int strongest_avg_rssi;
+    int strongest_lbeacon_id;
+    int strongest_final_timestamp;
+
+    /* The earliest time at which a record used by the location becomes 
+    stale */
+    int location_expiry_timestamp;
+
+    /* The earliest time at which any record in use becomes stale, when it 
+    is released by the summary of the row */
+    int record_expiry_timestamp;
+
+} SummaryObject;
+
+/* Structure of a batch of objects staged for the summary kernel. The weights
+and coordinates of lbeacons are stored in structure-of-arrays form: the j-th
+lbeacon of the o-th object is at [j][o], so the kernel computes the weighted
+sums of adjacent objects in the lanes of one vector. */
+typedef struct {
+
+    int number_objects;
+    int max_number_weights;
+
+    SummaryObject objects[SUMMARY_BATCH_SIZE];
+
+    int weights[MAX_NUMBER_OF_LBEACON_UNDER_TRACKING][SUMMARY_BATCH_SIZE];
+    float coordinateX[MAX_NUMBER_OF_LBEACON_UNDER_TRACKING]
+                     [SUMMARY_BATCH_SIZE];
+    float coordinateY[MAX_NUMBER_OF_LBEACON_UNDER_TRACKING]
+                     [SUMMARY_BATCH_SIZE];
+
+    /* The weighted sums computed by the kernel */
+    float weight_x[SUMMARY_BATCH_SIZE];
+    float weight_y[SUMMARY_BATCH_SIZE];
+    int weight_count[SUMMARY_BATCH_SIZE];
+
+    /* The locations estimated by the location estimator, and whether each
+    object is located at all */
+    float estimated_x[SUMMARY_BATCH_SIZE];
+    float estimated_y[SUMMARY_BATCH_SIZE];
+    bool is_located[SUMMARY_BATCH_SIZE];
+
+} SummaryBatch;
+
+/* Global variables */
+
+/* The array of hashtables of all covered areas indexed by area id. An entry 
+is set once when the hashtable of the area is created and never changes 
+afterwards, so it is read without lock. */
+HashTable ** area_directory;
+
+/* The pointer to the head of the array of hashtables for all covered areas 
+in the order of creation. The array is never modified in place once it is 
+published. A larger copy is published to add areas beyond its size, and the 
+old copy is released after its readers have finished. */
+AreaTable * volatile area_table;
+
+/* The lock serializing the creation of hashtables for covered areas */
 pthread_mutex_t area_table_lock;
 
-/* The maximum number of hashtables to be created in the system */
+/* The maximum number of hashtables in the current area_table array */
 int area_table_max_size;
 
-/* The first index of the area_table array which has not be used  */
-int next_index_area_table;
+/* The first index of the area_table array which has not be used. It is 
+increased only after the entry at the index is visible in area_table. */
+volatile int next_index_area_table;
+
+/* The current epoch and the number of readers in each epoch of area_table.
+Readers register in the counter of the current epoch. A writer flips the 
+epoch and waits for the counter of the previous epoch to drain, twice, 
+before it releases a replaced area_table array. */
+volatile long area_table_epoch;
+volatile long area_table_readers[2];
+
+/* The table of rssi weights of the current rssi weight multiplier. It is 
+replaced as a whole when the multiplier changes, so a summary pass reads the
+weights of one multiplier only. */
+RssiWeightTable * volatile rssi_weight_table;
+
+/* The settings of all covered areas indexed by area id, and the number of 
+time critical areas */
+AreaSettings * area_settings;
+int number_time_critical_areas;
+
+/* The rssi difference from the closest lbeacon of an object by which new 
+tracking data make the row of the object urgent */
+int time_critical_rssi_difference;
 
 /* Helper functions */
 
@@ -179,9 +608,7 @@ HashTable * hashtable_new(
     int init_size,
     double max_load,
     double resize_factor,
-    EqualityFunc equal,
     HashFunc hash,
-    DeleteData deleteKey,
     DeleteData deleteValue
 
 );
@@ -190,25 +617,220 @@ HashTable * hashtable_new(
 percentage, and resize factor. */
 HashTable * hashtable_new_default(
 
-    EqualityFunc equal,
-    DeleteData deleteKey,
     DeleteData deleteValue
 
 );
 
-int equal_string(void * a, void * b);
-
-void destroy_key_part(void *key);
+/* Destructor. Releases all the rows and the memory arena of the hashtable 
+in one call. */
+void hashtable_destroy(HashTable * h_table);
 
 void destroy_value_part(void *value);
 
+/* Returns the row at the input index of the row storage of hashtable */
+#define hashtable_get_row(h_table, index) \
+    (&(h_table)->row_chunks[(index) / ROWS_IN_ONE_ROW_CHUNK] \
+                           [(index) % ROWS_IN_ONE_ROW_CHUNK])
+
+/* Returns the number of summary chunks holding the rows handed out so far */
+#define hashtable_get_number_summary_chunks(h_table) \
+    (((h_table)->row_count + ROWS_IN_ONE_SUMMARY_CHUNK - 1) / \
+     ROWS_IN_ONE_SUMMARY_CHUNK)
+
+/* Marks the start and the end of an update of the fields placed before the
+   records of the row. The caller must hold node_lock of the row. */
+#define hashtable_begin_row_update(table_row) \
+    do { (table_row)->sequence++; memory_barrier(); } while(0)
+
+#define hashtable_end_row_update(table_row) \
+    do { memory_barrier(); (table_row)->sequence++; } while(0)
+
+/*
+  hashtable_get_row_summary:
+
+     This function copies the fields placed before the records of the input 
+     row, i.e., the key and the summarized location, without taking node_lock.
+     The copy is retried until no update of the row overlaps it, so all the 
+     copied fields come from the same update.
+
+  Parameters:
+
+     table_row - the row to be copied
+
+     row_summary - the row receiving the copy. Only the fields placed before 
+                   the records are written.
+
+  Return value:
+
+     bool - true if the row is in use in the copy, false otherwise
+ */
+bool hashtable_get_row_summary(hash_table_row * table_row,
+                               hash_table_row * row_summary);
+
+/*
+  hashtable_get_located_timestamp:
+
+     This function returns the last time at which the location of the row is
+     confirmed by tracking data. The summary pass skips the rows whose 
+     location cannot change until location_expiry_timestamp, and their 
+     locations are confirmed at every second before it.
+
+  Parameters:
+
+     table_row - the row or a copy of the row by hashtable_get_row_summary
+
+     current_time - the current time in epoch seconds
+
+  Return value:
+
+     int - the time in epoch seconds
+ */
+int hashtable_get_located_timestamp(const hash_table_row * table_row,
+                                    int current_time);
+
+/*
+  hashtable_enter_row_read:
+
+     This function registers the caller as a reader of the rows of the 
+     hashtable. Until the caller calls hashtable_exit_row_read, no row which 
+     the caller has seen in use is reused for another object, and its 
+     overflow block of records is not released, even if the object is 
+     evicted.
+
+  Parameters:
+
+     h_table - the pointer to specific hashtable of one covered area
+
+  Return value:
+
+     long - the epoch to be passed to hashtable_exit_row_read
+ */
+long hashtable_enter_row_read(HashTable * h_table);
+
+/*
+  hashtable_exit_row_read:
+
+     This function ends the read registered by hashtable_enter_row_read.
+
+  Parameters:
+
+     h_table - the pointer to specific hashtable of one covered area
+
+     epoch - the epoch returned by hashtable_enter_row_read
+
+  Return value:
+
+     None
+ */
+void hashtable_exit_row_read(HashTable * h_table, long epoch);
+
+/*
+  hashtable_find_row:
+
+     This function looks up the row of the input key in the slot array of the
+     shard of the key and, while a resize is in flight, in the old slot array.
+     The caller must hold shard_lock of the shard in shared or exclusive mode.
+
+  Parameters:
+
+     h_table - the pointer to specific hashtable of one covered area
+
+     key - the binary mac_address
+
+  Return value:
+
+     hash_table_row * - the row of the key, or NULL if the key is not found
+ */
+hash_table_row * hashtable_find_row(HashTable * h_table, uint64_t key);
+
+/*
+  hashtable_get_shard:
+
+     This function returns the shard holding the slot of the input key.
+
+  Parameters:
+
+     h_table - the pointer to specific hashtable of one covered area
+
+     key - the binary mac_address
+
+  Return value:
+
+     HashShard * - the shard of the key
+ */
+HashShard * hashtable_get_shard(HashTable * h_table, uint64_t key);
+
+/*
+  hashtable_remove_row:
+
+     This function removes the input key from the slot array and retires its
+     row. The row is reused only after the readers registered by 
+     hashtable_enter_row_read before this call have finished. The caller must
+     hold shard_lock of the shard of the key in exclusive mode and node_lock 
+     of the row. The node_lock is released by this function.
+
+  Parameters:
+
+     h_table - the pointer to specific hashtable of one covered area
+
+     key - the binary mac_address
+
+  Return value:
+
+     None
+ */
+void hashtable_remove_row(HashTable * h_table, uint64_t key);
+
+/*
+  parse_mac_address:
+
+     This function converts the text form of a MAC address, i.e., six pairs of
+     hexadecimal digits separated by colons, to the binary key used by the 
+     hashtable. The digits may be in either case, and the key holds the 48 
+     bits of the MAC address only, so the same MAC address in upper and 
+     lower case has the same key.
+
+  Parameters:
+
+     mac_address - the text form of the MAC address
+
+     key - the pointer to the binary key to be filled
+
+  Return value:
+
+     bool - true if the input is a well-formed MAC address
+ */
+bool parse_mac_address(const char *mac_address, uint64_t *key);
+
+/*
+  format_mac_address:
+
+     This function converts the binary key of a MAC address back to its text
+     form with lower case hexadecimal digits, as the macaddr type of the 
+     database prints it. It is used at ingest, to normalize the text of the
+     MAC address once, and at the database and log boundaries.
+
+  Parameters:
+
+     key - the binary key of the MAC address
+
+     mac_address - the buffer of at least LENGTH_OF_MAC_ADDRESS bytes to hold
+                   the text form
+
+  Return value:
+
+     None
+ */
+void format_mac_address(uint64_t key, char *mac_address);
+
 // Function for server
 
 /*
   initialize_area_table:
 
-     This function initializes the memory pools and all hashtables for all 
-     covered areas.
+     This function initializes the array of hashtables for all covered areas.
+     The hashtable of each covered area is created on demand with its own 
+     memory arena and memory pools.
 
   Parameters:
 
@@ -223,12 +845,138 @@ void destroy_value_part(void *value);
  */
 ErrorCode initialize_area_table();
 
+/*
+  destroy_area_table:
+
+     This function destroys the hashtables of all covered areas and releases
+     the memory arena of each area.
+
+  Parameters:
+
+      None
+
+  Return value:
+
+      None
+
+ */
+void destroy_area_table();
+
+/*
+  set_time_critical_areas:
+
+     This function marks the covered areas in the input list as time 
+     critical. The objects in a time critical area are summarized and 
+     uploaded by hashtable_traverse_areas_to_upload_urgent_location as soon 
+     as new tracking data may change their closest lbeacon, i.e., when an 
+     lbeacon other than the closest one becomes stronger than the closest one
+     by more than the input rssi difference, or the closest one becomes 
+     weaker by more than the difference. It is called after 
+     initialize_area_table.
+
+  Parameters:
+
+     area_id_list - the list of area ids separated by semicolons, e.g.,
+                    "1;5;", or an empty string for no time critical area
+
+     rssi_difference_of_location_accuracy_tolerance - 
+         the tolerance of rssi signal to avoid jumping lbecaons
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_INPUT_PARAMETER: the list has an invalid area id, which 
+                                    is ignored
+ */
+ErrorCode set_time_critical_areas(
+    const char *area_id_list,
+    const int rssi_difference_of_location_accuracy_tolerance);
+
+/*
+  set_area_tolerant_not_scanning_time:
+
+     This function sets the length of time after which objects not located 
+     are evicted from the hashtables of the covered areas in the input list.
+     The other areas use TOLERANT_NOT_SCANNING_TIME_IN_SEC. It is called 
+     after initialize_area_table.
+
+  Parameters:
+
+     area_time_list - the list of pairs of area id and time in seconds 
+                      separated by semicolons, e.g., "1:60;5:3600;", or an 
+                      empty string
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_INPUT_PARAMETER: the list has an invalid pair, which is 
+                                    ignored
+ */
+ErrorCode set_area_tolerant_not_scanning_time(const char *area_time_list);
+
+/*
+  initialize_area_work_queue:
+
+     This function initializes a queue distributing the covered areas among
+     the threads doing one kind of periodic work. The first pass starts when
+     a thread first asks for an area.
+
+  Parameters:
+
+     work_queue - the queue to be initialized
+
+     name - the name of the work in log messages
+
+     period_in_ms - the time in milliseconds from the start of a pass to the
+                    start of the next pass
+
+  Return value:
+
+     None
+ */
+void initialize_area_work_queue(AreaWorkQueue *work_queue, 
+                                const char *name,
+                                int period_in_ms);
+
+/*
+  destroy_area_work_queue:
+
+     This function releases the lock and the location buffers of the queue.
+     No thread may use the queue after this function is called.
+
+  Parameters:
+
+     work_queue - the queue to be destroyed
+
+  Return value:
+
+     None
+ */
+void destroy_area_work_queue(AreaWorkQueue *work_queue);
+
+/*
+  hashtable_report_mempool_statistics:
+
+     This function writes the memory usage, the number of objects and the 
+     number of slots of the hashtables of all covered areas to the debug log.
+
+  Parameters:
+
+      None
+
+  Return value:
+
+      None
+
+ */
+void hashtable_report_mempool_statistics();
+
 /*
   hash_table_of_specific_area_id:
 
-     This function searches the area_table to find out and return the 
-     corresponding hashtable for input area_id. It also creates new
-     hashtable for the input area_id, if the hashtable does not exist.
+     This function returns the corresponding hashtable for input area_id 
+     with one lookup in area_directory, which takes no lock. It also creates 
+     new hashtable for the input area_id, if the hashtable does not exist.
 
   Parameters:
 
@@ -236,9 +984,8 @@ ErrorCode initialize_area_table();
 
   Return value:
 
-
-      ErrorCode - Indicate the result of execution, the expected return code
-                  is WORK_SUCCESSFULLY.
+      HashTable * - the hashtable of the area, or NULL if the area_id is out 
+                    of range or the hashtable cannot be created
 
  */
 HashTable * hash_table_of_specific_area_id(int area_id);
@@ -271,6 +1018,13 @@ HashTable * hash_table_of_specific_area_id(int area_id);
          timestamp of objects are valid and should be treated as existing in 
          the covered area
 
+     rssi_threashold_for_summarize_location_pin -
+         the rssi threshold used to filter out tracking data from poor lbeacons
+
+     unreasonable_rssi_change - the abnormal rssi signal strength change in 
+                                adjacent seconds. The running statistics of 
+                                rssi signals are kept with this filter.
+
   Return value:
 
       ErrorCode - Indicate the result of execution, the expected return code
@@ -282,22 +1036,23 @@ ErrorCode hashtable_update_object_tracking_data(
     char* buf, 
     size_t buf_len, 
     const int number_of_lbeacons_under_tracked,
-    const int number_of_rssi_signals_under_tracked);
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change);
 
 /*
   hashtable_maintain_key_part:
 
      This function searches and maintains the input hashtable to find the input
-     mac_address. It returns the index of the input mac_address in the input 
-     hashtable.
+     mac_address. It creates a new row for the mac_address if it is not found.
+     The caller must hold shard_lock of the shard of the key in exclusive 
+     mode.
 
   Parameters:
 
      h_table - the pointer to specific hashtable of one covered area
 
-     key - the pointer to the input mac_address extracted from tracking data
-
-     key_len - the length of input key
+     key - the binary mac_address extracted from tracking data
 
      number_of_lbeacons_under_tracked - 
          the number of lbeacons to be kept in the arrary of recently scanned 
@@ -310,14 +1065,15 @@ ErrorCode hashtable_update_object_tracking_data(
 
   Return value:
 
-     index of the input mac_address key in the input hashtable 
+     hash_table_row * - the row of the input mac_address, or NULL if a new 
+                        row cannot be allocated
  */
 
-int hashtable_maintain_key_part(HashTable * h_table, 
-                                void * key, 
-                                size_t key_len, 
-                                const int number_of_lbeacons_under_tracked,
-                                const int number_of_rssi_signals_under_tracked);
+hash_table_row * hashtable_maintain_key_part(
+    HashTable * h_table, 
+    uint64_t key, 
+    const int number_of_lbeacons_under_tracked,
+    const int number_of_rssi_signals_under_tracked);
 
 /*
   hashtable_put_new_tracking_data:
@@ -333,9 +1089,7 @@ int hashtable_maintain_key_part(HashTable * h_table,
 
      h_table - the pointer to specific hashtable of one covered area
 
-     key - the pointer to the input mac_address extracted from tracking data
-
-     key_len - the length of input key
+     key - the binary mac_address extracted from tracking data
 
      value - the extracted scanned information of the pair of lbeacon uuid and 
              mac_address
@@ -349,6 +1103,13 @@ int hashtable_maintain_key_part(HashTable * h_table,
          timestamp of objects are valid and should be treated as existing in 
          the covered area
 
+     rssi_threashold_for_summarize_location_pin -
+         the rssi threshold used to filter out tracking data from poor lbeacons
+
+     unreasonable_rssi_change - the abnormal rssi signal strength change in 
+                                adjacent seconds. The running statistics of 
+                                rssi signals are kept with this filter.
+
   Return value:
 
      None
@@ -356,11 +1117,12 @@ int hashtable_maintain_key_part(HashTable * h_table,
 
 void hashtable_put_new_tracking_data(
     HashTable * h_table, 
-    const void * key, 
-    const size_t key_len, 
+    const uint64_t key, 
     DataForHashtable * value, 
     const int number_of_lbeacons_under_tracked,
-    const int number_of_rssi_signals_under_tracked);
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change);
 
 /*
   get_rssi_weight:
@@ -381,6 +1143,42 @@ void hashtable_put_new_tracking_data(
 int get_rssi_weight(float average_rssi,
                     const int rssi_weight_multiplier);
 
+/*
+  update_rssi_weight_table:
+
+     This function builds the table of rssi weights for the input multiplier
+     with get_rssi_weight and publishes it in place of the current table. It 
+     is called by the thread loading the server configuration whenever the 
+     multiplier is loaded.
+
+  Parameters:
+
+     rssi_weight_multiplier - the multiplier used to applied on different range 
+                              of rssi singal strength
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_MALLOC: cannot allocate memory for the table
+ */
+ErrorCode update_rssi_weight_table(const int rssi_weight_multiplier);
+
+/*
+  destroy_rssi_weight_table:
+
+     This function releases the current and all replaced tables of rssi 
+     weights. No summary pass may run after this function is called.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     None
+ */
+void destroy_rssi_weight_table();
+
 /*
   get_average_rssi:
 
@@ -406,21 +1204,65 @@ int get_rssi_weight(float average_rssi,
 
      The running average of rssi signals in the input rssi_array array
  */
-int get_average_rssi(const int *rssi_array,
+int get_average_rssi(const int8_t *rssi_array,
                      const int rssi_threashold_for_summarize_location_pin,
                      const int number_of_rssi_signals_under_tracked,
                      const int unreasonable_rssi_change);
 
 /*
-  hashtable_summarize_location_information:
+  get_record_average_rssi:
+
+     This function returns the average of rssi signals of the record of one
+     lbeacon from the running sum and count of valid rssi signals, which are
+     updated in hashtable_put_new_tracking_data as signals enter the array. 
+     The result is the same as get_average_rssi over the rssi_array of the 
+     record with the same settings. If the running values were kept with 
+     other settings, the average is computed from the rssi_array instead.
+
+  Parameters:
+
+     record - the record of one lbeacon scanning the object
+
+     number_of_rssi_signals_under_tracked - 
+         the number of rssi signals which are kept in hashtable to calculate
+         location of objects. This setting is configurable in server.conf
+
+     rssi_threashold_for_summarize_location_pin -
+         the rssi threshold used to filter out tracking data from poor lbeacons
+
+     unreasonable_rssi_change - the abnormal rssi signal strength change in 
+                                adjacent seconds. When this happens, the rssi
+                                singal will be ingored in the calculation.
+
+  Return value:
+
+     The running average of rssi signals in the record, or 0 if no signal is
+     valid
+ */
+int get_record_average_rssi(
+    const uuid_record_table_row *record,
+    const int number_of_rssi_signals_under_tracked,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int unreasonable_rssi_change);
+
+/*
+  hashtable_summarize_location_chunk:
 
      This function determines the lbeacon uuid closest to objects and 
-     calculates the estimated base_x and base_y of objects.
+     calculates the estimated base_x and base_y of objects in one summary 
+     chunk of the hashtable. Only the objects which have received tracking 
+     data since the last pass, and the objects due in the timeout wheel of 
+     the chunk, are summarized. The function returns at once if another 
+     thread is summarizing the same chunk. Different chunks of a hashtable 
+     can be summarized by different threads at the same time.
 
   Parameters:
 
      h_table - the pointer to specific hashtable of one covered area
 
+     chunk_index - the index of the summary chunk, less than 
+                   hashtable_get_number_summary_chunks(h_table)
+
      rssi_threashold_for_summarize_location_pin -
          the rssi threshold used to filter out tracking data from poor lbeacons
      number_of_rssi_signals_under_tracked - 
@@ -446,6 +1288,31 @@ int get_average_rssi(const int *rssi_array,
      None
  */
 
+void hashtable_summarize_location_chunk(
+    HashTable * h_table,
+    int chunk_index,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance);
+
+/*
+  hashtable_summarize_location_information:
+
+     This function summarizes all summary chunks of the hashtable one after 
+     another by hashtable_summarize_location_chunk.
+
+  Parameters:
+
+     The same as hashtable_summarize_location_chunk except chunk_index
+
+  Return value:
+
+     None
+ */
+
 void hashtable_summarize_location_information(
     HashTable * h_table,
     const int rssi_threashold_for_summarize_location_pin,
@@ -458,9 +1325,13 @@ void hashtable_summarize_location_information(
 /*
   hashtable_traverse_areas_to_upload_latest_location:
 
-     This function traverses hashtable of all covered areas to
-     upload current location information of objects to current summary 
-     location table in the database.
+     This function takes the chunks of areas of the current pass from the 
+     work queue one at a time, and summarizes and formats current location 
+     information of objects in each chunk. The thread finishing the last 
+     chunk of an area uploads the information of all chunks of the area to 
+     current summary location table in the database. It returns when no area of the pass is left to be taken, 
+     and the caller is expected to call it again after 
+     AREA_WORK_QUEUE_POLLING_TIME_IN_MS.
 
   Parameters:
 
@@ -468,8 +1339,8 @@ void hashtable_summarize_location_information(
 
      server_installation_path - the installation of server
 
-     area_set - the list of areas under with the location information of 
-                objects should be summarized and uploaded
+     work_queue - the queue of areas whose location information of objects
+                  should be summarized and uploaded
 
      rssi_threashold_for_summarize_location_pin -
          the rssi threshold used to filter out tracking data from poor lbeacons
@@ -500,7 +1371,7 @@ void hashtable_summarize_location_information(
 void hashtable_traverse_areas_to_upload_latest_location(
     DBConnectionListHead *db_connection_list_head,
     const char *server_installation_path,
-    AreaSet *area_set,
+    AreaWorkQueue *work_queue,
     const int rssi_threashold_for_summarize_location_pin,
     const int number_of_rssi_signals_under_tracked,
     const int unreasonable_rssi_change,
@@ -511,9 +1382,11 @@ void hashtable_traverse_areas_to_upload_latest_location(
 /*
   hashtable_traverse_areas_to_upload_history_data:
 
-     This function traverses hashtable of all covered areas to
-     upload current location information of objects to history table
-     in the database.
+     This function takes the chunks of areas of the current pass from the 
+     work queue one at a time, and formats current location information of 
+     objects in each chunk. The thread finishing the last chunk of an area 
+     uploads the information of all chunks of the area to history table in 
+     the database. It returns when no chunk of the pass is left to be taken.
 
   Parameters:
 
@@ -521,8 +1394,8 @@ void hashtable_traverse_areas_to_upload_latest_location(
 
      server_installation_path - the installation of server
 
-     area_set - the list of areas under with the location information of 
-                objects should be uploaded
+     work_queue - the queue of areas whose location information of objects
+                  should be uploaded
 
      number_of_rssi_signals_under_tracked -
          the time length in seconds used to determine whether the last reported
@@ -538,9 +1411,150 @@ void hashtable_traverse_areas_to_upload_latest_location(
 void hashtable_traverse_areas_to_upload_history_data(
     DBConnectionListHead *db_connection_list_head,
     const char *server_installation_path,
-    AreaSet *area_set,
+    AreaWorkQueue *work_queue,
     const int number_of_rssi_signals_under_tracked);
 
+/*
+  hashtable_upload_urgent_location:
+
+     This function takes the list of urgent rows of the hashtable of a time 
+     critical area, summarizes the objects in the rows, and uploads their 
+     location information to current summary location table in the database
+     in one batch. The other objects of the area are left to the summary 
+     pass. The rows of a summary chunk being summarized by a summary pass are
+     left in the list for the next call.
+
+  Parameters:
+
+     db_connection_list_head - the list head of database connection pool
+
+     server_installation_path - the installation of server
+
+     h_table - the pointer to specific hashtable of one covered area
+
+     area_id - area id of specific covered area
+
+     The other parameters are the same as hashtable_summarize_location_chunk
+
+  Return value:
+
+     None
+ */
+
+void hashtable_upload_urgent_location(
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
+    HashTable * h_table,
+    int area_id,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance);
+
+/*
+  hashtable_traverse_areas_to_upload_urgent_location:
+
+     This function calls hashtable_upload_urgent_location for every time 
+     critical area which has urgent rows. The caller is expected to call it 
+     again after URGENT_SUMMARY_POLLING_TIME_IN_MS.
+
+  Parameters:
+
+     The same as hashtable_upload_urgent_location except h_table and area_id
+
+  Return value:
+
+     None
+ */
+
+void hashtable_traverse_areas_to_upload_urgent_location(
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
+    const int rssi_threashold_for_summarize_location_pin,
+    const int number_of_rssi_signals_under_tracked,
+    const int unreasonable_rssi_change,
+    const int rssi_weight_multiplier,
+    const int rssi_difference_of_location_accuracy_tolerance,
+    const int drift_distance);
+
+/*
+  hashtable_format_location_chunk:
+
+     This function appends one line of location information for each object
+     located recently in one summary chunk of the hashtable to the buffer. 
+     The format of the lines is determined by the LocationInfoType.
+
+  Parameters:
+
+     h_table - the pointer to specific hashtable of one covered area
+
+     area_id - area id of specific covered area
+
+     chunk_index - the index of the summary chunk
+
+     location_type - the destination of database tables of the lines
+
+     number_of_rssi_signals_under_tracked - 
+         the time length in seconds used to determine whether the last reported
+         timestamp of objects are valid and should be treated as existing in 
+         the covered area
+
+     buffer - the buffer to which the lines are appended. The buffer is 
+              enlarged when it is full.
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_MALLOC: cannot enlarge the buffer, and the lines of the 
+                           objects left are dropped
+ */
+
+ErrorCode hashtable_format_location_chunk(
+    HashTable * h_table,
+    int area_id,
+    int chunk_index,
+    const LocationInfoType location_type,
+    const int number_of_rssi_signals_under_tracked,
+    LocationBuffer * buffer);
+
+/*
+  hashtable_upload_location_buffers:
+
+     This function writes the lines in the buffers to one file in the order
+     of the buffers, and uploads the file to the database table determined 
+     by the LocationInfoType in one batch.
+
+  Parameters:
+
+     db_connection_list_head - the list head of database connection pool
+
+     server_installation_path - the installation of server
+
+     location_type - the destination of database tables
+
+     number_of_rssi_signals_under_tracked - 
+         the time length in seconds used to determine whether the last reported
+         timestamp of objects are valid
+
+     buffers - the array of buffers filled by hashtable_format_location_chunk
+
+     number_buffers - the number of buffers in the array
+
+  Return value:
+
+     None
+ */
+
+void hashtable_upload_location_buffers(
+    DBConnectionListHead *db_connection_list_head,
+    const char *server_installation_path,
+    const LocationInfoType location_type,
+    const int number_of_rssi_signals_under_tracked,
+    LocationBuffer * buffers,
+    int number_buffers);
+
 /*
   hashtable_upload_location_to_database:
 
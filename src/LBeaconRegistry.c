@@ -0,0 +1,317 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and conditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     LBeaconRegistry.c
+
+  File Description:
+
+     This file provides the process-wide registry of lbeacons to BOT server.
+     The registry interns each lbeacon uuid to a small integer id, and keeps
+     the area id and coordinates parsed from the uuid, so that tracking data
+     store and compare ids instead of uuid strings.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     BeDIS uses LBeacons to deliver 3D coordinates and textual descriptions of
+     their locations to users' devices. Basically, a LBeacon is an inexpensive,
+     Bluetooth Smart Ready device. The 3D coordinates and location description
+     of every LBeacon are retrieved from BeDIS (Building/environment Data and
+     Information System) and stored locally during deployment and maintenance
+     times. Once initialized, each LBeacon broadcasts its coordinates and
+     location description to Bluetooth enabled user devices within its coverage
+     area.
+ */
+
+#include "LBeaconRegistry.h"
+
+
+static uint32_t _lbeacon_registry_hash_uuid(const char *uuid);
+
+static int _lbeacon_registry_find(const char *uuid);
+
+static void _lbeacon_registry_insert_index(int * index_slots,
+                                           int index_size,
+                                           const char *uuid,
+                                           int id);
+
+static int _lbeacon_registry_grow_index();
+
+
+/*
+FNV-1a over the characters of the uuid
+*/
+
+static uint32_t _lbeacon_registry_hash_uuid(const char *uuid){
+
+    uint32_t hash = 2166136261U;
+
+    while(*uuid != '\0'){
+        hash ^= (unsigned char)*uuid;
+        hash *= 16777619U;
+        uuid++;
+    }
+
+    return hash;
+}
+
+static int _lbeacon_registry_find(const char *uuid){
+
+    int mask = lbeacon_registry.index_size - 1;
+    int index = _lbeacon_registry_hash_uuid(uuid) & mask;
+    int id;
+
+    while(lbeacon_registry.index_slots[index] != 0){
+
+        id = lbeacon_registry.index_slots[index] - 1;
+
+        if(strcmp(lbeacon_registry_get_entry(id)->uuid, uuid) == 0)
+            return id;
+
+        index = (index + 1) & mask;
+    }
+
+    return LBEACON_ID_UNKNOWN;
+}
+
+static void _lbeacon_registry_insert_index(int * index_slots,
+                                           int index_size,
+                                           const char *uuid,
+                                           int id){
+
+    int mask = index_size - 1;
+    int index = _lbeacon_registry_hash_uuid(uuid) & mask;
+
+    while(index_slots[index] != 0)
+        index = (index + 1) & mask;
+
+    index_slots[index] = id + 1;
+}
+
+static int _lbeacon_registry_grow_index(){
+
+    int new_size = lbeacon_registry.index_size * 2;
+    int * new_slots;
+    int id;
+
+    new_slots = calloc(new_size, sizeof(int));
+    if(new_slots == NULL)
+        return -1;
+
+    for(id = 0; id < lbeacon_registry.number_entries; id++){
+
+        _lbeacon_registry_insert_index(new_slots,
+                                       new_size,
+                                       lbeacon_registry_get_entry(id)->uuid,
+                                       id);
+    }
+
+    free(lbeacon_registry.index_slots);
+
+    lbeacon_registry.index_slots = new_slots;
+    lbeacon_registry.index_size = new_size;
+
+    return 0;
+}
+
+
+ErrorCode initialize_lbeacon_registry(){
+
+    memset(&lbeacon_registry, 0, sizeof(LBeaconRegistry));
+
+    ma_init(&lbeacon_registry.arena, SIZE_OF_LBEACON_REGISTRY_ARENA_CHUNK);
+
+    lbeacon_registry.entry_chunks =
+        ma_alloc(&lbeacon_registry.arena,
+                 sizeof(LBeaconRegistryEntry *) * MAX_LBEACON_REGISTRY_CHUNKS);
+    lbeacon_registry.index_slots =
+        calloc(INITIAL_LBEACON_INDEX_SIZE, sizeof(int));
+
+    if(lbeacon_registry.entry_chunks == NULL ||
+       lbeacon_registry.index_slots == NULL){
+
+        zlog_error(category_debug, "cannot initialize lbeacon registry");
+
+        free(lbeacon_registry.index_slots);
+        ma_destroy(&lbeacon_registry.arena);
+        return E_MALLOC;
+    }
+
+    lbeacon_registry.index_size = INITIAL_LBEACON_INDEX_SIZE;
+    lbeacon_registry.number_entries = 0;
+
+    pthread_rwlock_init(&lbeacon_registry.rwlock, NULL);
+
+    return WORK_SUCCESSFULLY;
+}
+
+void destroy_lbeacon_registry(){
+
+    pthread_rwlock_destroy(&lbeacon_registry.rwlock);
+
+    free(lbeacon_registry.index_slots);
+    lbeacon_registry.index_slots = NULL;
+
+    ma_destroy(&lbeacon_registry.arena);
+}
+
+int lbeacon_registry_intern(const char *uuid){
+
+    int id;
+    int chunk_index;
+    LBeaconRegistryEntry * entry;
+    char coordinate[LENGTH_OF_COORDINATE];
+    char area_id[LENGTH_OF_AREA_ID_IN_UUID + 1];
+
+    if(uuid == NULL || strlen(uuid) != LENGTH_OF_UUID - 1)
+        return LBEACON_ID_UNKNOWN;
+
+    pthread_rwlock_rdlock(&lbeacon_registry.rwlock);
+    id = _lbeacon_registry_find(uuid);
+    pthread_rwlock_unlock(&lbeacon_registry.rwlock);
+
+    if(id != LBEACON_ID_UNKNOWN)
+        return id;
+
+    pthread_rwlock_wrlock(&lbeacon_registry.rwlock);
+
+    // another thread may have interned the uuid since the read lock was
+    // released
+    id = _lbeacon_registry_find(uuid);
+    if(id != LBEACON_ID_UNKNOWN){
+        pthread_rwlock_unlock(&lbeacon_registry.rwlock);
+        return id;
+    }
+
+    id = lbeacon_registry.number_entries;
+    chunk_index = id / LBEACON_ENTRIES_IN_ONE_CHUNK;
+
+    if(chunk_index >= MAX_LBEACON_REGISTRY_CHUNKS){
+        pthread_rwlock_unlock(&lbeacon_registry.rwlock);
+        zlog_error(category_debug, "lbeacon registry reaches maximum entries");
+        return LBEACON_ID_UNKNOWN;
+    }
+
+    if(id % LBEACON_ENTRIES_IN_ONE_CHUNK == 0){
+
+        lbeacon_registry.entry_chunks[chunk_index] =
+            ma_alloc(&lbeacon_registry.arena,
+                     sizeof(LBeaconRegistryEntry) *
+                     LBEACON_ENTRIES_IN_ONE_CHUNK);
+
+        if(lbeacon_registry.entry_chunks[chunk_index] == NULL){
+            pthread_rwlock_unlock(&lbeacon_registry.rwlock);
+            zlog_error(category_debug, "cannot allocate lbeacon registry");
+            return LBEACON_ID_UNKNOWN;
+        }
+    }
+
+    // keep the load factor of the index under one half
+    if((id + 1) * 2 > lbeacon_registry.index_size &&
+       _lbeacon_registry_grow_index() != 0){
+
+        pthread_rwlock_unlock(&lbeacon_registry.rwlock);
+        zlog_error(category_debug, "cannot grow lbeacon registry index");
+        return LBEACON_ID_UNKNOWN;
+    }
+
+    entry = lbeacon_registry_get_entry(id);
+
+    strcpy(entry->uuid, uuid);
+
+    memset(area_id, 0, sizeof(area_id));
+    strncpy(area_id, uuid, LENGTH_OF_AREA_ID_IN_UUID);
+    entry->area_id = atoi(area_id);
+
+    memcpy(coordinate, uuid + INDEX_OF_COORDINATE_X_IN_UUID,
+           LENGTH_OF_COORDINATE_IN_UUID);
+    coordinate[LENGTH_OF_COORDINATE_IN_UUID] = '\0';
+    entry->coordinateX = atof(coordinate);
+
+    memcpy(coordinate, uuid + INDEX_OF_COORDINATE_Y_IN_UUID,
+           LENGTH_OF_COORDINATE_IN_UUID);
+    coordinate[LENGTH_OF_COORDINATE_IN_UUID] = '\0';
+    entry->coordinateY = atof(coordinate);
+
+    _lbeacon_registry_insert_index(lbeacon_registry.index_slots,
+                                   lbeacon_registry.index_size,
+                                   uuid,
+                                   id);
+
+    lbeacon_registry.number_entries = id + 1;
+
+    pthread_rwlock_unlock(&lbeacon_registry.rwlock);
+
+    return id;
+}
+
+const char *lbeacon_registry_get_uuid(int id){
+
+    if(id == LBEACON_ID_UNKNOWN)
+        return "";
+
+    return lbeacon_registry_get_entry(id)->uuid;
+}
+
+ErrorCode lbeacon_registry_update_from_registration(
+    char *buf,
+    size_t buf_len,
+    int number_of_fields_per_lbeacon){
+
+    char temp_buf[WIFI_MESSAGE_LENGTH];
+    char *saveptr = NULL;
+    char *numbers_str = NULL;
+    char *uuid = NULL;
+    int numbers;
+    int i;
+
+    if(buf_len >= sizeof(temp_buf))
+        return E_API_PROTOCOL_FORMAT;
+
+    memset(temp_buf, 0, sizeof(temp_buf));
+    memcpy(temp_buf, buf, buf_len);
+
+    numbers_str = strtok_save(temp_buf, DELIMITER_SEMICOLON, &saveptr);
+    if(numbers_str == NULL)
+        return E_API_PROTOCOL_FORMAT;
+
+    numbers = atoi(numbers_str);
+
+    // skip the gateway_ip field
+    if(strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr) == NULL)
+        return E_API_PROTOCOL_FORMAT;
+
+    while(numbers-- > 0){
+
+        uuid = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
+        if(uuid == NULL)
+            return E_API_PROTOCOL_FORMAT;
+
+        if(lbeacon_registry_intern(uuid) == LBEACON_ID_UNKNOWN){
+            zlog_error(category_debug,
+                       "cannot register lbeacon uuid [%s]", uuid);
+        }
+
+        // skip the other fields of this lbeacon
+        for(i = 1; i < number_of_fields_per_lbeacon; i++){
+            if(strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr) == NULL)
+                return E_API_PROTOCOL_FORMAT;
+        }
+    }
+
+    return WORK_SUCCESSFULLY;
+}
@@ -0,0 +1,213 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and conditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     LBeaconRegistry.h
+
+  File Description:
+
+     This file contains the header of function declarations and variable used
+     in LBeaconRegistry.c
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     BeDIS uses LBeacons to deliver 3D coordinates and textual descriptions of
+     their locations to users' devices. Basically, a LBeacon is an inexpensive,
+     Bluetooth Smart Ready device. The 3D coordinates and location description
+     of every LBeacon are retrieved from BeDIS (Building/environment Data and
+     Information System) and stored locally during deployment and maintenance
+     times. Once initialized, each LBeacon broadcasts its coordinates and
+     location description to Bluetooth enabled user devices within its coverage
+     area.
+ */
+
+#ifndef LBEACON_REGISTRY_H
+#define LBEACON_REGISTRY_H
+
+#include <pthread.h>
+
+#include "BeDIS.h"
+
+/* The id returned for an lbeacon uuid which cannot be interned, and stored
+in place of an lbeacon id which is not known */
+#define LBEACON_ID_UNKNOWN -1
+
+/* The number of entries in each chunk of the registry. Entries are allocated
+one chunk at a time and never move, so an entry can be read without holding
+the lock of the registry once its id is known. */
+#define LBEACON_ENTRIES_IN_ONE_CHUNK 256
+
+/* The maximum number of chunks of the registry. The product of this constant
+and LBEACON_ENTRIES_IN_ONE_CHUNK is the maximum number of lbeacons. */
+#define MAX_LBEACON_REGISTRY_CHUNKS 256
+
+/* The initial number of slots of the index from lbeacon uuids to ids. It must
+be a power of 2. */
+#define INITIAL_LBEACON_INDEX_SIZE 1024
+
+/* The size in bytes of each chunk of the memory arena of the registry */
+#define SIZE_OF_LBEACON_REGISTRY_ARENA_CHUNK 65536
+
+/* The number of fields of each lbeacon in the registration message sent by
+gateways with API version less than 2.2, and with later API versions */
+#define LBEACON_REGISTRATION_FIELDS_LESS_VER22 3
+#define LBEACON_REGISTRATION_FIELDS 4
+
+/* Structure of the information of one lbeacon parsed from its uuid */
+typedef struct {
+
+    char uuid[LENGTH_OF_UUID];
+
+    /* The area id and coordinates encoded in the uuid */
+    int area_id;
+    float coordinateX;
+    float coordinateY;
+
+} LBeaconRegistryEntry;
+
+/* Structure of the process-wide registry of lbeacons */
+typedef struct {
+
+    /* The lock protecting the index and the number of entries. Lookups take
+    it for reading, and only the interning of a new uuid takes it for
+    writing. */
+    pthread_rwlock_t rwlock;
+
+    /* The dense storage of entries. The id of an lbeacon is the index of its
+    entry. */
+    LBeaconRegistryEntry ** entry_chunks;
+    int number_entries;
+
+    /* The open-addressing index from uuids to ids. Each slot holds the id
+    plus one, and zero marks an empty slot. */
+    int * index_slots;
+    int index_size;
+
+    /* The memory arena owning the entry storage */
+    Memory_Arena arena;
+
+} LBeaconRegistry;
+
+/* Global variables */
+
+/* The registry of all lbeacons known to the server */
+LBeaconRegistry lbeacon_registry;
+
+/* Returns the entry of the input lbeacon id which is returned by
+   lbeacon_registry_intern */
+#define lbeacon_registry_get_entry(id) \
+    (&lbeacon_registry.entry_chunks[(id) / LBEACON_ENTRIES_IN_ONE_CHUNK] \
+                                   [(id) % LBEACON_ENTRIES_IN_ONE_CHUNK])
+
+/*
+  initialize_lbeacon_registry:
+
+     This function initializes the registry of lbeacons.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_MALLOC: cannot allocate memory for the registry
+ */
+ErrorCode initialize_lbeacon_registry();
+
+/*
+  destroy_lbeacon_registry:
+
+     This function releases all the memory of the registry of lbeacons. No
+     lbeacon id may be used after this function is called.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     None
+ */
+void destroy_lbeacon_registry();
+
+/*
+  lbeacon_registry_intern:
+
+     This function returns the id of the input lbeacon uuid, and adds the
+     lbeacon to the registry with its area id and coordinates parsed from the
+     uuid when the uuid is seen for the first time.
+
+  Parameters:
+
+     uuid - the uuid of lbeacon
+
+  Return value:
+
+     int - the id of the lbeacon, or LBEACON_ID_UNKNOWN if the uuid is
+           malformed or the registry is full
+ */
+int lbeacon_registry_intern(const char *uuid);
+
+/*
+  lbeacon_registry_get_uuid:
+
+     This function returns the uuid of the input lbeacon id.
+
+  Parameters:
+
+     id - the id of lbeacon, or LBEACON_ID_UNKNOWN
+
+  Return value:
+
+     const char * - the uuid of the lbeacon, or an empty string for
+                    LBEACON_ID_UNKNOWN
+ */
+const char *lbeacon_registry_get_uuid(int id);
+
+/*
+  lbeacon_registry_update_from_registration:
+
+     This function interns the uuids of all lbeacons in the registration
+     message sent by a gateway, so that the lbeacons are known before their
+     tracking data arrive.
+
+  Parameters:
+
+     buf - a pointer to an input string with the format below to specify the
+           registered lbeacons.
+
+           length;gateway_ip;lbeacon_uuid_1;...;lbeacon_uuid_2;...;
+
+     buf_len - Length in number of bytes of buf input string
+
+     number_of_fields_per_lbeacon - the number of fields of each lbeacon in
+                                    the message, i.e.,
+                                    LBEACON_REGISTRATION_FIELDS_LESS_VER22 or
+                                    LBEACON_REGISTRATION_FIELDS
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_API_PROTOCOL_FORMAT: the message is malformed
+ */
+ErrorCode lbeacon_registry_update_from_registration(
+    char *buf,
+    size_t buf_len,
+    int number_of_fields_per_lbeacon);
+
+#endif
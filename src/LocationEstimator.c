@@ -0,0 +1,288 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and conditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     LocationEstimator.c
+
+  File Description:
+
+     This file contains the location estimators of BOT server. An estimator
+     computes the locations of the objects in a summary batch from the
+     weights and coordinates of the lbeacons scanning them, and is selected
+     by its name in server.conf.
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     BeDIS uses LBeacons to deliver 3D coordinates and textual descriptions of
+     their locations to users' devices. Basically, a LBeacon is an inexpensive,
+     Bluetooth Smart Ready device. The 3D coordinates and location description
+     of every LBeacon are retrieved from BeDIS (Building/environment Data and
+     Information System) and stored locally during deployment and maintenance
+     times. Once initialized, each LBeacon broadcasts its coordinates and
+     location description to Bluetooth enabled user devices within its coverage
+     area.
+ */
+
+#include "LocationEstimator.h"
+
+
+static void _compute_weighted_centroids(SummaryBatch * batch);
+
+
+/* The location estimators which can be selected in server.conf */
+static const LocationEstimator location_estimators[] = {
+    { LOCATION_ESTIMATOR_CENTROID, estimate_locations_by_centroid },
+    { LOCATION_ESTIMATOR_KALMAN, estimate_locations_by_kalman_filter }
+};
+
+/* The centroid estimator is used until another one is selected */
+const LocationEstimator * volatile location_estimator = 
+    &location_estimators[0];
+
+
+/*
+Computes the weighted sums of coordinates and the sums of weights of all 
+objects in the batch. Each object adds its lbeacons in the order they were 
+staged, with the same float operations as one object at a time, so the sums 
+are the same in every lane and in every kernel. The unused entries of the 
+batch are padded with zero weights and coordinates of -0.0, which leave any 
+sum unchanged.
+*/
+
+static void _compute_weighted_centroids(SummaryBatch * batch){
+
+    int number_lanes = (batch->number_objects + SUMMARY_KERNEL_LANES - 1) & 
+                       ~(SUMMARY_KERNEL_LANES - 1);
+    int o;
+    int j;
+
+#if defined(SUMMARY_KERNEL_AVX2)
+    __m256 weight_x;
+    __m256 weight_y;
+    __m256 weight;
+    __m256i weight_count;
+    __m256i weight_int;
+#elif defined(SUMMARY_KERNEL_SSE2)
+    __m128 weight_x;
+    __m128 weight_y;
+    __m128 weight;
+    __m128i weight_count;
+    __m128i weight_int;
+#endif
+
+    for(o = 0; o < number_lanes; o++){
+
+        if(o >= batch->number_objects)
+            batch->objects[o].number_weights = 0;
+
+        for(j = batch->objects[o].number_weights; 
+            j < batch->max_number_weights; j++){
+
+            batch->weights[j][o] = 0;
+            batch->coordinateX[j][o] = -0.0f;
+            batch->coordinateY[j][o] = -0.0f;
+        }
+    }
+
+#if defined(SUMMARY_KERNEL_AVX2)
+
+    for(o = 0; o < number_lanes; o += SUMMARY_KERNEL_LANES){
+
+        weight_x = _mm256_setzero_ps();
+        weight_y = _mm256_setzero_ps();
+        weight_count = _mm256_setzero_si256();
+
+        for(j = 0; j < batch->max_number_weights; j++){
+
+            weight_int = 
+                _mm256_loadu_si256((__m256i *)&batch->weights[j][o]);
+            weight = _mm256_cvtepi32_ps(weight_int);
+
+            weight_x = _mm256_add_ps(
+                           weight_x, 
+                           _mm256_mul_ps(
+                               _mm256_loadu_ps(&batch->coordinateX[j][o]),
+                               weight));
+            weight_y = _mm256_add_ps(
+                           weight_y, 
+                           _mm256_mul_ps(
+                               _mm256_loadu_ps(&batch->coordinateY[j][o]),
+                               weight));
+            weight_count = _mm256_add_epi32(weight_count, weight_int);
+        }
+
+        _mm256_storeu_ps(&batch->weight_x[o], weight_x);
+        _mm256_storeu_ps(&batch->weight_y[o], weight_y);
+        _mm256_storeu_si256((__m256i *)&batch->weight_count[o], 
+                            weight_count);
+    }
+
+#elif defined(SUMMARY_KERNEL_SSE2)
+
+    for(o = 0; o < number_lanes; o += SUMMARY_KERNEL_LANES){
+
+        weight_x = _mm_setzero_ps();
+        weight_y = _mm_setzero_ps();
+        weight_count = _mm_setzero_si128();
+
+        for(j = 0; j < batch->max_number_weights; j++){
+
+            weight_int = _mm_loadu_si128((__m128i *)&batch->weights[j][o]);
+            weight = _mm_cvtepi32_ps(weight_int);
+
+            weight_x = _mm_add_ps(weight_x, 
+                                  _mm_mul_ps(
+                                      _mm_loadu_ps(&batch->coordinateX[j][o]),
+                                      weight));
+            weight_y = _mm_add_ps(weight_y, 
+                                  _mm_mul_ps(
+                                      _mm_loadu_ps(&batch->coordinateY[j][o]),
+                                      weight));
+            weight_count = _mm_add_epi32(weight_count, weight_int);
+        }
+
+        _mm_storeu_ps(&batch->weight_x[o], weight_x);
+        _mm_storeu_ps(&batch->weight_y[o], weight_y);
+        _mm_storeu_si128((__m128i *)&batch->weight_count[o], weight_count);
+    }
+
+#else
+
+    for(o = 0; o < number_lanes; o++){
+        batch->weight_x[o] = 0;
+        batch->weight_y[o] = 0;
+        batch->weight_count[o] = 0;
+    }
+
+    for(j = 0; j < batch->max_number_weights; j++){
+        for(o = 0; o < number_lanes; o++){
+
+            batch->weight_x[o] += 
+                batch->coordinateX[j][o] * (float)batch->weights[j][o];
+            batch->weight_y[o] += 
+                batch->coordinateY[j][o] * (float)batch->weights[j][o];
+            batch->weight_count[o] += batch->weights[j][o];
+        }
+    }
+
+#endif
+}
+
+ErrorCode select_location_estimator(const char *name){
+
+    size_t i;
+
+    for(i = 0; 
+        i < sizeof(location_estimators) / sizeof(LocationEstimator); 
+        i++){
+
+        if(strcmp(location_estimators[i].name, name) == 0){
+
+            location_estimator = &location_estimators[i];
+            return WORK_SUCCESSFULLY;
+        }
+    }
+
+    zlog_error(category_debug, 
+               "unknown location estimator [%s], use [%s] instead",
+               name,
+               LOCATION_ESTIMATOR_CENTROID);
+
+    location_estimator = &location_estimators[0];
+
+    return E_INPUT_PARAMETER;
+}
+
+void estimate_locations_by_centroid(SummaryBatch * batch, int current_time){
+
+    int o;
+
+    // the centroid does not depend on the time
+    (void)current_time;
+
+    _compute_weighted_centroids(batch);
+
+    for(o = 0; o < batch->number_objects; o++){
+
+        batch->is_located[o] = (batch->weight_count[o] > 0);
+
+        if(!batch->is_located[o])
+            continue;
+
+        batch->estimated_x[o] = 
+            batch->weight_x[o]/(float)batch->weight_count[o];
+        batch->estimated_y[o] = 
+            batch->weight_y[o]/(float)batch->weight_count[o];
+    }
+}
+
+void estimate_locations_by_kalman_filter(SummaryBatch * batch, 
+                                         int current_time){
+
+    int o;
+    float measured_x;
+    float measured_y;
+    float gain;
+    hash_table_row * table_row;
+
+    _compute_weighted_centroids(batch);
+
+    for(o = 0; o < batch->number_objects; o++){
+
+        batch->is_located[o] = (batch->weight_count[o] > 0);
+
+        if(!batch->is_located[o])
+            continue;
+
+        table_row = batch->objects[o].table_row;
+
+        measured_x = batch->weight_x[o]/(float)batch->weight_count[o];
+        measured_y = batch->weight_y[o]/(float)batch->weight_count[o];
+
+        if(table_row->estimate_timestamp == 0){
+
+            // the first measurement is taken as it is
+            table_row->estimated_coordinateX = measured_x;
+            table_row->estimated_coordinateY = measured_y;
+            table_row->estimate_variance = KALMAN_MEASUREMENT_VARIANCE;
+
+        }else{
+
+            // the object may have moved since the last estimate
+            if(current_time > table_row->estimate_timestamp){
+                table_row->estimate_variance += 
+                    KALMAN_PROCESS_VARIANCE_PER_SEC * 
+                    (current_time - table_row->estimate_timestamp);
+            }
+
+            gain = table_row->estimate_variance / 
+                   (table_row->estimate_variance + 
+                    KALMAN_MEASUREMENT_VARIANCE);
+
+            table_row->estimated_coordinateX += 
+                gain * (measured_x - table_row->estimated_coordinateX);
+            table_row->estimated_coordinateY += 
+                gain * (measured_y - table_row->estimated_coordinateY);
+            table_row->estimate_variance *= (1 - gain);
+        }
+
+        table_row->estimate_timestamp = current_time;
+
+        batch->estimated_x[o] = table_row->estimated_coordinateX;
+        batch->estimated_y[o] = table_row->estimated_coordinateY;
+    }
+}
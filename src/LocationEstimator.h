@@ -0,0 +1,164 @@
+/*
+  Copyright (c) 2016 Academia Sinica, Institute of Information Science
+
+  License:
+
+     GPL 3.0 : The content of this file is subject to the terms and conditions
+     defined in file 'COPYING.txt', which is part of this source code package.
+
+  Project Name:
+
+     BeDIS
+
+  File Name:
+
+     LocationEstimator.h
+
+  File Description:
+
+     This file contains the header of function declarations and variable used
+     in LocationEstimator.c
+
+  Version:
+
+     1.0, 20201018
+
+  Abstract:
+
+     BeDIS uses LBeacons to deliver 3D coordinates and textual descriptions of
+     their locations to users' devices. Basically, a LBeacon is an inexpensive,
+     Bluetooth Smart Ready device. The 3D coordinates and location description
+     of every LBeacon are retrieved from BeDIS (Building/environment Data and
+     Information System) and stored locally during deployment and maintenance
+     times. Once initialized, each LBeacon broadcasts its coordinates and
+     location description to Bluetooth enabled user devices within its coverage
+     area.
+ */
+
+#ifndef LOCATION_ESTIMATOR_H
+#define LOCATION_ESTIMATOR_H
+
+#include "HashTable.h"
+
+/* The summary kernel is made of plain loops, which the compiler vectorizes 
+at the optimization level of the release build. A build defining 
+SUMMARY_KERNEL_SIMD uses the widest kernel of intrinsics of its target 
+instead, which pays off only where replayLocationEstimator shows it faster 
+than the plain loops of the same build. */
+#if defined(SUMMARY_KERNEL_SIMD) && defined(__AVX2__)
+   #define SUMMARY_KERNEL_AVX2
+   #define SUMMARY_KERNEL_NAME "avx2"
+   #define SUMMARY_KERNEL_LANES 8
+   #include <immintrin.h>
+#elif defined(SUMMARY_KERNEL_SIMD) && \
+      (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+       defined(__SSE2__))
+   #define SUMMARY_KERNEL_SSE2
+   #define SUMMARY_KERNEL_NAME "sse2"
+   #define SUMMARY_KERNEL_LANES 4
+   #include <emmintrin.h>
+#else
+   #define SUMMARY_KERNEL_NAME "scalar"
+   #define SUMMARY_KERNEL_LANES 1
+#endif
+
+/* The names of the location estimators in server.conf */
+#define LOCATION_ESTIMATOR_CENTROID "centroid"
+#define LOCATION_ESTIMATOR_KALMAN "kalman"
+
+/* Maximum number of characters of the name of a location estimator */
+#define LENGTH_OF_LOCATION_ESTIMATOR_NAME 32
+
+/* The growth per second of the variance of the location of an object in the
+Kalman estimator, in square millimeters. It corresponds to objects walking 
+about one meter per second. */
+#define KALMAN_PROCESS_VARIANCE_PER_SEC 1000000.0f
+
+/* The variance of the weighted centroid of lbeacons as a measurement of the 
+location in the Kalman estimator, in square millimeters. It corresponds to 
+an error of about three meters. */
+#define KALMAN_MEASUREMENT_VARIANCE 9000000.0f
+
+/* The function estimating the locations of the objects in a summary batch. 
+It reads the weights and coordinates of lbeacons staged for each object, 
+and sets estimated_x, estimated_y and is_located of each object. The 
+node_locks of the rows of the objects are held, so the function may keep 
+state in the estimate fields of the rows. */
+typedef void (*EstimateLocations)(SummaryBatch * batch, int current_time);
+
+/* Structure of a location estimator */
+typedef struct {
+
+    const char *name;
+
+    EstimateLocations estimate_locations;
+
+} LocationEstimator;
+
+/* Global variables */
+
+/* The location estimator used by summary passes. It is selected when the 
+server configuration is loaded, and is the centroid estimator until then. */
+const LocationEstimator * volatile location_estimator;
+
+/*
+  select_location_estimator:
+
+     This function selects the location estimator used by summary passes by
+     its name in server.conf. The centroid estimator is selected if the name
+     is not known.
+
+  Parameters:
+
+     name - the name of the location estimator, i.e., 
+            LOCATION_ESTIMATOR_CENTROID or LOCATION_ESTIMATOR_KALMAN
+
+  Return value:
+
+     ErrorCode - WORK_SUCCESSFULLY: work successfully.
+                 E_INPUT_PARAMETER: the name is not known
+ */
+ErrorCode select_location_estimator(const char *name);
+
+/*
+  estimate_locations_by_centroid:
+
+     This function estimates the location of each object as the centroid of 
+     the coordinates of its lbeacons weighted by their rssi weights. An 
+     object without any weight is not located.
+
+  Parameters:
+
+     batch - the summary batch of objects
+
+     current_time - the current time in epoch seconds
+
+  Return value:
+
+     None
+ */
+void estimate_locations_by_centroid(SummaryBatch * batch, int current_time);
+
+/*
+  estimate_locations_by_kalman_filter:
+
+     This function smooths the weighted centroid of each object with a 
+     Kalman filter of a stationary location whose variance grows with time. 
+     The filtered location and its variance are kept in the row of the 
+     object between passes. An object without any weight is not located, 
+     and its filter is left unchanged.
+
+  Parameters:
+
+     batch - the summary batch of objects
+
+     current_time - the current time in epoch seconds
+
+  Return value:
+
+     None
+ */
+void estimate_locations_by_kalman_filter(SummaryBatch * batch, 
+                                         int current_time);
+
+#endif
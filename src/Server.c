@@ -93,7 +93,10 @@ int main(int argc, char **argv)
     information is for GUI to display tracking path of objects. */
     pthread_t upload_history_threads[MAX_UPLOAD_HISTORY_TASK_THREADS];
 
-    AreaSet *area_set = NULL;
+    /* The thread for summarizing and uploading location information of 
+    objects in time critical areas as soon as their closest lbeacon may have
+    changed */
+    pthread_t urgent_summary_thread;
 
 
     /* Initialize flags */
@@ -136,10 +139,9 @@ int main(int argc, char **argv)
 
     zlog_info(category_debug,"Mempool Initializing");
 
-    /* Initialize the memory pool for buffer nodes */
-    if(MEMORY_POOL_SUCCESS != mp_init( &node_mempool, 
-                                       sizeof(BufferNode), 
-                                       SLOTS_IN_MEM_POOL_BUFFER_NODE))
+    /* Initialize the memory pools for buffer nodes and their payload */
+    if(WORK_SUCCESSFULLY != 
+       init_buffer_node_mempools(SLOTS_IN_MEM_POOL_BUFFER_NODE))
     {
         zlog_error(category_debug, 
                    "Failed to initialize memory pool for buffer");
@@ -196,6 +198,13 @@ int main(int argc, char **argv)
         return E_MALLOC;
     }
 
+    mp_set_name(&geofence_area_mempool, "geofence_area_mempool");
+    mp_set_name(&geofence_setting_mempool, "geofence_setting_mempool");
+    mp_set_name(&geofence_objects_area_mempool, 
+                "geofence_objects_area_mempool");
+    mp_set_name(&geofence_violation_mempool, "geofence_violation_mempool");
+    mp_set_name(&notification_mempool, "notification_mempool");
+
     zlog_info(category_debug,"Mempool Initialized");
 
     /* Create the config from input serverconfig file */
@@ -211,6 +220,24 @@ int main(int argc, char **argv)
 
     zlog_info(category_debug,"Initialize buffer lists");
 	
+    //initial the registry of lbeacons shared by all covered areas
+    if(WORK_SUCCESSFULLY != initialize_lbeacon_registry()){
+
+        zlog_error(category_debug, "Cannot initialize lbeacon registry");
+        return E_MALLOC;
+    }
+
+    //build the weights of average rssi values for the configured multiplier
+    if(WORK_SUCCESSFULLY != 
+       update_rssi_weight_table(config.rssi_weight_multiplier)){
+
+        zlog_error(category_debug, "Cannot initialize rssi weight table");
+        return E_MALLOC;
+    }
+
+    //the centroid estimator is used if the configured one is not known
+    select_location_estimator(config.location_estimator);
+
 	//initial each hashtable for all covered areas
     if(WORK_SUCCESSFULLY != initialize_area_table()){
 
@@ -218,6 +245,14 @@ int main(int argc, char **argv)
         return E_MALLOC;
     }
 
+    //invalid settings of areas in the lists are ignored
+    set_time_critical_areas(
+        config.time_critical_area_id_list,
+        config.rssi_difference_of_location_accuracy_tolerance);
+
+    set_area_tolerant_not_scanning_time(
+        config.area_tolerant_not_scanning_time_list);
+
     /* Initialize the address map */
     init_Address_Map( &Gateway_address_map);
 
@@ -431,29 +466,22 @@ int main(int argc, char **argv)
         return return_value;
     }
 	
+    initialize_area_work_queue(&summary_work_queue, 
+                               "summary", 
+                               NORMAL_WAITING_TIME_IN_MS);
+
+    initialize_area_work_queue(
+        &history_work_queue, 
+        "upload history", 
+        config.time_to_upload_history_location_in_sec * 1000);
+
     // create threads to summarize and upload location information under 
     // covered areas
     for(i = 0 ; i < config.number_summary_threads ; i++){
 
-        area_set = malloc(sizeof(AreaSet));
-
-        if(area_set == NULL){
-
-            zlog_error(category_health_report, 
-                       "cannot malloc AreaSet");
-            zlog_error(category_debug, 
-                       "cannot malloc AreaSet");
-            return E_MALLOC;
-        }
-        memset(area_set, 0, sizeof(AreaSet));
-
-        area_set -> start_area_index = i;
-        area_set -> number_areas = 
-            config.number_areas_per_summary_thread;
-
         return_value = startThread(&summary_task_threads[i],
                                    summarize_and_upload_location_information_in_areas,
-                                   (void*)area_set);
+                                   NULL);
 
         if(return_value != WORK_SUCCESSFULLY)
         {
@@ -471,25 +499,9 @@ int main(int argc, char **argv)
     // areas
     for(i = 0 ; i < config.number_upload_history_threads ; i++){
 
-        area_set = malloc(sizeof(AreaSet));
-
-        if(area_set == NULL){
-
-            zlog_error(category_health_report, 
-                       "cannot malloc AreaSet");
-            zlog_error(category_debug, 
-                       "cannot malloc AreaSet");
-            return E_MALLOC;
-        }
-        memset(area_set, 0, sizeof(AreaSet));
-
-        area_set -> start_area_index = i;
-        area_set -> number_areas = 
-            config.number_areas_per_upload_history_thread;
-
         return_value = startThread(&upload_history_threads[i],
                                    upload_location_history_information_in_areas,
-                                   (void*)area_set);
+                                   NULL);
 
         if(return_value != WORK_SUCCESSFULLY)
         {
@@ -502,6 +514,26 @@ int main(int argc, char **argv)
             return return_value;
         }     
     }
+
+    // create thread to summarize and upload location information of urgent
+    // objects in time critical areas
+    if(number_time_critical_areas > 0){
+
+        return_value = startThread(&urgent_summary_thread,
+                                   summarize_and_upload_urgent_location_in_areas,
+                                   NULL);
+
+        if(return_value != WORK_SUCCESSFULLY)
+        {
+            zlog_error(category_health_report, 
+                       "create thread for " \
+                       "summarize_and_upload_urgent_location_in_areas fail");
+            zlog_error(category_debug, 
+                       "create thread for " \
+                       "summarize_and_upload_urgent_location_in_areas fail");
+            return return_value;
+        }
+    }
 	
     zlog_info(category_debug,"Start Communication");
 
@@ -523,12 +555,21 @@ int main(int argc, char **argv)
 
     last_polling_object_tracking_time = 0;
     last_polling_LBeacon_for_HR_time = 0;
+    last_report_mempool_statistics_time = get_clock_time();
 
     /* The while loop that keeps the program running */
     while(ready_to_work == true)
     {
         uptime = get_clock_time();
 
+        /* If it is the time to report the usage of memory pools, do it */
+        if(uptime - last_report_mempool_statistics_time >=
+           PERIOD_BETWEEN_REPORT_MEMPOOL_STATISTICS_IN_SEC)
+        {
+            report_mempool_statistics();
+
+            last_report_mempool_statistics_time = uptime;
+        }
 
         /* If it is the time to poll track object data from LBeacons, do it */
         if(uptime - last_polling_object_tracking_time >=
@@ -588,7 +629,7 @@ int main(int argc, char **argv)
     /* Release the Wifi elements and close the connection. */
     udp_release( &udp_config);
 
-    mp_destroy(&node_mempool);
+    destroy_buffer_node_mempools();
 
     SQL_destroy_database_connection_pool(&config.db_connection_list_head);
 
@@ -613,6 +654,16 @@ int main(int argc, char **argv)
 
     mp_destroy(&notification_mempool);
 
+    destroy_area_work_queue(&summary_work_queue);
+
+    destroy_area_work_queue(&history_work_queue);
+
+    destroy_area_table();
+
+    destroy_rssi_weight_table();
+
+    destroy_lbeacon_registry();
+
     return WORK_SUCCESSFULLY;
 }
 
@@ -778,24 +829,12 @@ ErrorCode get_server_config(ServerConfig *config,
               "The number_summary_threads is [%d]",
               config->number_summary_threads);
 
-    fetch_next_string(file, config_message, sizeof(config_message));
-    config->number_areas_per_summary_thread = atoi(config_message);
-    zlog_info(category_debug,
-              "The number_areas_per_summary_thread is [%d]",
-              config->number_areas_per_summary_thread);
-
     fetch_next_string(file, config_message, sizeof(config_message));
     config->number_upload_history_threads = atoi(config_message);
     zlog_info(category_debug,
               "The number_upload_history_threads is [%d]",
               config->number_upload_history_threads);
 
-    fetch_next_string(file, config_message, sizeof(config_message));
-    config->number_areas_per_upload_history_thread = atoi(config_message);
-    zlog_info(category_debug,
-              "The number_areas_per_upload_history_thread is [%d]",
-              config->number_areas_per_upload_history_thread);
-
     fetch_next_string(file, config_message, sizeof(config_message));
     config->rssi_threashold_for_summarize_location_pin = atoi(config_message);
     zlog_info(category_debug,
@@ -963,6 +1002,24 @@ ErrorCode get_server_config(ServerConfig *config,
     strcpy(config->SMS_message_template, config_message);
     zlog_info(category_debug, "SMS_message_template = [%s]",
               config->SMS_message_template);
+
+    fetch_next_string(file, config_message, sizeof(config_message));
+    memset(config->location_estimator, 0, 
+           sizeof(config->location_estimator));
+    strncpy(config->location_estimator, config_message, 
+            sizeof(config->location_estimator) - 1);
+    zlog_info(category_debug, "location_estimator = [%s]",
+              config->location_estimator);
+
+    fetch_next_string(file, config_message, sizeof(config_message));
+    strcpy(config->time_critical_area_id_list, config_message);
+    zlog_info(category_debug, "time_critical_area_id_list = [%s]",
+              config->time_critical_area_id_list);
+
+    fetch_next_string(file, config_message, sizeof(config_message));
+    strcpy(config->area_tolerant_not_scanning_time_list, config_message);
+    zlog_info(category_debug, "area_tolerant_not_scanning_time_list = [%s]",
+              config->area_tolerant_not_scanning_time_list);
 			 
     zlog_info(category_debug, "notification list initialized");
 
@@ -971,6 +1028,23 @@ ErrorCode get_server_config(ServerConfig *config,
     return WORK_SUCCESSFULLY;
 }
 
+void report_mempool_statistics()
+{
+    report_buffer_node_mempool_statistics();
+
+    log_mempool_statistics(&geofence_area_mempool);
+
+    log_mempool_statistics(&geofence_setting_mempool);
+
+    log_mempool_statistics(&geofence_objects_area_mempool);
+
+    log_mempool_statistics(&geofence_violation_mempool);
+
+    log_mempool_statistics(&notification_mempool);
+
+    hashtable_report_mempool_statistics();
+}
+
 void *maintain_database()
 {
     ErrorCode ret = WORK_SUCCESSFULLY;
@@ -1269,6 +1343,11 @@ void *Server_NSI_routine(void *_buffer_node)
             strlen(current_node->content),
             current_node -> net_address);
 
+        lbeacon_registry_update_from_registration(
+            current_node->content,
+            strlen(current_node->content),
+            LBEACON_REGISTRATION_FIELDS_LESS_VER22);
+
     }else{
        
         SQL_update_lbeacon_registration_status(
@@ -1276,6 +1355,11 @@ void *Server_NSI_routine(void *_buffer_node)
             current_node->content,
             strlen(current_node->content),
             current_node -> net_address);
+
+        lbeacon_registry_update_from_registration(
+            current_node->content,
+            strlen(current_node->content),
+            LBEACON_REGISTRATION_FIELDS);
     }
 
      /* Put the address into Gateway_address_map */
@@ -1291,6 +1375,8 @@ void *Server_NSI_routine(void *_buffer_node)
     current_node -> pkt_direction = from_server;
     current_node -> pkt_type = join_response;
 
+    /* The join response is only a few characters long, so it always fits in
+       the payload storage of the smallest size class */
     sprintf(current_node->content, "%d;", join_status);
 
     current_node->content_size = strlen(current_node->content);
@@ -1332,7 +1418,7 @@ void *Server_BHM_routine(void *_buffer_node)
         }
     }
 
-    mp_free( &node_mempool, current_node);
+    release_buffer_node(current_node);
 
     return (void *)NULL;
 }
@@ -1363,12 +1449,14 @@ void *Server_LBeacon_routine(void *_buffer_node)
                 current_node -> content,
 				strlen(current_node -> content),
                 config.number_of_lbeacons_under_tracked,
-                config.number_of_rssi_signals_under_tracked);
+                config.number_of_rssi_signals_under_tracked,
+                config.rssi_threashold_for_summarize_location_pin,
+                config.unreasonable_rssi_change);
         }
 
     }
 
-    mp_free( &node_mempool, current_node);
+    release_buffer_node(current_node);
 
     return (void* )NULL;
 }
@@ -1402,7 +1490,7 @@ void *process_commands(void *_buffer_node){
         }
     }
 
-    mp_free( &node_mempool, current_node);
+    release_buffer_node(current_node);
 
     zlog_debug(category_debug, "<<process_commands");
 
@@ -1445,12 +1533,14 @@ void *process_tracked_data_from_geofence_gateway(void *_buffer_node)
                 current_node -> content,
 				strlen(current_node -> content),
                 config.number_of_lbeacons_under_tracked,
-                config.number_of_rssi_signals_under_tracked);
+                config.number_of_rssi_signals_under_tracked,
+                config.rssi_threashold_for_summarize_location_pin,
+                config.unreasonable_rssi_change);
         }
         
     }
 
-    mp_free( &node_mempool, current_node);
+    release_buffer_node(current_node);
 
     return (void *)NULL;
 }
@@ -1573,8 +1663,17 @@ void *Server_process_wifi_send(void *_buffer_node)
                                     BOT_SERVER_API_VERSION_LATEST,
                                     current_node->content);
 
-    strcpy(current_node->content, content);
-    current_node -> content_size =  strlen(current_node->content);
+    if(WORK_SUCCESSFULLY != set_buffer_node_content(current_node, 
+                                                    content, 
+                                                    strlen(content))){
+
+        zlog_error(category_debug, 
+                   "Server_process_wifi_send cannot hold the message, " \
+                   "abort this data");
+
+        release_buffer_node(current_node);
+        return (void *)NULL;
+    }
   
     /* Add the content of the buffer node to the UDP to be sent to the 
        destination */
@@ -1584,7 +1683,7 @@ void *Server_process_wifi_send(void *_buffer_node)
                current_node -> content,
                current_node -> content_size);
 
-    mp_free( &node_mempool, current_node);
+    release_buffer_node(current_node);
 
     zlog_info(category_debug, "Send Success");
 
@@ -1605,6 +1704,7 @@ void *Server_process_wifi_receive()
     char *request_type = NULL;
     char *API_version = NULL;
     char *remain_string = NULL;
+    int content_size = 0;
 
 
     while (ready_to_work == true)
@@ -1618,31 +1718,6 @@ void *Server_process_wifi_receive()
             continue;
         }
 
-        /* Allocate memory from node_mempool a buffer node for received data
-           and copy the data from Wi-Fi receive queue to the node. */
-        new_node = NULL;
-
-        retry_times = MEMORY_ALLOCATE_RETRIES;
-        while(retry_times --){
-            new_node = mp_alloc( &node_mempool);
-
-            if(NULL != new_node)
-                break;
-        }
-        if(NULL == new_node){
-             zlog_info(category_debug, 
-                       "Server_process_wifi_receive (new_node) mp_alloc " \
-                       "failed, abort this data");
-             continue;
-        }
-
-        memset(new_node, 0, sizeof(BufferNode));
-
-        /* Initialize the entry of the buffer node */
-        init_entry( &new_node -> buffer_entry);
-
-        new_node -> uptime_at_receive = get_clock_time();
-
         memset(buf, 0, sizeof(buf));
         strcpy(buf, temppkt.content);
 
@@ -1651,40 +1726,60 @@ void *Server_process_wifi_receive()
         from_direction = strtok_save(buf, DELIMITER_SEMICOLON, &saveptr);
         if(from_direction == NULL)
         {
-             mp_free( &node_mempool, new_node);
              continue;
         }
         remain_string = remain_string + strlen(from_direction) + 
                         strlen(DELIMITER_SEMICOLON);         
-        sscanf(from_direction, "%d", &new_node -> pkt_direction);
      
         request_type = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
         if(request_type == NULL)
         {
-             mp_free( &node_mempool, new_node);
              continue;
         }
         remain_string = remain_string + strlen(request_type) + 
                         strlen(DELIMITER_SEMICOLON);
-        sscanf(request_type, "%d", &new_node -> pkt_type);
 
         API_version = strtok_save(NULL, DELIMITER_SEMICOLON, &saveptr);
         if(API_version == NULL)
         {
-             mp_free( &node_mempool, new_node);
              continue;
         }
         remain_string = remain_string + strlen(API_version) + 
                         strlen(DELIMITER_SEMICOLON);
+
+        content_size = strlen(remain_string);
+
+        /* Allocate a buffer node with payload storage sized for the received
+           content and copy the data from Wi-Fi receive queue to the node. */
+        new_node = NULL;
+
+        retry_times = MEMORY_ALLOCATE_RETRIES;
+        while(retry_times --){
+            new_node = allocate_buffer_node(content_size);
+
+            if(NULL != new_node)
+                break;
+        }
+        if(NULL == new_node){
+             zlog_info(category_debug, 
+                       "Server_process_wifi_receive (new_node) mp_alloc " \
+                       "failed, abort this data");
+             continue;
+        }
+
+        new_node -> uptime_at_receive = get_clock_time();
+
+        sscanf(from_direction, "%d", &new_node -> pkt_direction);
+        sscanf(request_type, "%d", &new_node -> pkt_type);
         sscanf(API_version, "%f", &new_node -> API_version);
        
         /* Copy the content to the buffer_node */
-        strcpy(new_node->content, remain_string);
+        memcpy(new_node->content, remain_string, content_size);
         zlog_debug(category_debug, "pkt_direction=[%d], pkt_type=[%d], " \
                    "API_version=[%f]", new_node->pkt_direction, 
                    new_node->pkt_type, new_node->API_version);
 
-        new_node -> content_size = strlen(new_node->content);
+        new_node -> content_size = content_size;
 
         new_node -> port = temppkt.port;
 
@@ -1764,7 +1859,7 @@ void *Server_process_wifi_receive()
                                          .list_lock);
                     break;
                 default:
-                    mp_free( &node_mempool, new_node);
+                    release_buffer_node(new_node);
                     break;
             }
         }
@@ -1782,11 +1877,11 @@ void *Server_process_wifi_receive()
                     pthread_mutex_unlock(&command_buffer_list_head.list_lock);
                     break;
                 default:
-                    mp_free( &node_mempool, new_node);
+                    release_buffer_node(new_node);
                     break;
             }
         }else{
-            mp_free( &node_mempool, new_node);
+            release_buffer_node(new_node);
         }
     }
     return (void *)NULL;
@@ -1864,16 +1959,14 @@ ErrorCode add_notification_to_the_notification_list(
     return WORK_SUCCESSFULLY;
 }
 
-void* summarize_and_upload_location_information_in_areas(void *area_set){
-
-    AreaSet *area_list = (AreaSet*) area_set;
+void* summarize_and_upload_location_information_in_areas(){
 
     while(ready_to_work == true){		
 
 		hashtable_traverse_areas_to_upload_latest_location(
             &config.db_connection_list_head,
             config.server_installation_path,
-            area_list,
+            &summary_work_queue,
             config.rssi_threashold_for_summarize_location_pin,
             config.number_of_rssi_signals_under_tracked,
             config.unreasonable_rssi_change,
@@ -1881,35 +1974,41 @@ void* summarize_and_upload_location_information_in_areas(void *area_set){
             config.rssi_difference_of_location_accuracy_tolerance,
             config.base_location_tolerance_in_millimeter);
 
-        sleep_t(NORMAL_WAITING_TIME_IN_MS);
+        // wait for the next pass, or for an area of the current pass to be
+        // finished by other threads
+        sleep_t(AREA_WORK_QUEUE_POLLING_TIME_IN_MS);
 	}
-
-    free(area_list);
 	
 }
 
-void* upload_location_history_information_in_areas(void *area_set){
-	int last_upload_time=0;
-	int upload_time=0;	
-    AreaSet *area_list = (AreaSet*) area_set;
+void* upload_location_history_information_in_areas(){
 	
 	while(ready_to_work == true){	
 
-		upload_time = get_clock_time();
+		hashtable_traverse_areas_to_upload_history_data(
+            &config.db_connection_list_head,
+			config.server_installation_path,
+            &history_work_queue,
+            config.number_of_rssi_signals_under_tracked);
 
-		if(upload_time - last_upload_time >= 
-           config.time_to_upload_history_location_in_sec){			
-			
-			hashtable_traverse_areas_to_upload_history_data(
-                &config.db_connection_list_head,
-				config.server_installation_path,
-                area_list,
-                config.number_of_rssi_signals_under_tracked);
-
-			last_upload_time = get_clock_time();			
-			
-		}else{
-			sleep_t(NORMAL_WAITING_TIME_IN_MS);
-		}
+		sleep_t(AREA_WORK_QUEUE_POLLING_TIME_IN_MS);
 	}
 }
+
+void* summarize_and_upload_urgent_location_in_areas(){
+
+    while(ready_to_work == true){
+
+        hashtable_traverse_areas_to_upload_urgent_location(
+            &config.db_connection_list_head,
+            config.server_installation_path,
+            config.rssi_threashold_for_summarize_location_pin,
+            config.number_of_rssi_signals_under_tracked,
+            config.unreasonable_rssi_change,
+            config.rssi_weight_multiplier,
+            config.rssi_difference_of_location_accuracy_tolerance,
+            config.base_location_tolerance_in_millimeter);
+
+        sleep_t(URGENT_SUMMARY_POLLING_TIME_IN_MS);
+    }
+}
@@ -53,6 +53,8 @@
 #include "SqlWrapper.h"
 #include "GeoFence.h"
 #include "HashTable.h"
+#include "LBeaconRegistry.h"
+#include "LocationEstimator.h"
 
 /* When debugging is needed */
 //#define debugging
@@ -98,6 +100,10 @@ memory pool. */
 /* The maximum number of threads for uploading history information */
 #define MAX_UPLOAD_HISTORY_TASK_THREADS 256
 
+/* The time interval in seconds between consecutive reports of the usage 
+statistics of all memory pools */
+#define PERIOD_BETWEEN_REPORT_MEMPOOL_STATISTICS_IN_SEC 60
+
 
 typedef struct {
     /* The length of the time window in which the movements of an object is 
@@ -190,15 +196,9 @@ typedef struct {
     /* The number of threads to do summarizing location information tasks */
     int number_summary_threads;
 
-    /* The number of areas for which each summary thread is responsible */
-    int number_areas_per_summary_thread;
-
     /* The number of threads to do uploading history information tasks */
     int number_upload_history_threads;
 
-    /* The number of areas for which each upload history thread is responsible*/
-    int number_areas_per_upload_history_thread;
-
     /* The RSSI threshold used to filter out tracking data from poor lbeacons*/
     int rssi_threashold_for_summarize_location_pin;
 
@@ -286,6 +286,20 @@ typedef struct {
     /* The SMS notification message template */
     char SMS_message_template[WIFI_MESSAGE_LENGTH];
 
+    /* The name of the location estimator used to summarize the location of
+    objects */
+    char location_estimator[LENGTH_OF_LOCATION_ESTIMATOR_NAME];
+
+    /* The list of area ids of time critical areas separated by semicolons.
+    Objects in these areas are summarized as soon as their closest lbeacon 
+    may have changed. */
+    char time_critical_area_id_list[WIFI_MESSAGE_LENGTH];
+
+    /* The list of pairs of area id and the length of time in seconds after 
+    which objects not located in the area are evicted, separated by 
+    semicolons. Other areas use TOLERANT_NOT_SCANNING_TIME_IN_SEC. */
+    char area_tolerant_not_scanning_time_list[WIFI_MESSAGE_LENGTH];
+
 } ServerConfig;
 
 /* A server config struct for storing config parameters from the config file */
@@ -309,11 +323,18 @@ BufferListHead Geo_fence_receive_buffer_list_head;
 /* The head of a list of command buffer nodes */
 BufferListHead command_buffer_list_head;
 
+/* The queues distributing the covered areas among the summary threads once 
+   every second, and among the upload history threads once every 
+   time_to_upload_history_location_in_sec */
+AreaWorkQueue summary_work_queue;
+AreaWorkQueue history_work_queue;
+
 /* Variables for storing the last polling times in seconds. Server keeps 
    comparing current MONOTONIC timestamp with these last polling times to 
    determine the timing of periodic polling requests. */
 int last_polling_LBeacon_for_HR_time;
 int last_polling_object_tracking_time;
+int last_report_mempool_statistics_time;
 
 /*
   get_server_config:
@@ -337,6 +358,25 @@ ErrorCode get_server_config(ServerConfig *config,
                             CommonConfig *common_config, 
                             char *file_name);
 
+/*
+  report_mempool_statistics:
+
+     This function writes the usage statistics of all memory pools used by the
+     server to the debug log. The statistics are used to size the number of 
+     slots of each memory pool.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     None
+
+ */
+
+void report_mempool_statistics();
+
 /*
   maintain_database:
 
@@ -647,12 +687,13 @@ ErrorCode add_notification_to_the_notification_list(
 
      This function invokes sub-function periodically to upload location 
      information to database table object_summary_table. BOT GUI uses 
-     information in this table to display location pin on web page.
+     information in this table to display location pin on web page. The 
+     areas are taken from summary_work_queue together with the other summary
+     threads.
 
   Parameters:
 
-     area_set - the list of areas in which the location information of objects 
-                should be summarized and uploaded
+     None
 
   Return value:
 
@@ -660,7 +701,7 @@ ErrorCode add_notification_to_the_notification_list(
 
  */
 
-void* summarize_and_upload_location_information_in_areas(void *area_set);
+void* summarize_and_upload_location_information_in_areas();
 
 
 /*
@@ -668,12 +709,33 @@ void* summarize_and_upload_location_information_in_areas(void *area_set);
 
      This function invokes sub-function periodically to upload location 
      history information to database table location_history_table. BOT GUI 
-     uses information in this table to display tracking path.
+     uses information in this table to display tracking path. The areas are
+     taken from history_work_queue together with the other upload history 
+     threads.
+
+  Parameters:
+
+     None
+
+  Return value:
+
+     None
+
+ */
+
+void* upload_location_history_information_in_areas();
+
+/*
+  summarize_and_upload_urgent_location_in_areas:
+
+     This function invokes sub-function periodically to summarize and upload
+     location information of the objects in time critical areas whose closest
+     lbeacon may have changed, without waiting for the next pass of the 
+     summary threads.
 
   Parameters:
 
-     area_set - the list of areas in which the location information of objects 
-                should be uploaded
+     None
 
   Return value:
 
@@ -681,6 +743,6 @@ void* summarize_and_upload_location_information_in_areas(void *area_set);
 
  */
 
-void* upload_location_history_information_in_areas(void *area_set);
+void* summarize_and_upload_urgent_location_in_areas();
 
 #endif
\ No newline at end of file
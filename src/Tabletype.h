@@ -46,6 +46,7 @@
 #define TABLETYPE_H
 
 #include "BeDIS.h"
+#include "LBeaconRegistry.h"
 
 /* Number of characters in the panic button information of tracking data */
 #define LENGTH_OF_PANIC_BUTTON 2
@@ -61,14 +62,28 @@ each object */
 object */
 #define MAX_NUMBER_OF_LBEACON_UNDER_TRACKING 32
 
+/* Number of records of lbeacons kept inside each hash_table_row. Most objects
+are scanned by only a few lbeacons at the same time, so the records of the 
+other lbeacons are kept in an overflow block allocated only when needed. */
+#define NUMBER_OF_INLINE_UUID_RECORDS 4
+
+/* Number of records of lbeacons in the overflow block of one hash_table_row */
+#define NUMBER_OF_OVERFLOW_UUID_RECORDS \
+    (MAX_NUMBER_OF_LBEACON_UNDER_TRACKING - NUMBER_OF_INLINE_UUID_RECORDS)
+
 
 /* Structure to store information parsed from tracking data sent by 
 lbeacon */
 typedef struct {
     
-   char lbeacon_uuid[LENGTH_OF_UUID];
-   char initial_timestamp_GMT[LENGTH_OF_EPOCH_TIME];
-   char final_timestamp_GMT[LENGTH_OF_EPOCH_TIME];
+   /* The id of the lbeacon in the lbeacon registry */
+   int lbeacon_id;
+
+   /* The first and the last time in epoch seconds at which the lbeacon 
+   scanned the object during the reported period */
+   int initial_timestamp_GMT;
+   int final_timestamp_GMT;
+
    char battery_voltage[LENGTH_OF_BATTERY_VOLTAGE];   
    int rssi;
    char panic_button[LENGTH_OF_PANIC_BUTTON];
@@ -79,56 +94,144 @@ typedef struct {
 information from one lbeacon against the specific mac_address */
 typedef struct {
 
-   char uuid[LENGTH_OF_UUID];
-   char initial_timestamp[LENGTH_OF_EPOCH_TIME];
-   /* The index indicating the index of rssi_array array which the new rssi 
-   signal should be inserted. */
-   int write_index; 
-   char final_timestamp[LENGTH_OF_EPOCH_TIME];
-   int rssi_array[MAX_NUMBER_OF_RSSI_SIGNAL_UNDER_TRACKING];
-   float coordinateX;
-   float coordinateY;
+   /* The id of the lbeacon in the lbeacon registry. The coordinates of the
+   lbeacon are kept in its registry entry. */
+   int lbeacon_id;
 
    /* A flag indicating whether this struct is occupied and used to record
    recently scanned data currently. If not, the system will reuse this 
    structure to record data from another lbeacon uuid. */
    bool is_in_use;
 
+   /* The index indicating the index of rssi_array array which the new rssi 
+   signal should be inserted. */
+   short write_index; 
+
+   /* The sum and the number of rssi signals in rssi_array which pass the 
+   filter of get_average_rssi. Both are updated whenever a signal is written,
+   so the average is read without walking the array. */
+   short valid_rssi_sum;
+   short valid_rssi_count;
+
+   /* The settings of the filter the sum and the number above were kept 
+   with. They are rebuilt by the next write when the settings change, and 
+   the average is computed from rssi_array until then. */
+   short sum_number_of_rssi_signals;
+   short sum_rssi_threshold;
+   short sum_unreasonable_rssi_change;
+
+   /* The first and the last time in epoch seconds at which this lbeacon
+   uuid scanned the object */
+   int initial_timestamp;
+   int final_timestamp;
+
    /* The last reported timestamp from this lbeacon uuid */
    int last_reported_timestamp;
 
+   /* The rssi signals in dBm. Valid rssi values always fit in one byte, 
+   which keeps the whole array in half a cache line. */
+   int8_t rssi_array[MAX_NUMBER_OF_RSSI_SIGNAL_UNDER_TRACKING];
+
 } uuid_record_table_row;
 
 /* Structure used as node in hashtable to store all recently tracking 
-information from all lbeacons against the specific mac_address */
+information from all lbeacons against the specific mac_address. The fields 
+read by every summary scan are placed first. */
 typedef struct {
 
-   char summary_uuid[LENGTH_OF_UUID];
-   char initial_timestamp[LENGTH_OF_EPOCH_TIME];
-   char final_timestamp[LENGTH_OF_EPOCH_TIME];
-   int average_rssi;
+   /* The MAC address of the object in binary form, i.e., the key of this row
+   in the hashtable */
+   uint64_t mac_address;
+
+   /* A flag indicating whether this row is occupied by an object. Rows not in
+   use are linked by next_free_row and reused for new objects. */
+   bool is_in_use;
+
+   int next_free_row;
 
     /* The last reported timestamp to this mac_address */
    int last_reported_timestamp;
 
-   char battery[LENGTH_OF_BATTERY_VOLTAGE];
-   char panic_button[LENGTH_OF_PANIC_BUTTON];  
-    
+   /* The time in epoch seconds at which a record used by the summarized 
+   location becomes stale, or 0 if no record is used. Until then the location
+   cannot change without new tracking data, so it is not summarized again and
+   is reported as confirmed at the current time. */
+   int location_expiry_timestamp;
+
+   /* The time in epoch seconds at which the row is to be summarized without
+   new tracking data, or 0 while the row is being summarized, and the time of
+   the entry of the row in the timeout wheel of the hashtable, or 0 if there
+   is none. The entry may be earlier than the row is due, and then it moves 
+   the row to a later slot when it comes. */
+   int timeout_timestamp;
+   int wheel_timestamp;
+
+   int average_rssi;
    float summary_coordinateX;
    float summary_coordinateY;  
 
-   /* Array of uuid_record_table_row to store the lbeacons recently scanning
-   this mac_address */
-   uuid_record_table_row 
-       uuid_record_table_array[MAX_NUMBER_OF_LBEACON_UNDER_TRACKING];
+   /* A flag indicating whether the row is in the list of urgent rows of the
+   hashtable of a time critical area */
+   bool is_urgent;
+
+   /* The number of records handed out to lbeacons so far, the inline records
+   first and then the records in the overflow block. Records at or beyond 
+   this index have never been used. */
+   int number_uuid_records;
+
+   /* A variable indicating the number of records of lbeacons will be used. 
+   The value of this variable is defined by server configuration file. */
+   int number_uuid_size;
+
+   /* The time in epoch seconds at which the object came under and was last
+   scanned by the lbeacon of summary_uuid. They are formatted only when the 
+   location is written to the database. */
+   int initial_timestamp;
+   int final_timestamp;
 
-   /* A variable indicating the number of elements in uuid_record_table_array 
-   will be used. The value of this variable is defined by server configuration
-   file. */
-   size_t number_uuid_size;
+   /* The id in the lbeacon registry of the lbeacon closest to the object, 
+   or LBEACON_ID_UNKNOWN */
+   int summary_lbeacon_id;
+
+   char battery[LENGTH_OF_BATTERY_VOLTAGE];
+   char panic_button[LENGTH_OF_PANIC_BUTTON];  
+
+   /* The records of the lbeacons recently scanning this mac_address */
+   uuid_record_table_row 
+       uuid_record_table_array[NUMBER_OF_INLINE_UUID_RECORDS];
+
+   /* The block of NUMBER_OF_OVERFLOW_UUID_RECORDS records used after the 
+   inline records run out, or NULL */
+   uuid_record_table_row * overflow_uuid_record_table_array;
+
+   /* The state kept by the location estimator between summary passes, i.e.,
+   the estimated location, its variance and the time of the estimate, or 0
+   if there is no estimate yet. It is written under node_lock only, outside
+   the updates of the fields placed before the records, so it is placed 
+   after them and is not copied by hashtable_get_row_summary. */
+   float estimated_coordinateX;
+   float estimated_coordinateY;
+   float estimate_variance;
+   int estimate_timestamp;
 
    pthread_mutex_t node_lock;
 
+   /* The sequence counter of the fields placed before the records. Writers
+   holding node_lock make it odd while they update those fields, and readers
+   not holding node_lock retry their copy when it is odd or has changed. It 
+   is kept when the row is reused. */
+   volatile unsigned int sequence;
+
+   /* The index of this row in the row storage */
+   int row_index;
+
 } hash_table_row;
 
+/* Returns the record of lbeacon at the input index of hash_table_row */
+#define get_uuid_record(table_row, index) \
+    ((index) < NUMBER_OF_INLINE_UUID_RECORDS ? \
+     &(table_row)->uuid_record_table_array[(index)] : \
+     &(table_row)->overflow_uuid_record_table_array \
+         [(index) - NUMBER_OF_INLINE_UUID_RECORDS])
+
 #endif
\ No newline at end of file